@@ -0,0 +1,60 @@
+#include "bench_common.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Serial versus batch compilation of distinct kernels. The worker pool is
+// sized by HIPRTC_NUM_THREADS, run with several values to get a scaling curve.
+std::vector<hiprtcProgram> create_programs(int count, int generation) {
+  std::vector<hiprtcProgram> progs(count);
+  for (int i = 0; i < count; i++) {
+    // Distinct sources, nothing is served from a cache
+    std::string source = "extern \"C\" __global__ void kernel(float *a) { "
+                         "a[threadIdx.x] += " +
+                         std::to_string(generation * count + i) + ".0f; }";
+    hiprtc_check(hiprtcCreateProgram(&progs[i], source.c_str(), nullptr, 0,
+                                     nullptr, nullptr));
+  }
+  return progs;
+}
+
+void destroy_programs(std::vector<hiprtcProgram> &progs) {
+  for (auto &prog : progs) {
+    hiprtc_check(hiprtcDestroyProgram(&prog));
+  }
+}
+
+int main(int argc, char **argv) {
+  int count = (argc > 1) ? std::atoi(argv[1]) : 64;
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+  hiprtc_check(hiprtcSetDiskCache(nullptr, 0));
+
+  // Warm up, builds the pch
+  compile_source("extern \"C\" __global__ void kernel() {}");
+
+  auto progs = create_programs(count, 0);
+  double serial_ms = time_ms([&] {
+    for (auto &prog : progs) {
+      hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+    }
+  });
+  destroy_programs(progs);
+
+  progs = create_programs(count, 1);
+  double batch_ms = time_ms([&] {
+    hiprtc_check(hiprtcCompileProgramsBatch(progs.data(), count, 0, nullptr,
+                                            nullptr));
+  });
+  destroy_programs(progs);
+
+  auto threads = std::getenv("HIPRTC_NUM_THREADS");
+  std::cout << "programs: " << count << ", threads: "
+            << (threads ? threads
+                        : std::to_string(std::thread::hardware_concurrency()))
+            << std::endl;
+  std::cout << "serial:   " << serial_ms << " ms" << std::endl;
+  std::cout << "batch:    " << batch_ms << " ms" << std::endl;
+  std::cout << "speedup:  " << serial_ms / batch_ms << "x" << std::endl;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// Milliseconds spent in func
+template <typename Func> double time_ms(Func &&func) {
+  auto start = std::chrono::steady_clock::now();
+  func();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Peak resident set size of the process so far in KiB, never decreases
+inline long peak_rss_kb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Resident set size of the process now in KiB, drops when memory is freed
+inline long current_rss_kb() {
+  long pages = 0, resident = 0;
+  std::ifstream statm("/proc/self/statm");
+  statm >> pages >> resident;
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Compile and destroy a program, aborts on failure
+inline void compile_source(const std::string &source, int num_options = 0,
+                           const char **options = nullptr) {
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(prog, num_options, options));
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+}
@@ -0,0 +1,71 @@
+#include "bench_common.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Resident memory held by live programs of one large source, borrowing
+// versus copying their code. Programs share the code object with the
+// in-memory cache, so borrowing holds it once however many programs there
+// are. Current RSS is sampled while the programs are alive, peak RSS would
+// hide memory given back between runs.
+std::string large_source(int kernels, int generation) {
+  std::string source;
+  for (int i = 0; i < kernels; i++) {
+    auto index = std::to_string(i);
+    source += "extern \"C\" __global__ void kernel" + index +
+              "(float *a) { a[threadIdx.x] = a[threadIdx.x] * " + index +
+              ".0f + " + std::to_string(generation) + ".0f; }\n";
+  }
+  return source;
+}
+
+template <typename Func>
+void run(const char *name, const std::string &source, int count,
+         Func &&get_code) {
+  long rss_before = current_rss_kb();
+  std::vector<hiprtcProgram> progs(count);
+  std::vector<std::vector<char>> copies;
+  size_t code_size = 0;
+  double ms = time_ms([&] {
+    for (auto &prog : progs) {
+      hiprtc_check(hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0,
+                                       nullptr, nullptr));
+      hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+      code_size = get_code(prog, copies);
+    }
+  });
+  long rss_growth = current_rss_kb() - rss_before;
+  for (auto &prog : progs) {
+    hiprtc_check(hiprtcDestroyProgram(&prog));
+  }
+  std::cout << name << ": " << ms << " ms, " << count << " programs, code "
+            << code_size / 1024 << " KiB, resident +" << rss_growth << " KiB"
+            << std::endl;
+}
+
+int main(int argc, char **argv) {
+  int kernels = (argc > 1) ? std::atoi(argv[1]) : 2000;
+  int count = (argc > 2) ? std::atoi(argv[2]) : 16;
+  hiprtc_check(hiprtcSetDiskCache(nullptr, 0));
+
+  // Warm up, builds the pch
+  compile_source("extern \"C\" __global__ void kernel() {}");
+
+  run("borrow", large_source(kernels, 0), count,
+      [](hiprtcProgram prog, std::vector<std::vector<char>> &) {
+        const void *code = nullptr;
+        size_t code_size = 0;
+        hiprtc_check(hiprtcGetCodePtr(prog, &code, &code_size));
+        return code_size;
+      });
+
+  run("copy  ", large_source(kernels, 1), count,
+      [](hiprtcProgram prog, std::vector<std::vector<char>> &copies) {
+        size_t code_size = 0;
+        hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+        auto &code = copies.emplace_back(code_size);
+        hiprtc_check(hiprtcGetCode(prog, code.data()));
+        return code_size;
+      });
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Kernels representative of runtime compiled HIP code, used by hiprtc_bench.
+// Only the built-in hiprtc header is available, no HIP runtime headers.
+struct corpus_kernel {
+  std::string name_;
+  std::string source_;
+  std::vector<std::pair<std::string, std::string>> headers_; // <name, source>
+  std::vector<std::string> name_expressions_;
+};
+
+inline std::string corpus_reduction() {
+  return R"(
+template <typename T> __device__ T warp_reduce(T value) {
+  for (int offset = warpSize / 2; offset > 0; offset /= 2) {
+    value += __shfl_down(value, offset);
+  }
+  return value;
+}
+
+extern "C" __global__ void reduce_sum(const float *in, float *out, int n) {
+  __shared__ float partial[32];
+  float value = 0;
+  for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < n;
+       i += blockDim.x * gridDim.x) {
+    value += in[i];
+  }
+  value = warp_reduce(value);
+  if (threadIdx.x % warpSize == 0) {
+    partial[threadIdx.x / warpSize] = value;
+  }
+  __syncthreads();
+  if (threadIdx.x < warpSize) {
+    value = (threadIdx.x < blockDim.x / warpSize) ? partial[threadIdx.x] : 0;
+    value = warp_reduce(value);
+    if (threadIdx.x == 0) {
+      atomicAdd(out, value);
+    }
+  }
+}
+)";
+}
+
+inline std::string corpus_gemm() {
+  return R"(
+template <typename T, int TILE_M, int TILE_N, int TILE_K>
+__global__ void gemm_tile(const T *a, const T *b, T *c, int m, int n, int k) {
+  __shared__ T tile_a[TILE_M][TILE_K];
+  __shared__ T tile_b[TILE_K][TILE_N];
+  int row = blockIdx.y * TILE_M + threadIdx.y;
+  int col = blockIdx.x * TILE_N + threadIdx.x;
+  T acc = 0;
+  for (int t = 0; t < k; t += TILE_K) {
+    for (int i = threadIdx.x; i < TILE_K; i += blockDim.x) {
+      tile_a[threadIdx.y][i] =
+          (row < m && t + i < k) ? a[row * k + t + i] : T(0);
+    }
+    for (int i = threadIdx.y; i < TILE_K; i += blockDim.y) {
+      tile_b[i][threadIdx.x] =
+          (col < n && t + i < k) ? b[(t + i) * n + col] : T(0);
+    }
+    __syncthreads();
+#pragma unroll
+    for (int i = 0; i < TILE_K; i++) {
+      acc += tile_a[threadIdx.y][i] * tile_b[i][threadIdx.x];
+    }
+    __syncthreads();
+  }
+  if (row < m && col < n) {
+    c[row * n + col] = acc;
+  }
+}
+)";
+}
+
+// Header with many small inline functions, as generated math libraries have
+inline std::string corpus_math_header(int functions) {
+  std::string header = "#pragma once\n";
+  for (int i = 0; i < functions; i++) {
+    auto n = std::to_string(i);
+    header += "__device__ inline float poly_" + n +
+              "(float x) { return ((x * " + n + ".5f + 1.0f) * x - " + n +
+              ".25f) * x + 0.5f; }\n";
+  }
+  return header;
+}
+
+inline std::string corpus_header_heavy() {
+  return R"(
+#include "math_lib.h"
+#include "params.h"
+
+extern "C" __global__ void evaluate(const float *x, float *y, int n) {
+  int i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i < n) {
+    y[i] = poly_0(x[i]) + poly_17(x[i]) * SCALE + poly_255(x[i]);
+  }
+}
+)";
+}
+
+inline std::string corpus_transpose() {
+  return R"(
+constexpr int TILE = 32;
+
+extern "C" __global__ void transpose(const float *in, float *out, int width,
+                                     int height) {
+  __shared__ float tile[TILE][TILE + 1];
+  int x = blockIdx.x * TILE + threadIdx.x;
+  int y = blockIdx.y * TILE + threadIdx.y;
+  for (int j = 0; j < TILE; j += blockDim.y) {
+    if (x < width && y + j < height) {
+      tile[threadIdx.y + j][threadIdx.x] = in[(y + j) * width + x];
+    }
+  }
+  __syncthreads();
+  x = blockIdx.y * TILE + threadIdx.x;
+  y = blockIdx.x * TILE + threadIdx.y;
+  for (int j = 0; j < TILE; j += blockDim.y) {
+    if (x < height && y + j < width) {
+      out[(y + j) * height + x] = tile[threadIdx.x][threadIdx.y + j];
+    }
+  }
+}
+)";
+}
+
+inline std::vector<corpus_kernel> get_corpus() {
+  return {
+      {"reduction", corpus_reduction(), {}, {}},
+      {"gemm_tile",
+       corpus_gemm(),
+       {},
+       {"gemm_tile<float, 16, 16, 16>", "gemm_tile<float, 32, 32, 8>",
+        "gemm_tile<double, 16, 16, 16>", "gemm_tile<int, 8, 8, 32>"}},
+      {"header_heavy",
+       corpus_header_heavy(),
+       {{"math_lib.h", corpus_math_header(256)},
+        {"params.h", "#pragma once\n#define SCALE 0.5f\n"}},
+       {}},
+      {"transpose", corpus_transpose(), {}, {}},
+  };
+}
@@ -0,0 +1,348 @@
+#include "bench_common.hpp"
+#include "corpus.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Compile latency suite over the kernel corpus, results are written as JSON.
+//
+//   hiprtc_bench [--iterations N] [--threads N] [--output file.json]
+//
+// cold:        caches off, every compile reaches comgr
+// warm:        served by the in-memory cache
+// names:       registration, lowering and lookup of name expressions
+// api:         per call cost of the query calls, nanoseconds
+// throughput:  programs per second compiled from 1 up to --threads threads
+// modules:     front end time of a trivial kernel per embedded header module
+//
+// Build with -DENABLE_MOCK_ROCM=ON to measure the library's own overhead on a
+// machine without ROCm, HIPRTC_MOCK_ACTION_US then simulates backend latency.
+
+struct bench_options {
+  int iterations_ = 5;
+  int threads_ = std::max(1u, std::thread::hardware_concurrency());
+  std::string output_;
+};
+
+hiprtcProgram create_program(const corpus_kernel &kernel,
+                             const std::string &suffix = "") {
+  auto source = kernel.source_ + suffix;
+  std::vector<const char *> header_sources, header_names;
+  for (auto &header : kernel.headers_) {
+    header_names.push_back(header.first.c_str());
+    header_sources.push_back(header.second.c_str());
+  }
+
+  hiprtcProgram prog;
+  hiprtc_check(hiprtcCreateProgram(
+      &prog, source.c_str(), kernel.name_.c_str(), int(header_sources.size()),
+      header_sources.data(), header_names.data()));
+  for (auto &name : kernel.name_expressions_) {
+    hiprtc_check(hiprtcAddNameExpression(prog, name.c_str()));
+  }
+  return prog;
+}
+
+hiprtcProgramStats get_stats(hiprtcProgram prog) {
+  hiprtcProgramStats stats{};
+  stats.struct_size = sizeof(stats);
+  hiprtc_check(hiprtcGetProgramStats(prog, &stats));
+  return stats;
+}
+
+struct timing {
+  double mean_ms_ = 0;
+  double min_ms_ = 0;
+  double max_ms_ = 0;
+};
+
+timing summarize(const std::vector<double> &samples) {
+  timing t;
+  t.min_ms_ = *std::min_element(samples.begin(), samples.end());
+  t.max_ms_ = *std::max_element(samples.begin(), samples.end());
+  for (auto sample : samples) {
+    t.mean_ms_ += sample / samples.size();
+  }
+  return t;
+}
+
+std::string json_timing(const timing &t) {
+  std::ostringstream out;
+  out << "\"mean_ms\": " << t.mean_ms_ << ", \"min_ms\": " << t.min_ms_
+      << ", \"max_ms\": " << t.max_ms_;
+  return out.str();
+}
+
+// Compile each kernel with caches off, phases come from the program stats
+std::string bench_cold(const bench_options &options) {
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+  std::ostringstream out;
+  out << "[";
+  auto corpus = get_corpus();
+  for (size_t k = 0; k < corpus.size(); k++) {
+    std::vector<double> samples;
+    hiprtcProgramStats phases{};
+    for (int i = 0; i < options.iterations_; i++) {
+      auto prog = create_program(corpus[k]);
+      samples.push_back(
+          time_ms([&] { hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr)); }));
+      auto stats = get_stats(prog);
+      phases.frontend_ms += stats.frontend_ms / options.iterations_;
+      phases.codegen_ms += stats.codegen_ms / options.iterations_;
+      phases.link_ms += stats.link_ms / options.iterations_;
+      phases.object_bytes = stats.object_bytes;
+      hiprtc_check(hiprtcDestroyProgram(&prog));
+    }
+    out << (k ? ",\n    " : "\n    ") << "{\"kernel\": \"" << corpus[k].name_
+        << "\", " << json_timing(summarize(samples))
+        << ", \"frontend_ms\": " << phases.frontend_ms
+        << ", \"codegen_ms\": " << phases.codegen_ms
+        << ", \"link_ms\": " << phases.link_ms
+        << ", \"object_bytes\": " << phases.object_bytes << "}";
+  }
+  out << "\n  ]";
+  return out.str();
+}
+
+// Compile each kernel once to fill the cache, then measure hits
+std::string bench_warm(const bench_options &options) {
+  hiprtc_check(hiprtcSetMemoryCacheLimit(size_t(256) << 20));
+  hiprtc_check(hiprtcFlushMemoryCache());
+  std::ostringstream out;
+  out << "[";
+  auto corpus = get_corpus();
+  for (size_t k = 0; k < corpus.size(); k++) {
+    std::vector<double> samples;
+    for (int i = 0; i <= options.iterations_; i++) {
+      auto prog = create_program(corpus[k]);
+      double ms =
+          time_ms([&] { hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr)); });
+      hiprtc_check(hiprtcDestroyProgram(&prog));
+      if (i != 0) {
+        samples.push_back(ms);
+      }
+    }
+    out << (k ? ",\n    " : "\n    ") << "{\"kernel\": \"" << corpus[k].name_
+        << "\", " << json_timing(summarize(samples)) << "}";
+  }
+  out << "\n  ]";
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+  return out.str();
+}
+
+std::string bench_names() {
+  std::ostringstream out;
+  out << "[";
+  bool first = true;
+  for (int count : {1, 100, 1000}) {
+    corpus_kernel kernel{"names", corpus_gemm(), {}, {}};
+    for (int i = 0; i < count; i++) {
+      kernel.name_expressions_.push_back("gemm_tile<float, 16, 16, " +
+                                         std::to_string(i + 1) + ">");
+    }
+    std::vector<const char *> name_ptrs;
+    for (auto &name : kernel.name_expressions_) {
+      name_ptrs.push_back(name.c_str());
+    }
+    auto names = std::move(kernel.name_expressions_);
+    kernel.name_expressions_.clear();
+
+    auto prog = create_program(kernel);
+    double add_ms = time_ms([&] {
+      hiprtc_check(hiprtcAddNameExpressions(prog, count, name_ptrs.data()));
+    });
+    double compile_ms =
+        time_ms([&] { hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr)); });
+    double lookup_ms = time_ms([&] {
+      for (auto &name : names) {
+        const char *lowered = nullptr;
+        hiprtc_check(hiprtcGetLoweredName(prog, name.c_str(), &lowered));
+      }
+    });
+    auto stats = get_stats(prog);
+    hiprtc_check(hiprtcDestroyProgram(&prog));
+
+    out << (first ? "\n    " : ",\n    ") << "{\"names\": " << count
+        << ", \"add_ms\": " << add_ms << ", \"compile_ms\": " << compile_ms
+        << ", \"lowering_ms\": " << stats.lowering_ms
+        << ", \"lookup_ms\": " << lookup_ms << "}";
+    first = false;
+  }
+  out << "\n  ]";
+  return out.str();
+}
+
+// Nanoseconds per call of func over calls iterations
+template <typename Func> double per_call_ns(int calls, Func &&func) {
+  return time_ms([&] {
+           for (int i = 0; i < calls; i++) {
+             func();
+           }
+         }) *
+         1e6 / calls;
+}
+
+std::string bench_api() {
+  const int calls = 10000;
+  auto corpus = get_corpus();
+  auto &kernel = corpus[1];
+  auto prog = create_program(kernel);
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  size_t code_size = 0;
+  hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+  std::vector<char> code(code_size);
+
+  std::ostringstream out;
+  out << "{\"create_destroy_ns\": " << per_call_ns(calls, [&] {
+    hiprtcProgram p;
+    hiprtc_check(hiprtcCreateProgram(&p, kernel.source_.c_str(), nullptr, 0,
+                                     nullptr, nullptr));
+    hiprtc_check(hiprtcDestroyProgram(&p));
+  }) << ", \"get_code_size_ns\": " << per_call_ns(calls, [&] {
+    hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+  }) << ", \"get_code_ns\": " << per_call_ns(calls, [&] {
+    hiprtc_check(hiprtcGetCode(prog, code.data()));
+  }) << ", \"get_code_ptr_ns\": " << per_call_ns(calls, [&] {
+    const void *ptr = nullptr;
+    hiprtc_check(hiprtcGetCodePtr(prog, &ptr, &code_size));
+  }) << ", \"get_lowered_name_ns\": " << per_call_ns(calls, [&] {
+    const char *lowered = nullptr;
+    hiprtc_check(hiprtcGetLoweredName(
+        prog, kernel.name_expressions_[0].c_str(), &lowered));
+  }) << ", \"get_program_stats_ns\": " << per_call_ns(calls, [&] {
+    (void)get_stats(prog);
+  }) << ", \"code_bytes\": " << code_size << "}";
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  return out.str();
+}
+
+// Trivial kernel parsed on core plus one module of the embedded header, the
+// first compile of a module also builds its precompiled header
+std::string bench_modules(const bench_options &options) {
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+  const char *modules[] = {"core",    "math", "half",
+                           "atomics", "warp", "cooperative_groups",
+                           "texture", "all"};
+  std::ostringstream out;
+  out << "[";
+  for (size_t m = 0; m < std::size(modules); m++) {
+    auto option = std::string("--hiprtc-modules=") + modules[m];
+    const char *compile_options[] = {option.c_str()};
+    double pch_ms = 0, frontend_ms = 0;
+    for (int i = 0; i <= options.iterations_; i++) {
+      auto source = "extern \"C\" __global__ void kernel(int *a) { *a = " +
+                    std::to_string(i) + "; }";
+      hiprtcProgram prog;
+      hiprtc_check(hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0,
+                                       nullptr, nullptr));
+      hiprtc_check(hiprtcCompileProgram(prog, 1, compile_options));
+      auto stats = get_stats(prog);
+      if (i == 0) {
+        pch_ms = stats.pch_ms;
+      } else {
+        frontend_ms += stats.frontend_ms / options.iterations_;
+      }
+      hiprtc_check(hiprtcDestroyProgram(&prog));
+    }
+    out << (m ? ",\n    " : "\n    ") << "{\"module\": \"" << modules[m]
+        << "\", \"pch_ms\": " << pch_ms << ", \"frontend_ms\": " << frontend_ms
+        << "}";
+  }
+  out << "\n  ]";
+  return out.str();
+}
+
+// Distinct programs compiled concurrently by 1, 2, 4 ... threads, caches off
+std::string bench_throughput(const bench_options &options) {
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+  auto corpus = get_corpus();
+  std::atomic<int> generation{0};
+
+  std::ostringstream out;
+  out << "[";
+  for (int threads = 1;; threads = std::min(threads * 2, options.threads_)) {
+    const int per_thread = std::max(options.iterations_, 2);
+    double ms = time_ms([&] {
+      std::vector<std::thread> workers;
+      for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+          for (int i = 0; i < per_thread; i++) {
+            auto &kernel = corpus[i % corpus.size()];
+            auto prog =
+                create_program(kernel, "\n// " + std::to_string(generation++));
+            hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+            hiprtc_check(hiprtcDestroyProgram(&prog));
+          }
+        });
+      }
+      for (auto &worker : workers) {
+        worker.join();
+      }
+    });
+    out << (threads == 1 ? "\n    " : ",\n    ") << "{\"threads\": " << threads
+        << ", \"programs\": " << threads * per_thread
+        << ", \"programs_per_s\": " << threads * per_thread * 1000.0 / ms
+        << "}";
+    if (threads == options.threads_) {
+      break;
+    }
+  }
+  out << "\n  ]";
+  return out.str();
+}
+
+int main(int argc, char **argv) {
+  bench_options options;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--iterations") == 0) {
+      options.iterations_ = std::max(1, std::atoi(argv[i + 1]));
+    } else if (std::strcmp(argv[i], "--threads") == 0) {
+      options.threads_ = std::max(1, std::atoi(argv[i + 1]));
+    } else if (std::strcmp(argv[i], "--output") == 0) {
+      options.output_ = argv[i + 1];
+    } else {
+      std::cerr << "Unknown option: " << argv[i] << std::endl;
+      return 1;
+    }
+  }
+
+  hiprtc_check(hiprtcSetDiskCache(nullptr, 0));
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+
+  // First compile builds the pch and detects the device
+  double first_ms = time_ms([] { compile_source(corpus_reduction()); });
+
+  int major = 0, minor = 0;
+  hiprtc_check(hiprtcVersion(&major, &minor));
+
+  std::ostringstream json;
+  json << "{\n  \"version\": \"" << major << "." << minor << "\",\n"
+#ifdef HIPRTC_BENCH_MOCK
+       << "  \"backend\": \"mock\",\n"
+#else
+       << "  \"backend\": \"comgr\",\n"
+#endif
+       << "  \"iterations\": " << options.iterations_ << ",\n"
+       << "  \"first_compile_ms\": " << first_ms << ",\n"
+       << "  \"cold\": " << bench_cold(options) << ",\n"
+       << "  \"warm\": " << bench_warm(options) << ",\n"
+       << "  \"names\": " << bench_names() << ",\n"
+       << "  \"api\": " << bench_api() << ",\n"
+       << "  \"throughput\": " << bench_throughput(options) << ",\n"
+       << "  \"modules\": " << bench_modules(options) << ",\n"
+       << "  \"peak_rss_kb\": " << peak_rss_kb() << "\n}\n";
+
+  if (options.output_.empty()) {
+    std::cout << json.str();
+  } else {
+    std::ofstream(options.output_) << json.str();
+  }
+}
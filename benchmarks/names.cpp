@@ -0,0 +1,48 @@
+#include "bench_common.hpp"
+
+#include <string>
+#include <vector>
+
+// Registration and lowering of 1, 100 and 10000 template instantiations.
+// Compile time includes generating the instantiation code and lowering.
+int main() {
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+  hiprtc_check(hiprtcSetDiskCache(nullptr, 0));
+
+  // Warm up, builds the pch
+  compile_source("extern \"C\" __global__ void kernel() {}");
+
+  for (int count : {1, 100, 10000}) {
+    std::string source = "template <int N> __global__ void kernel(int *a) { "
+                         "*a = N; }\n// " +
+                         std::to_string(count);
+    std::vector<std::string> names;
+    for (int i = 0; i < count; i++) {
+      names.push_back("kernel<" + std::to_string(i) + ">");
+    }
+    std::vector<const char *> name_ptrs;
+    for (auto &name : names) {
+      name_ptrs.push_back(name.c_str());
+    }
+
+    hiprtcProgram prog;
+    hiprtc_check(hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0,
+                                     nullptr, nullptr));
+    double add_ms = time_ms([&] {
+      hiprtc_check(hiprtcAddNameExpressions(prog, count, name_ptrs.data()));
+    });
+    double compile_ms =
+        time_ms([&] { hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr)); });
+    double lookup_ms = time_ms([&] {
+      for (auto &name : names) {
+        const char *lowered = nullptr;
+        hiprtc_check(hiprtcGetLoweredName(prog, name.c_str(), &lowered));
+      }
+    });
+    hiprtc_check(hiprtcDestroyProgram(&prog));
+
+    std::cout << count << " names: add " << add_ms << " ms, compile "
+              << compile_ms << " ms, lookup " << lookup_ms << " ms"
+              << std::endl;
+  }
+}
@@ -0,0 +1,37 @@
+#include "bench_common.hpp"
+
+#include <cstdlib>
+#include <string>
+
+// Average time of a small compile with and without the precompiled internal
+// header. Code object caches are off so that every compile reaches comgr.
+double average_compile_ms(int iterations) {
+  std::string source =
+      "extern \"C\" __global__ void kernel(int *a) { *a = 10; }";
+
+  // First compile builds the pch, not part of steady state
+  compile_source(source);
+
+  double total = 0;
+  for (int i = 0; i < iterations; i++) {
+    total += time_ms([&] { compile_source(source); });
+  }
+  return total / iterations;
+}
+
+int main(int argc, char **argv) {
+  int iterations = (argc > 1) ? std::atoi(argv[1]) : 10;
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+  hiprtc_check(hiprtcSetDiskCache(nullptr, 0));
+
+  setenv("HIPRTC_DISABLE_PCH", "1", 1);
+  double raw_ms = average_compile_ms(iterations);
+
+  unsetenv("HIPRTC_DISABLE_PCH");
+  double pch_ms = average_compile_ms(iterations);
+
+  std::cout << "raw header: " << raw_ms << " ms/compile" << std::endl;
+  std::cout << "pch:        " << pch_ms << " ms/compile" << std::endl;
+  std::cout << "saved:      " << raw_ms - pch_ms << " ms/compile ("
+            << 100.0 * (raw_ms - pch_ms) / raw_ms << "%)" << std::endl;
+}
@@ -28,6 +28,9 @@ typedef enum hiprtc_result_e {
       9, ///< No lowered names before compilation
   HIPRTC_ERROR_NAME_EXPRESSION_NOT_VALID = 10, ///< Invalid name expression
   HIPRTC_ERROR_INTERNAL_ERROR = 11,            ///< Internal error
+  HIPRTC_ERROR_NOT_READY = 12,  ///< Asynchronous compilation still running
+  HIPRTC_ERROR_CANCELLED = 13,  ///< Asynchronous compilation was cancelled
+  HIPRTC_ERROR_LINKING = 14,    ///< Link error
 } hiprtcResult;
 
 /**
@@ -50,6 +53,10 @@ hiprtcResult hiprtcVersion(int *major, int *minor);
 /**
  * @brief Opaque handle of hiprtc program
  *
+ * Distinct programs can be created, compiled and destroyed concurrently from
+ * any thread. Calls on one program are not synchronized against each other,
+ * except for hiprtcQueryProgram, hiprtcWaitProgram and hiprtcCancelCompile
+ * while an asynchronous compilation of it runs.
  */
 typedef void *hiprtcProgram;
 
@@ -69,9 +76,70 @@ hiprtcResult hiprtcCreateProgram(hiprtcProgram *prog, const char *src,
                                  const char **headers,
                                  const char **include_names);
 
+/**
+ * @brief Create a program on caller memory without copying it
+ *
+ * Source and headers are read in place, the caller keeps them alive and
+ * unchanged until the program is destroyed. Headers are null terminated like
+ * in hiprtcCreateProgram.
+ *
+ * @param prog output program
+ * @param src source code, need not be null terminated
+ * @param src_size size of src
+ * @param name name to be used
+ * @param num_headers number of headers
+ * @param headers header pointers
+ * @param include_names
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcCreateProgramBorrowed(hiprtcProgram *prog, const char *src,
+                                         size_t src_size, const char *name,
+                                         int num_headers, const char **headers,
+                                         const char **include_names);
+
+/**
+ * @brief Create a program from a source file
+ *
+ * Files of 64 KiB and more are mapped read only instead of being read into
+ * memory, smaller ones are copied. A mapped file should not be modified until
+ * the program is destroyed, truncating it makes the next read of the source
+ * raise SIGBUS in the calling process.
+ *
+ * @param prog output program
+ * @param path path of the source file
+ * @param name name to be used, defaults to the file name
+ * @param num_headers number of headers
+ * @param headers header pointers
+ * @param include_names
+ * @return hiprtcResult HIPRTC_ERROR_INVALID_INPUT if the file can not be
+ * mapped
+ */
+hiprtcResult hiprtcCreateProgramFromFile(hiprtcProgram *prog, const char *path,
+                                         const char *name, int num_headers,
+                                         const char **headers,
+                                         const char **include_names);
+
+/**
+ * @brief Append a chunk to the source of a program before compilation
+ *
+ * Lets a code generator stream its output without first building the whole
+ * source. Only for programs created with hiprtcCreateProgram.
+ *
+ * @param prog
+ * @param chunk text to append, need not be null terminated
+ * @param chunk_size size of chunk
+ * @return hiprtcResult HIPRTC_ERROR_INVALID_INPUT for a borrowed source, one
+ * from hiprtcCreateProgramFromFile or a compiled program
+ */
+hiprtcResult hiprtcAppendProgramSource(hiprtcProgram prog, const char *chunk,
+                                       size_t chunk_size);
+
 /**
  * @brief Destroy the hiprtcProgram
  *
+ * An asynchronous compilation in flight is cancelled. Waits for it and for
+ * its callback to return, unless called from the callback.
+ *
  * @param prog
  * @return hiprtcResult
  */
@@ -80,14 +148,108 @@ hiprtcResult hiprtcDestroyProgram(hiprtcProgram *prog);
 /**
  * @brief Compile the hiprtcProgram with options
  *
+ * Options are checked before any compilation starts and reduced to a
+ * canonical form: for -O, -std, -g, -f and -m the last one given wins, -D
+ * and -U are ordered by macro name and repeats are dropped.
+ *
+ * A compiled program can be compiled again with other options, e.g. to try
+ * variants of a kernel. The program keeps the result of every variant:
+ * repeating one is free, one changing only code generation options such as
+ * -O1 or -mllvm reuses the front end output.
+ *
  * @param prog Input Program
  * @param num_opts Number of options
  * @param options Options
- * @return hiprtcResult
+ * @return hiprtcResult HIPRTC_ERROR_INVALID_OPTION for an unknown option or
+ * one missing its value, the log names it
  */
 hiprtcResult hiprtcCompileProgram(hiprtcProgram prog, int num_opts,
                                   const char **options);
 
+/**
+ * @brief Compile several programs in parallel with the same options
+ *
+ * Programs are compiled on an internal pool of worker threads, sized to
+ * HIPRTC_NUM_THREADS or the number of cores. Each program gets its own state
+ * and log as if compiled by hiprtcCompileProgram. A program may appear only
+ * once in the batch.
+ *
+ * @param progs Input Programs
+ * @param num_progs Number of programs
+ * @param num_opts Number of options
+ * @param options Options
+ * @param results Optional output, result of each program
+ * @return hiprtcResult HIPRTC_SUCCESS if all programs compiled, else the
+ * first failure in program order
+ */
+hiprtcResult hiprtcCompileProgramsBatch(hiprtcProgram *progs, int num_progs,
+                                        int num_opts, const char **options,
+                                        hiprtcResult *results);
+
+/**
+ * @brief Callback invoked once an asynchronous compilation is over
+ *
+ * Runs exactly once per asynchronous compilation, on a worker thread, or on
+ * the cancelling thread if the compilation was dropped before it started. The
+ * result is published before the callback runs, hiprtcQueryProgram may see
+ * it while the callback is still running. hiprtcWaitProgram and
+ * hiprtcDestroyProgram from other threads wait for the callback to return.
+ * The program may be queried, used or destroyed from the callback.
+ *
+ */
+typedef void (*hiprtcCompileCallback)(hiprtcProgram prog, hiprtcResult result,
+                                      void *user_data);
+
+/**
+ * @brief Compile the hiprtcProgram on a worker thread
+ *
+ * Returns once the compilation is queued. Until it is over, only
+ * hiprtcQueryProgram, hiprtcWaitProgram, hiprtcCancelCompile and
+ * hiprtcDestroyProgram may be called on the program.
+ *
+ * @param prog Input Program
+ * @param num_opts Number of options
+ * @param options Options, copied before returning
+ * @param callback Optional callback run when the compilation is over
+ * @param user_data Passed to callback
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcCompileProgramAsync(hiprtcProgram prog, int num_opts,
+                                       const char **options,
+                                       hiprtcCompileCallback callback,
+                                       void *user_data);
+
+/**
+ * @brief Poll a compilation of the program
+ *
+ * @param prog
+ * @return hiprtcResult HIPRTC_ERROR_NOT_READY while queued or compiling, else
+ * result of the last compilation
+ */
+hiprtcResult hiprtcQueryProgram(hiprtcProgram prog);
+
+/**
+ * @brief Block until an asynchronous compilation of the program is over
+ *
+ * Also waits for its callback to return, unless called from the callback.
+ *
+ * @param prog
+ * @return hiprtcResult result of the last compilation
+ */
+hiprtcResult hiprtcWaitProgram(hiprtcProgram prog);
+
+/**
+ * @brief Cancel an asynchronous compilation
+ *
+ * A queued compilation is dropped, a running one completes but its output is
+ * discarded. Either way the result is HIPRTC_ERROR_CANCELLED and the program
+ * goes back to the created state, so it can be compiled again.
+ *
+ * @param prog
+ * @return hiprtcResult HIPRTC_ERROR_INVALID_INPUT if nothing is in flight
+ */
+hiprtcResult hiprtcCancelCompile(hiprtcProgram prog);
+
 /**
  * @brief Get program log size
  *
@@ -118,12 +280,107 @@ hiprtcResult hiprtcGetCodeSize(hiprtcProgram prog, size_t *binary_size);
 /**
  * @brief Get code to be loaded by hipModuleLoad
  *
+ * An offload bundle holding a code object per target when the program was
+ * compiled for several targets.
+ *
  * @param prog
  * @param binary
  * @return hiprtcResult
  */
 hiprtcResult hiprtcGetCode(hiprtcProgram prog, char *binary);
 
+/**
+ * @brief Borrow the code of the program without a copy
+ *
+ * Same bytes as hiprtcGetCode. The pointer stays valid until the program is
+ * compiled again or destroyed, unless a code allocator is set in which case
+ * the memory belongs to the caller.
+ *
+ * @param prog
+ * @param code output pointer to the code
+ * @param code_size output size of the code
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcGetCodePtr(hiprtcProgram prog, const void **code,
+                              size_t *code_size);
+
+/**
+ * @brief Allocator of caller owned memory for the code of a program
+ *
+ * Called once per successful compilation with the size of the code, from the
+ * thread running the compilation. Returning nullptr fails the compilation.
+ * It must not call hiprtc functions on the program being compiled.
+ *
+ */
+typedef void *(*hiprtcCodeAllocator)(size_t size, void *user_data);
+
+/**
+ * @brief Have following compilations place the code in caller memory
+ *
+ * The code is written once into memory from allocator, e.g. pinned or device
+ * visible memory, and hiprtcGetCodePtr returns it. The caller frees it.
+ * Cancelled compilations do not call the allocator.
+ *
+ * @param prog
+ * @param allocator allocator, nullptr to go back to program owned code
+ * @param user_data passed to allocator
+ * @return hiprtcResult HIPRTC_ERROR_NOT_READY while compiling asynchronously
+ */
+hiprtcResult hiprtcSetCodeAllocator(hiprtcProgram prog,
+                                    hiprtcCodeAllocator allocator,
+                                    void *user_data);
+
+/**
+ * @brief Get size of the LLVM bitcode of the program
+ *
+ * Bitcode is the front end output with device libraries linked in, before
+ * optimization. Only available when the program was compiled for a single
+ * target. The on-disk cache stores bitcode apart from code objects, a code
+ * object served from it after its bitcode was evicted comes without.
+ *
+ * @param prog
+ * @param bitcode_size
+ * @return hiprtcResult HIPRTC_ERROR_INVALID_INPUT if compiled for several
+ * targets or the bitcode was evicted from the on-disk cache
+ */
+hiprtcResult hiprtcGetBitcodeSize(hiprtcProgram prog, size_t *bitcode_size);
+
+/**
+ * @brief Get LLVM bitcode of the program
+ *
+ * @param prog
+ * @param bitcode
+ * @return hiprtcResult HIPRTC_ERROR_INVALID_INPUT when hiprtcGetBitcodeSize
+ * would fail
+ */
+hiprtcResult hiprtcGetBitcode(hiprtcProgram prog, char *bitcode);
+
+/**
+ * @brief Get code size of one target of the program
+ *
+ * A program compiled for several targets, e.g. with --offload-arch=gfx90a
+ * --offload-arch=gfx1100, has an offload bundle as its code. This returns the
+ * code object of one of them.
+ *
+ * @param prog
+ * @param target target id as passed at compile time, e.g. gfx90a
+ * @param binary_size
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcGetTargetCodeSize(hiprtcProgram prog, const char *target,
+                                     size_t *binary_size);
+
+/**
+ * @brief Get code object of one target of the program
+ *
+ * @param prog
+ * @param target target id as passed at compile time, e.g. gfx90a
+ * @param binary
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcGetTargetCode(hiprtcProgram prog, const char *target,
+                                 char *binary);
+
 /**
  * @brief add name expression to be tracked
  *
@@ -134,6 +391,20 @@ hiprtcResult hiprtcGetCode(hiprtcProgram prog, char *binary);
 hiprtcResult hiprtcAddNameExpression(hiprtcProgram prog,
                                      const char *name_expression);
 
+/**
+ * @brief add many name expressions to be tracked at once
+ *
+ * Same as calling hiprtcAddNameExpression for each, duplicates are tracked
+ * once. Meant for programs with thousands of template instantiations.
+ *
+ * @param prog
+ * @param num_names number of name expressions
+ * @param name_expressions
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcAddNameExpressions(hiprtcProgram prog, int num_names,
+                                      const char **name_expressions);
+
 /**
  * @brief Get lowered name of expression
  *
@@ -146,6 +417,418 @@ hiprtcResult hiprtcGetLoweredName(hiprtcProgram prog,
                                   const char *name_expression,
                                   const char **lowered_name);
 
+/**
+ * @brief Declare the template parameters a kernel is specialized over
+ *
+ * For template <int TILE, typename T> __global__ void gemm(T *) declare
+ * "gemm" with {"TILE", "T"}, then hiprtcSpecializeKernel compiles it for
+ * values of them. Declaring a kernel again replaces its parameters.
+ *
+ * @param prog
+ * @param kernel name of the kernel template, may be qualified
+ * @param num_params number of template parameters
+ * @param params names of the parameters, used in the log
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcAddSpecializationParameters(hiprtcProgram prog,
+                                               const char *kernel,
+                                               int num_params,
+                                               const char **params);
+
+/**
+ * @brief Compile a kernel template for values of its parameters
+ *
+ * Instantiates e.g. gemm<64, float> for values {"64", "float"} and compiles
+ * it on its own, the program itself needs not be compiled and is left as is.
+ * Results are kept in the program by values and options, asking again, also
+ * with the options reordered or repeated, returns them without compiling.
+ * Appending source or adding headers drops them.
+ *
+ * @param prog
+ * @param kernel kernel declared by hiprtcAddSpecializationParameters
+ * @param num_values number of values, one per parameter
+ * @param values template arguments as written in C++
+ * @param num_options number of compile options
+ * @param options compile options
+ * @param lowered_name output, mangled name of the instantiation
+ * @param code output, code holding the instantiation, owned by the program
+ * @param code_size output, size of code
+ * @return hiprtcResult HIPRTC_ERROR_INVALID_INPUT if the kernel is not
+ * declared or the number of values is wrong, the result of compiling
+ * otherwise, with the log in the program
+ */
+hiprtcResult hiprtcSpecializeKernel(hiprtcProgram prog, const char *kernel,
+                                    int num_values, const char **values,
+                                    int num_options, const char **options,
+                                    const char **lowered_name,
+                                    const void **code, size_t *code_size);
+
+/**
+ * @brief Counters of the on-disk code object cache
+ *
+ */
+typedef struct hiprtc_disk_cache_stats_s {
+  size_t hits;      ///< Compilations served from the cache
+  size_t misses;    ///< Compilations not found in the cache
+  size_t stores;    ///< Code objects written to the cache
+  size_t evictions; ///< Entries removed to stay under the size limit
+} hiprtcDiskCacheStats;
+
+/**
+ * @brief Set directory of the on-disk code object cache
+ *
+ * The cache is off by default, it is enabled by this call or by setting
+ * HIPRTC_CACHE_DIR (and optionally HIPRTC_CACHE_MAX_SIZE, e.g. 512M). The
+ * directory can be shared by several processes. Least recently used entries
+ * are evicted once the size limit is crossed.
+ *
+ * @param path cache directory, created if missing, nullptr disables the cache
+ * @param max_size size limit in bytes, 0 for the default of 1 GiB
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcSetDiskCache(const char *path, size_t max_size);
+
+/**
+ * @brief Get counters of the on-disk code object cache
+ *
+ * @param stats
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcGetDiskCacheStats(hiprtcDiskCacheStats *stats);
+
+/**
+ * @brief Counters and occupancy of the in-memory code object cache
+ *
+ */
+typedef struct hiprtc_memory_cache_stats_s {
+  size_t hits;      ///< Compilations served from the cache
+  size_t misses;    ///< Compilations not found in the cache
+  size_t evictions; ///< Entries removed to stay under the budget
+  size_t entries;   ///< Entries currently held
+  size_t size;      ///< Bytes currently held
+  size_t limit;     ///< Byte budget
+} hiprtcMemoryCacheStats;
+
+/**
+ * @brief Set byte budget of the in-memory code object cache
+ *
+ * Compiled programs are shared by all program handles of the process. The
+ * budget defaults to HIPRTC_MEMORY_CACHE_SIZE or 128 MiB, least recently used
+ * entries are evicted once it is crossed.
+ *
+ * @param max_size budget in bytes, 0 disables the cache
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcSetMemoryCacheLimit(size_t max_size);
+
+/**
+ * @brief Get counters of the in-memory code object cache
+ *
+ * @param stats
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcGetMemoryCacheStats(hiprtcMemoryCacheStats *stats);
+
+/**
+ * @brief Drop all entries of the in-memory code object cache
+ *
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcFlushMemoryCache();
+
+/**
+ * @brief Opaque handle of hiprtc link state
+ *
+ */
+typedef void *hiprtcLinkState;
+
+/**
+ * @brief Kind of a link input
+ *
+ */
+typedef enum hiprtc_link_input_e {
+  HIPRTC_LINK_INPUT_RELOCATABLE = 0, ///< Relocatable code object, e.g. from
+                                     ///< hiprtcGetCode with -fgpu-rdc
+  HIPRTC_LINK_INPUT_BITCODE = 1,     ///< LLVM bitcode, e.g. from
+                                     ///< hiprtcGetBitcode
+} hiprtcLinkInputType;
+
+/**
+ * @brief Create a link state to combine precompiled code
+ *
+ * A library compiled once with -fgpu-rdc can be linked with every small
+ * program that uses it instead of being recompiled from source each time.
+ * Options take --offload-arch=<target> like hiprtcCompileProgram, a single
+ * target only, plus code generation options such as -O or -mllvm.
+ *
+ * @param state output link state
+ * @param num_options number of options
+ * @param options options
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcLinkCreate(hiprtcLinkState *state, int num_options,
+                              const char **options);
+
+/**
+ * @brief Add an input from memory
+ *
+ * @param state
+ * @param type kind of input
+ * @param data input, copied
+ * @param size size of data
+ * @param name name used in the log, can be nullptr
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcLinkAddData(hiprtcLinkState state, hiprtcLinkInputType type,
+                               const void *data, size_t size,
+                               const char *name);
+
+/**
+ * @brief Add an input from a file
+ *
+ * @param state
+ * @param type kind of input
+ * @param path path of the file
+ * @return hiprtcResult HIPRTC_ERROR_INVALID_INPUT if the file can not be read
+ */
+hiprtcResult hiprtcLinkAddFile(hiprtcLinkState state, hiprtcLinkInputType type,
+                               const char *path);
+
+/**
+ * @brief Link all inputs
+ *
+ * Bitcode inputs are linked and optimized together, then linked with the
+ * relocatable inputs into a code object to be loaded by hipModuleLoadData.
+ *
+ * @param state
+ * @param code output code object, owned by the link state
+ * @param code_size size of code
+ * @return hiprtcResult HIPRTC_ERROR_LINKING on failure, see hiprtcGetLinkLog
+ */
+hiprtcResult hiprtcLinkComplete(hiprtcLinkState state, void **code,
+                                size_t *code_size);
+
+/**
+ * @brief Get log size of the link
+ *
+ * @param state
+ * @param log_size
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcGetLinkLogSize(hiprtcLinkState state, size_t *log_size);
+
+/**
+ * @brief Get log of the link
+ *
+ * @param state
+ * @param log
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcGetLinkLog(hiprtcLinkState state, char *log);
+
+/**
+ * @brief Destroy a link state and the code object it owns
+ *
+ * @param state
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcLinkDestroy(hiprtcLinkState *state);
+
+/**
+ * @brief Time and bytes spent in each phase of the last compilation
+ *
+ * Versioned by struct_size, which the caller sets to sizeof(hiprtcProgramStats)
+ * before the query. Fields are only ever appended, a caller built against an
+ * older header gets the prefix it knows about. Phases of targets compiled in
+ * parallel add up, so they can exceed total_ms.
+ */
+typedef struct hiprtc_program_stats_s {
+  size_t struct_size;        ///< Set by the caller
+  double total_ms;           ///< Wall time of the compilation
+  double target_ms;          ///< Target resolution, includes device detection
+  double cache_ms;           ///< Cache lookups and stores
+  double pch_ms;             ///< Getting or building the precompiled header
+  double dataset_ms;         ///< Preparing comgr inputs
+  double frontend_ms;        ///< Source to bitcode
+  double codegen_ms;         ///< Bitcode to relocatable
+  double link_ms;            ///< Relocatable to executable
+  double extract_ms;         ///< Copying outputs out of comgr
+  double lowering_ms;        ///< Lowering name expressions
+  double bundle_ms;          ///< Offload bundle of several targets
+  size_t source_bytes;       ///< Source, with name expression code
+  size_t header_bytes;       ///< Headers given to the program
+  size_t bitcode_bytes;      ///< Bitcode of all targets
+  size_t object_bytes;       ///< Code returned by hiprtcGetCode
+  size_t cache_hits;         ///< Targets served from the code object cache
+  size_t bitcode_cache_hits; ///< Targets that skipped the front end
+  size_t pch_hits; ///< Front ends on a precompiled header built before
+} hiprtcProgramStats;
+
+/**
+ * @brief Get phase timings and byte counts of the last compilation
+ *
+ * Collected on every compile, the query only copies them. Pass -ftime-report
+ * or -ftime-trace to get clang's own breakdown in the program log, such
+ * compilations bypass the caches.
+ *
+ * @param prog
+ * @param stats struct_size has to be set
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcGetProgramStats(hiprtcProgram prog,
+                                   hiprtcProgramStats *stats);
+
+/**
+ * @brief Argument of a kernel in its kernarg segment
+ *
+ */
+typedef struct hiprtc_kernel_arg_s {
+  const char *name;       ///< Name in the source, empty for hidden arguments
+  const char *value_kind; ///< e.g. global_buffer, hidden_block_count_x
+  size_t offset;          ///< Offset in the kernarg segment
+  size_t size;            ///< Size in bytes
+} hiprtcKernelArg;
+
+/**
+ * @brief Resource usage of a kernel, read from the code object metadata
+ *
+ * Versioned by struct_size like hiprtcProgramStats. Strings and args belong
+ * to the program and stay valid until it is compiled again or destroyed.
+ */
+typedef struct hiprtc_kernel_info_s {
+  size_t struct_size;             ///< Set by the caller
+  const char *name;               ///< Kernel name, mangled unless extern "C"
+  const char *symbol;             ///< Kernel descriptor symbol
+  size_t vgpr_count;              ///< Vector registers per work item, with
+                                  ///< the AGPRs on gfx90a, gfx94x, gfx950
+  size_t sgpr_count;              ///< Scalar registers per wavefront
+  size_t agpr_count;              ///< Accumulation registers per work item
+  size_t vgpr_spill_count;        ///< Vector registers spilled to scratch
+  size_t sgpr_spill_count;        ///< Scalar registers spilled
+  size_t lds_size;                ///< Static LDS per workgroup in bytes
+  size_t scratch_size;            ///< Scratch per work item in bytes
+  size_t max_flat_workgroup_size; ///< Largest workgroup it can launch with
+  size_t wavefront_size;          ///< 32 or 64
+  size_t kernarg_size;            ///< Size of the kernarg segment
+  size_t kernarg_align;           ///< Alignment of the kernarg segment
+  size_t num_args;                ///< Number of entries of args
+  const hiprtcKernelArg *args;    ///< Arguments in kernarg order, hidden
+                                  ///< ones included
+} hiprtcKernelInfo;
+
+/**
+ * @brief Get resource usage of a compiled kernel
+ *
+ * Parsed from the AMDGPU metadata note of the code object, no device or HIP
+ * runtime is needed, so it can be used on machines without a GPU.
+ *
+ * @param prog compiled program
+ * @param target target id the program was compiled for, may be nullptr if
+ * it was compiled for a single target
+ * @param kernel kernel name, e.g. from hiprtcGetLoweredName
+ * @param info struct_size has to be set
+ * @return hiprtcResult HIPRTC_ERROR_INVALID_INPUT if the program has no such
+ * target or kernel, HIPRTC_ERROR_INTERNAL_ERROR if the code object has no
+ * readable metadata
+ */
+hiprtcResult hiprtcGetKernelInfo(hiprtcProgram prog, const char *target,
+                                 const char *kernel, hiprtcKernelInfo *info);
+
+/**
+ * @brief Resource bounding the occupancy of a kernel
+ *
+ */
+typedef enum hiprtc_occupancy_limit_e {
+  HIPRTC_OCCUPANCY_LIMIT_WAVES = 0,      ///< Wave slots of a SIMD
+  HIPRTC_OCCUPANCY_LIMIT_VGPRS = 1,      ///< Vector registers, AGPRs included
+  HIPRTC_OCCUPANCY_LIMIT_SGPRS = 2,      ///< Scalar registers
+  HIPRTC_OCCUPANCY_LIMIT_LDS = 3,        ///< LDS of a compute unit
+  HIPRTC_OCCUPANCY_LIMIT_WORKGROUPS = 4, ///< Workgroups of a compute unit
+} hiprtcOccupancyLimit;
+
+/**
+ * @brief Estimated occupancy of a kernel
+ *
+ * Versioned by struct_size like hiprtcProgramStats.
+ */
+typedef struct hiprtc_occupancy_s {
+  size_t struct_size;              ///< Set by the caller
+  double waves_per_simd;           ///< Resident waves per SIMD
+  size_t max_waves_per_simd;       ///< Hardware limit of the target
+  size_t workgroups_per_cu;        ///< Resident blocks per compute unit
+  hiprtcOccupancyLimit limit;      ///< Resource bounding waves_per_simd
+  size_t suggested_block_size;     ///< Largest block size with the highest
+                                   ///< occupancy
+  double suggested_waves_per_simd; ///< Waves per SIMD at that size
+} hiprtcOccupancy;
+
+/**
+ * @brief Estimate the occupancy of a compiled kernel without launching it
+ *
+ * Uses the register and LDS usage of hiprtcGetKernelInfo and a built in
+ * table of hardware limits for gfx9, gfx10, gfx11 and gfx12 processors.
+ * Scratch usage is not taken into account.
+ *
+ * @param prog compiled program
+ * @param kernel kernel name, e.g. from hiprtcGetLoweredName
+ * @param block_size work items per block
+ * @param dynamic_lds dynamic shared memory per block in bytes
+ * @param target target id the program was compiled for, may be nullptr to
+ * use its single target, or else the one picked as when compiling without
+ * target options, i.e. the device of this machine
+ * @param occupancy struct_size has to be set
+ * @return hiprtcResult HIPRTC_ERROR_INVALID_INPUT if the program has no such
+ * target or kernel, the processor is not in the table, or a block of that
+ * size does not fit on a compute unit
+ */
+hiprtcResult hiprtcEstimateOccupancy(hiprtcProgram prog, const char *kernel,
+                                     size_t block_size, size_t dynamic_lds,
+                                     const char *target,
+                                     hiprtcOccupancy *occupancy);
+
+/**
+ * @brief Handle of a header registered with the process
+ *
+ */
+typedef void *hiprtcHeader;
+
+/**
+ * @brief Register a header once for use by many programs
+ *
+ * Headers are stored by content, registering the same name and text again
+ * gives back the same handle. Programs using a header hold on to it, so it
+ * can be released while they are still alive.
+ *
+ * @param header output handle
+ * @param name include name
+ * @param src header text
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcRegisterHeader(hiprtcHeader *header, const char *name,
+                                  const char *src);
+
+/**
+ * @brief Release a handle from hiprtcRegisterHeader
+ *
+ * @param header
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcReleaseHeader(hiprtcHeader header);
+
+/**
+ * @brief Make registered headers available to a program before compilation
+ *
+ * Only headers the source can reach are handed to the compiler, either
+ * directly or through other headers.
+ *
+ * @param prog
+ * @param num_headers number of headers
+ * @param headers registered headers
+ * @return hiprtcResult
+ */
+hiprtcResult hiprtcAddProgramHeaders(hiprtcProgram prog, int num_headers,
+                                     const hiprtcHeader *headers);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,684 @@
+#include <amd_comgr/amd_comgr.h>
+#include <elf.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Stand-in for comgr that runs no compiler. Data is copied in and out like
+// the real library, actions produce "MOCK:<isa>:<input>" so results differ
+// per source and target. Code objects wrap that in an ELF with symbols and
+// relocations for name expressions, executables also get an AMDGPU metadata
+// note listing the __global__ functions of the source, those using mfma get
+// AGPRs. Sources
+// without a __global__ kernel or with an #error in them or in a header of the
+// data set fail to compile, to exercise error paths, and ones with
+// __hiprtc_mock_crash__ abort the process like a compiler crash would, ones
+// with __hiprtc_mock_hang__ never return.
+
+namespace {
+struct mock_data {
+  amd_comgr_data_kind_t kind_;
+  std::string bytes_;
+  std::string name_;
+  std::atomic<int> refs_{1};
+};
+
+struct mock_data_set {
+  std::vector<mock_data *> items_;
+};
+
+struct mock_action_info {
+  std::string isa_name_;
+  std::vector<std::string> options_;
+};
+
+mock_data *to_data(amd_comgr_data_t data) {
+  return reinterpret_cast<mock_data *>(data.handle);
+}
+
+mock_data_set *to_data_set(amd_comgr_data_set_t data_set) {
+  return reinterpret_cast<mock_data_set *>(data_set.handle);
+}
+
+mock_action_info *to_action_info(amd_comgr_action_info_t action_info) {
+  return reinterpret_cast<mock_action_info *>(action_info.handle);
+}
+
+void add_output(amd_comgr_data_set_t data_set, amd_comgr_data_kind_t kind,
+                std::string bytes, const char *name) {
+  auto data = new mock_data{kind, std::move(bytes), name};
+  to_data_set(data_set)->items_.push_back(data);
+}
+
+// Simulated cost of an action, HIPRTC_MOCK_ACTION_US microseconds
+void simulate_latency() {
+  static const long latency_us = [] {
+    auto env = std::getenv("HIPRTC_MOCK_ACTION_US");
+    return (env != nullptr) ? std::atol(env) : 0L;
+  }();
+  if (latency_us > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(latency_us));
+  }
+}
+
+// Writers of the msgpack subset the metadata uses
+void put_be(std::string &out, uint64_t value, size_t size) {
+  for (size_t i = size; i > 0; i--) {
+    out += char(value >> (8 * (i - 1)));
+  }
+}
+
+void put_uint(std::string &out, uint64_t value) {
+  if (value <= 0x7f) {
+    out += char(value);
+  } else {
+    out += char(0xcf);
+    put_be(out, value, 8);
+  }
+}
+
+void put_str(std::string &out, const std::string &str) {
+  out += char(0xdb);
+  put_be(out, str.size(), 4);
+  out += str;
+}
+
+void put_map(std::string &out, size_t count) {
+  out += char(0xdf);
+  put_be(out, count, 4);
+}
+
+void put_array(std::string &out, size_t count) {
+  out += char(0xdd);
+  put_be(out, count, 4);
+}
+
+bool is_identifier_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+// Last identifier of text, empty if none
+std::string last_identifier(const std::string &text) {
+  size_t end = text.size();
+  while (end > 0 && !is_identifier_char(text[end - 1])) {
+    end--;
+  }
+  size_t start = end;
+  while (start > 0 && is_identifier_char(text[start - 1])) {
+    start--;
+  }
+  return text.substr(start, end - start);
+}
+
+// Metadata of each __global__ function: fixed resources, 64 AGPRs more for
+// mfma, parameters laid out as pointers and 4 or 8 byte values, and one
+// hidden argument. Targets with unified AGPRs count them in .vgpr_count.
+std::string get_metadata(const std::string &isa, const std::string &text) {
+  bool wave32 = isa.find("--gfx1") != std::string::npos;
+  bool unified_agprs = isa.find("--gfx90a") != std::string::npos ||
+                       isa.find("--gfx94") != std::string::npos ||
+                       isa.find("--gfx950") != std::string::npos ||
+                       isa.find("--gfx9-4-generic") != std::string::npos;
+  std::vector<std::string> names, kernels;
+  for (auto pos = text.find("__global__"); pos != std::string::npos;
+       pos = text.find("__global__", pos + 1)) {
+    auto open = text.find('(', pos);
+    auto close = text.find(')', open);
+    if (close == std::string::npos) {
+      break;
+    }
+    auto name = last_identifier(text.substr(pos, open - pos));
+    if (name.empty() ||
+        std::find(names.begin(), names.end(), name) != names.end()) {
+      continue;
+    }
+    names.push_back(name);
+    auto body = text.substr(close, text.find("__global__", close) - close);
+    size_t agprs = (body.find("mfma") != std::string::npos) ? 64 : 0;
+
+    std::vector<std::string> params;
+    auto list = text.substr(open + 1, close - open - 1);
+    for (size_t start = 0; start < list.size();) {
+      auto comma = std::min(list.find(',', start), list.size());
+      if (list.find_first_not_of(" \t\n", start) < comma) {
+        params.push_back(list.substr(start, comma - start));
+      }
+      start = comma + 1;
+    }
+
+    std::string args;
+    put_array(args, params.size() + 1);
+    size_t offset = 0;
+    for (auto &param : params) {
+      bool pointer = param.find('*') != std::string::npos;
+      size_t size = (pointer || param.find("double") != std::string::npos ||
+                     param.find("long") != std::string::npos)
+                        ? 8
+                        : 4;
+      offset = (offset + size - 1) / size * size;
+      put_map(args, 4);
+      put_str(args, ".name");
+      put_str(args, last_identifier(param));
+      put_str(args, ".offset");
+      put_uint(args, offset);
+      put_str(args, ".size");
+      put_uint(args, size);
+      put_str(args, ".value_kind");
+      put_str(args, pointer ? "global_buffer" : "by_value");
+      offset += size;
+    }
+    offset = (offset + 7) / 8 * 8;
+    put_map(args, 3);
+    put_str(args, ".offset");
+    put_uint(args, offset);
+    put_str(args, ".size");
+    put_uint(args, 4);
+    put_str(args, ".value_kind");
+    put_str(args, "hidden_block_count_x");
+    offset += 4;
+
+    std::string map;
+    put_map(map, 14);
+    put_str(map, ".name");
+    put_str(map, name);
+    put_str(map, ".symbol");
+    put_str(map, name + ".kd");
+    put_str(map, ".vgpr_count");
+    put_uint(map, unified_agprs ? 32 + agprs : 32);
+    put_str(map, ".sgpr_count");
+    put_uint(map, 16);
+    put_str(map, ".agpr_count");
+    put_uint(map, agprs);
+    put_str(map, ".vgpr_spill_count");
+    put_uint(map, 0);
+    put_str(map, ".sgpr_spill_count");
+    put_uint(map, 0);
+    put_str(map, ".group_segment_fixed_size");
+    put_uint(map, text.find("__shared__") != std::string::npos ? 1024 : 0);
+    put_str(map, ".private_segment_fixed_size");
+    put_uint(map, 0);
+    put_str(map, ".max_flat_workgroup_size");
+    put_uint(map, 1024);
+    put_str(map, ".wavefront_size");
+    put_uint(map, wave32 ? 32 : 64);
+    put_str(map, ".kernarg_segment_size");
+    put_uint(map, (offset + 7) / 8 * 8);
+    put_str(map, ".kernarg_segment_align");
+    put_uint(map, 8);
+    put_str(map, ".args");
+    map += args;
+    kernels.push_back(std::move(map));
+  }
+
+  std::string metadata;
+  put_map(metadata, 1);
+  put_str(metadata, "amdhsa.kernels");
+  put_array(metadata, kernels.size());
+  for (auto &kernel : kernels) {
+    metadata += kernel;
+  }
+  return metadata;
+}
+
+// Shape of a mangled name, not a real one
+std::string mangle(const std::string &name_expression) {
+  return "_Z" + std::to_string(name_expression.size()) + name_expression +
+         "v";
+}
+
+// Name expressions of the __amdgcn_name_expr_<i>[]= {"<name>", ...} arrays
+// hiprtc adds to the source, at i - 1, empty for missing indices
+std::vector<std::string> get_name_expressions(const std::string &text) {
+  const std::string marker = "__amdgcn_name_expr_", open = "[]= {\"";
+  std::vector<std::string> names;
+  for (auto pos = text.find(marker); pos != std::string::npos;
+       pos = text.find(marker, pos + 1)) {
+    size_t end = pos + marker.size(), index = 0;
+    while (end < text.size() && text[end] >= '0' && text[end] <= '9' &&
+           index <= text.size()) {
+      index = index * 10 + (text[end++] - '0');
+    }
+    auto close = text.find('"', end + open.size());
+    if (index == 0 || index > text.size() ||
+        text.compare(end, open.size(), open) != 0 ||
+        close == std::string::npos) {
+      continue;
+    }
+    names.resize(std::max(names.size(), index));
+    if (names[index - 1].empty()) {
+      auto start = end + open.size();
+      names[index - 1] = text.substr(start, close - start);
+    }
+  }
+  return names;
+}
+
+// Sections of an ELF, the headers are written by finish
+class elf_writer {
+public:
+  elf_writer() : out_(sizeof(Elf64_Ehdr), '\0'), sections_(1) {}
+
+  size_t add(const std::string &name, uint32_t type, const std::string &data,
+             uint64_t flags = 0, uint64_t addr = 0) {
+    Elf64_Shdr section = {};
+    section.sh_name = uint32_t(names_.size());
+    section.sh_type = type;
+    section.sh_flags = flags;
+    section.sh_addr = addr;
+    section.sh_offset = out_.size();
+    section.sh_size = data.size();
+    section.sh_addralign = 8;
+    names_ += name;
+    names_ += '\0';
+    out_ += data;
+    out_.resize((out_.size() + 7) / 8 * 8);
+    sections_.push_back(section);
+    return sections_.size() - 1;
+  }
+
+  Elf64_Shdr &section(size_t i) { return sections_[i]; }
+
+  std::string finish(uint16_t type) {
+    auto strings = names_ + ".shstrtab";
+    strings += '\0';
+    auto shstrtab = add(".shstrtab", SHT_STRTAB, strings);
+
+    Elf64_Ehdr ehdr = {};
+    std::memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+    ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_ident[EI_OSABI] = 64; // ELFOSABI_AMDGPU_HSA
+    ehdr.e_type = type;
+    ehdr.e_machine = 224; // EM_AMDGPU
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+    ehdr.e_shentsize = sizeof(Elf64_Shdr);
+    ehdr.e_shoff = out_.size();
+    ehdr.e_shnum = uint16_t(sections_.size());
+    ehdr.e_shstrndx = uint16_t(shstrtab);
+    std::memcpy(out_.data(), &ehdr, sizeof(ehdr));
+    out_.append(reinterpret_cast<const char *>(sections_.data()),
+                sections_.size() * sizeof(Elf64_Shdr));
+    return std::move(out_);
+  }
+
+private:
+  std::string out_;
+  std::vector<Elf64_Shdr> sections_;
+  std::string names_ = std::string(1, '\0');
+};
+
+template <typename T> void put_struct(std::string &out, const T &value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Functions of the name expressions, each array in .data and its address
+// slot relocated to the function, like the compiler lays them out. An
+// executable has them at distinct addresses with relative relocations, a
+// relocatable has every function at 0 in a section of its own, relocated
+// against the function symbol for even indices and against the section
+// symbol for odd ones.
+void add_name_expressions(elf_writer &elf, const std::string &text,
+                          bool executable) {
+  auto names = get_name_expressions(text);
+  if (names.empty()) {
+    return;
+  }
+  constexpr uint32_t r_amdgpu_abs64 = 3, r_amdgpu_relative64 = 13;
+  constexpr uint64_t text_addr = 0x1000, slot_size = 2 * sizeof(uint64_t);
+  uint64_t data_addr = executable ? text_addr + names.size() * 8 : 0;
+
+  std::vector<size_t> text_sections(names.size());
+  if (executable) {
+    std::fill(text_sections.begin(), text_sections.end(),
+              elf.add(".text", SHT_PROGBITS,
+                      std::string(names.size() * 8, '\0'),
+                      SHF_ALLOC | SHF_EXECINSTR, text_addr));
+  } else {
+    for (size_t i = 0; i < names.size(); i++) {
+      text_sections[i] =
+          elf.add(".text." + std::to_string(i + 1), SHT_PROGBITS,
+                  std::string(8, '\0'), SHF_ALLOC | SHF_EXECINSTR);
+    }
+  }
+  auto data = elf.add(".data", SHT_PROGBITS,
+                      std::string(names.size() * slot_size, '\0'),
+                      SHF_ALLOC | SHF_WRITE, data_addr);
+
+  // Locals first, section symbols and arrays, then the functions
+  std::string strtab(1, '\0'), symtab(sizeof(Elf64_Sym), '\0');
+  auto add_symbol = [&](const std::string &name, unsigned char info,
+                        size_t section, uint64_t value) {
+    Elf64_Sym symbol = {};
+    if (!name.empty()) {
+      symbol.st_name = uint32_t(strtab.size());
+      strtab += name;
+      strtab += '\0';
+    }
+    symbol.st_info = info;
+    symbol.st_shndx = uint16_t(section);
+    symbol.st_value = value;
+    put_struct(symtab, symbol);
+    return symtab.size() / sizeof(Elf64_Sym) - 1;
+  };
+  std::vector<size_t> section_symbols(names.size());
+  for (size_t i = 0; i < names.size() && !executable; i++) {
+    section_symbols[i] = add_symbol("", ELF64_ST_INFO(STB_LOCAL, STT_SECTION),
+                                    text_sections[i], 0);
+  }
+  for (size_t i = 0; i < names.size(); i++) {
+    if (!names[i].empty()) {
+      auto array = "__amdgcn_name_expr_" + std::to_string(i + 1);
+      add_symbol("_ZL" + std::to_string(array.size()) + array,
+                 ELF64_ST_INFO(STB_LOCAL, STT_OBJECT), data,
+                 data_addr + i * slot_size);
+    }
+  }
+  auto globals = symtab.size() / sizeof(Elf64_Sym);
+
+  std::string relas;
+  for (size_t i = 0; i < names.size(); i++) {
+    if (names[i].empty()) {
+      continue;
+    }
+    uint64_t function_addr = executable ? text_addr + i * 8 : 0;
+    auto function =
+        add_symbol(mangle(names[i]), ELF64_ST_INFO(STB_GLOBAL, STT_FUNC),
+                   text_sections[i], function_addr);
+    Elf64_Rela rela = {};
+    rela.r_offset = data_addr + i * slot_size + sizeof(uint64_t);
+    if (executable) {
+      rela.r_info = ELF64_R_INFO(0, r_amdgpu_relative64);
+      rela.r_addend = int64_t(function_addr);
+    } else {
+      rela.r_info = ELF64_R_INFO(
+          (i % 2 == 0) ? function : section_symbols[i], r_amdgpu_abs64);
+    }
+    put_struct(relas, rela);
+  }
+
+  auto strings = elf.add(".strtab", SHT_STRTAB, strtab);
+  auto symbols = elf.add(".symtab", SHT_SYMTAB, symtab);
+  elf.section(symbols).sh_link = uint32_t(strings);
+  elf.section(symbols).sh_info = uint32_t(globals);
+  elf.section(symbols).sh_entsize = sizeof(Elf64_Sym);
+  auto rela = elf.add(executable ? ".rela.dyn" : ".rela.data", SHT_RELA,
+                      relas, executable ? SHF_ALLOC : SHF_INFO_LINK);
+  elf.section(rela).sh_link = uint32_t(symbols);
+  elf.section(rela).sh_info = executable ? 0 : uint32_t(data);
+  elf.section(rela).sh_entsize = sizeof(Elf64_Rela);
+}
+
+// ELF with the mock output in a .mock section and the name expressions,
+// executables also get the metadata note
+std::string get_code_object(const std::string &isa, const std::string &text,
+                            bool executable) {
+  elf_writer elf;
+  if (executable) {
+    auto metadata = get_metadata(isa, text);
+    const char name[] = "AMDGPU";
+    std::string note;
+    put_struct(note, Elf64_Nhdr{sizeof(name), uint32_t(metadata.size()), 32});
+    note.append(name, sizeof(name));
+    note.resize((note.size() + 3) / 4 * 4);
+    note += metadata;
+    note.resize((note.size() + 3) / 4 * 4);
+    elf.section(elf.add(".note", SHT_NOTE, note)).sh_addralign = 4;
+  }
+  elf.add(".mock", SHT_PROGBITS, text);
+  add_name_expressions(elf, text, executable);
+  return elf.finish(executable ? ET_DYN : ET_REL);
+}
+
+amd_comgr_status_t copy_out(const std::string &value, size_t *size,
+                            char *bytes) {
+  if (size == nullptr) {
+    return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+  }
+  if (bytes == nullptr) {
+    *size = value.size();
+    return AMD_COMGR_STATUS_SUCCESS;
+  }
+  std::memcpy(bytes, value.data(), std::min(*size, value.size()));
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+} // namespace
+
+extern "C" {
+void amd_comgr_get_version(size_t *major, size_t *minor) {
+  *major = 2;
+  *minor = 8;
+}
+
+amd_comgr_status_t amd_comgr_status_string(amd_comgr_status_t status,
+                                           const char **status_string) {
+  *status_string = (status == AMD_COMGR_STATUS_SUCCESS) ? "SUCCESS" : "ERROR";
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_create_data(amd_comgr_data_kind_t kind,
+                                         amd_comgr_data_t *data) {
+  data->handle = reinterpret_cast<uint64_t>(new mock_data{kind});
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_release_data(amd_comgr_data_t data) {
+  if (--to_data(data)->refs_ == 0) {
+    delete to_data(data);
+  }
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_get_data_kind(amd_comgr_data_t data,
+                                           amd_comgr_data_kind_t *kind) {
+  *kind = to_data(data)->kind_;
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_set_data(amd_comgr_data_t data, size_t size,
+                                      const char *bytes) {
+  to_data(data)->bytes_.assign(bytes, size);
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_set_data_name(amd_comgr_data_t data,
+                                           const char *name) {
+  to_data(data)->name_ = name;
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_get_data(amd_comgr_data_t data, size_t *size,
+                                      char *bytes) {
+  return copy_out(to_data(data)->bytes_, size, bytes);
+}
+
+amd_comgr_status_t amd_comgr_get_data_name(amd_comgr_data_t data, size_t *size,
+                                           char *name) {
+  // Size includes the terminator
+  auto &value = to_data(data)->name_;
+  return copy_out(std::string(value.c_str(), value.size() + 1), size, name);
+}
+
+amd_comgr_status_t amd_comgr_create_data_set(amd_comgr_data_set_t *data_set) {
+  data_set->handle = reinterpret_cast<uint64_t>(new mock_data_set);
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_destroy_data_set(amd_comgr_data_set_t data_set) {
+  for (auto data : to_data_set(data_set)->items_) {
+    (void)amd_comgr_release_data({reinterpret_cast<uint64_t>(data)});
+  }
+  delete to_data_set(data_set);
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_data_set_add(amd_comgr_data_set_t data_set,
+                                          amd_comgr_data_t data) {
+  to_data(data)->refs_++;
+  to_data_set(data_set)->items_.push_back(to_data(data));
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_data_set_remove(amd_comgr_data_set_t data_set,
+                                             amd_comgr_data_kind_t data_kind) {
+  auto &items = to_data_set(data_set)->items_;
+  for (auto it = items.begin(); it != items.end();) {
+    if ((*it)->kind_ == data_kind) {
+      (void)amd_comgr_release_data({reinterpret_cast<uint64_t>(*it)});
+      it = items.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_action_data_count(amd_comgr_data_set_t data_set,
+                                               amd_comgr_data_kind_t data_kind,
+                                               size_t *count) {
+  *count = 0;
+  for (auto data : to_data_set(data_set)->items_) {
+    *count += (data->kind_ == data_kind) ? 1 : 0;
+  }
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t
+amd_comgr_action_data_get_data(amd_comgr_data_set_t data_set,
+                               amd_comgr_data_kind_t data_kind, size_t index,
+                               amd_comgr_data_t *data) {
+  for (auto item : to_data_set(data_set)->items_) {
+    if (item->kind_ == data_kind && index-- == 0) {
+      item->refs_++;
+      data->handle = reinterpret_cast<uint64_t>(item);
+      return AMD_COMGR_STATUS_SUCCESS;
+    }
+  }
+  return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+}
+
+amd_comgr_status_t
+amd_comgr_create_action_info(amd_comgr_action_info_t *action_info) {
+  action_info->handle = reinterpret_cast<uint64_t>(new mock_action_info);
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t
+amd_comgr_destroy_action_info(amd_comgr_action_info_t action_info) {
+  delete to_action_info(action_info);
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t
+amd_comgr_action_info_set_isa_name(amd_comgr_action_info_t action_info,
+                                   const char *isa_name) {
+  to_action_info(action_info)->isa_name_ = isa_name;
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t
+amd_comgr_action_info_set_language(amd_comgr_action_info_t,
+                                   amd_comgr_language_t) {
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t
+amd_comgr_action_info_set_option_list(amd_comgr_action_info_t action_info,
+                                      const char *options[], size_t count) {
+  to_action_info(action_info)->options_.assign(options, options + count);
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_do_action(amd_comgr_action_kind_t kind,
+                                       amd_comgr_action_info_t info,
+                                       amd_comgr_data_set_t input,
+                                       amd_comgr_data_set_t result) {
+  simulate_latency();
+
+  std::string source, payload, includes;
+  for (auto data : to_data_set(input)->items_) {
+    switch (data->kind_) {
+    case AMD_COMGR_DATA_KIND_SOURCE:
+      source += data->bytes_;
+      break;
+    case AMD_COMGR_DATA_KIND_INCLUDE:
+      includes += "# 1 \"" + data->name_ + "\"\n" + data->bytes_ + "\n";
+      break;
+    case AMD_COMGR_DATA_KIND_PRECOMPILED_HEADER:
+      break;
+    default:
+      payload += data->bytes_;
+    }
+  }
+
+  if (kind == AMD_COMGR_ACTION_SOURCE_TO_PREPROCESSOR) {
+    add_output(result, AMD_COMGR_DATA_KIND_SOURCE, includes, "out.i");
+    return AMD_COMGR_STATUS_SUCCESS;
+  }
+
+  if (source.find("__hiprtc_mock_crash__") != std::string::npos) {
+    std::abort();
+  }
+  while (source.find("__hiprtc_mock_hang__") != std::string::npos) {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+  }
+
+  if (!source.empty() && (source.find("__global__") == std::string::npos ||
+                          source.find("#error") != std::string::npos ||
+                          includes.find("#error") != std::string::npos)) {
+    add_output(result, AMD_COMGR_DATA_KIND_LOG,
+               "mock: error: no kernel in source\n", "log");
+    return AMD_COMGR_STATUS_ERROR;
+  }
+
+  auto output_kind = AMD_COMGR_DATA_KIND_RELOCATABLE;
+  switch (kind) {
+  case AMD_COMGR_ACTION_COMPILE_SOURCE_TO_BC:
+  case AMD_COMGR_ACTION_COMPILE_SOURCE_WITH_DEVICE_LIBS_TO_BC:
+  case AMD_COMGR_ACTION_LINK_BC_TO_BC:
+  case AMD_COMGR_ACTION_OPTIMIZE_BC_TO_BC:
+    output_kind = AMD_COMGR_DATA_KIND_BC;
+    break;
+  case AMD_COMGR_ACTION_LINK_RELOCATABLE_TO_EXECUTABLE:
+  case AMD_COMGR_ACTION_COMPILE_SOURCE_TO_EXECUTABLE:
+    output_kind = AMD_COMGR_DATA_KIND_EXECUTABLE;
+    break;
+  default:
+    break;
+  }
+
+  auto &isa_name = to_action_info(info)->isa_name_;
+  auto out = "MOCK:" + isa_name + ":" + (source.empty() ? payload : source);
+  if (output_kind == AMD_COMGR_DATA_KIND_EXECUTABLE ||
+      output_kind == AMD_COMGR_DATA_KIND_RELOCATABLE) {
+    out = get_code_object(isa_name, out,
+                          output_kind == AMD_COMGR_DATA_KIND_EXECUTABLE);
+  }
+  add_output(result, output_kind, std::move(out), "out");
+  add_output(result, AMD_COMGR_DATA_KIND_LOG, "", "log");
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_populate_name_expression_map(amd_comgr_data_t,
+                                                          size_t *count) {
+  // Leaves the symbol table of the code object as the only way to lower names
+  if (std::getenv("HIPRTC_MOCK_NO_NAME_MAP") != nullptr) {
+    return AMD_COMGR_STATUS_ERROR;
+  }
+  *count = 0;
+  return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_map_name_expression_to_symbol_name(
+    amd_comgr_data_t, size_t *size, char *name_expression, char *symbol_name) {
+  return copy_out(mangle(name_expression), size, symbol_name);
+}
+}
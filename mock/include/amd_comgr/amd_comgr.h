@@ -0,0 +1,152 @@
+#pragma once
+
+// Subset of the comgr API used by hiprtc, implemented by mock/comgr.cpp.
+// Values match the real header so code built against either behaves alike.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum amd_comgr_status_s {
+  AMD_COMGR_STATUS_SUCCESS = 0x0,
+  AMD_COMGR_STATUS_ERROR = 0x1,
+  AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT = 0x2,
+  AMD_COMGR_STATUS_ERROR_OUT_OF_RESOURCES = 0x3,
+} amd_comgr_status_t;
+
+typedef enum amd_comgr_language_s {
+  AMD_COMGR_LANGUAGE_NONE = 0x0,
+  AMD_COMGR_LANGUAGE_OPENCL_1_2 = 0x1,
+  AMD_COMGR_LANGUAGE_OPENCL_2_0 = 0x2,
+  AMD_COMGR_LANGUAGE_HC = 0x3,
+  AMD_COMGR_LANGUAGE_HIP = 0x4,
+  AMD_COMGR_LANGUAGE_LLVM_IR = 0x5,
+} amd_comgr_language_t;
+
+typedef enum amd_comgr_data_kind_s {
+  AMD_COMGR_DATA_KIND_UNDEF = 0x0,
+  AMD_COMGR_DATA_KIND_SOURCE = 0x1,
+  AMD_COMGR_DATA_KIND_INCLUDE = 0x2,
+  AMD_COMGR_DATA_KIND_PRECOMPILED_HEADER = 0x3,
+  AMD_COMGR_DATA_KIND_DIAGNOSTIC = 0x4,
+  AMD_COMGR_DATA_KIND_LOG = 0x5,
+  AMD_COMGR_DATA_KIND_BC = 0x6,
+  AMD_COMGR_DATA_KIND_RELOCATABLE = 0x7,
+  AMD_COMGR_DATA_KIND_EXECUTABLE = 0x8,
+  AMD_COMGR_DATA_KIND_BYTES = 0x9,
+  AMD_COMGR_DATA_KIND_FATBIN = 0x10,
+} amd_comgr_data_kind_t;
+
+typedef struct amd_comgr_data_s {
+  uint64_t handle;
+} amd_comgr_data_t;
+
+typedef struct amd_comgr_data_set_s {
+  uint64_t handle;
+} amd_comgr_data_set_t;
+
+typedef struct amd_comgr_action_info_s {
+  uint64_t handle;
+} amd_comgr_action_info_t;
+
+typedef enum amd_comgr_action_kind_s {
+  AMD_COMGR_ACTION_SOURCE_TO_PREPROCESSOR = 0x0,
+  AMD_COMGR_ACTION_ADD_PRECOMPILED_HEADERS = 0x1,
+  AMD_COMGR_ACTION_COMPILE_SOURCE_TO_BC = 0x2,
+  AMD_COMGR_ACTION_ADD_DEVICE_LIBRARIES = 0x3,
+  AMD_COMGR_ACTION_LINK_BC_TO_BC = 0x4,
+  AMD_COMGR_ACTION_OPTIMIZE_BC_TO_BC = 0x5,
+  AMD_COMGR_ACTION_CODEGEN_BC_TO_RELOCATABLE = 0x6,
+  AMD_COMGR_ACTION_CODEGEN_BC_TO_ASSEMBLY = 0x7,
+  AMD_COMGR_ACTION_LINK_RELOCATABLE_TO_RELOCATABLE = 0x8,
+  AMD_COMGR_ACTION_LINK_RELOCATABLE_TO_EXECUTABLE = 0x9,
+  AMD_COMGR_ACTION_ASSEMBLE_SOURCE_TO_RELOCATABLE = 0xA,
+  AMD_COMGR_ACTION_DISASSEMBLE_RELOCATABLE_TO_SOURCE = 0xB,
+  AMD_COMGR_ACTION_DISASSEMBLE_EXECUTABLE_TO_SOURCE = 0xC,
+  AMD_COMGR_ACTION_DISASSEMBLE_BYTES_TO_SOURCE = 0xD,
+  AMD_COMGR_ACTION_COMPILE_SOURCE_TO_FATBIN = 0xE,
+  AMD_COMGR_ACTION_COMPILE_SOURCE_WITH_DEVICE_LIBS_TO_BC = 0xF,
+  AMD_COMGR_ACTION_COMPILE_SOURCE_TO_RELOCATABLE = 0x10,
+  AMD_COMGR_ACTION_COMPILE_SOURCE_TO_EXECUTABLE = 0x11,
+} amd_comgr_action_kind_t;
+
+void amd_comgr_get_version(size_t *major, size_t *minor);
+
+amd_comgr_status_t amd_comgr_status_string(amd_comgr_status_t status,
+                                           const char **status_string);
+
+amd_comgr_status_t amd_comgr_create_data(amd_comgr_data_kind_t kind,
+                                         amd_comgr_data_t *data);
+
+amd_comgr_status_t amd_comgr_release_data(amd_comgr_data_t data);
+
+amd_comgr_status_t amd_comgr_get_data_kind(amd_comgr_data_t data,
+                                           amd_comgr_data_kind_t *kind);
+
+amd_comgr_status_t amd_comgr_set_data(amd_comgr_data_t data, size_t size,
+                                      const char *bytes);
+
+amd_comgr_status_t amd_comgr_set_data_name(amd_comgr_data_t data,
+                                           const char *name);
+
+amd_comgr_status_t amd_comgr_get_data(amd_comgr_data_t data, size_t *size,
+                                      char *bytes);
+
+amd_comgr_status_t amd_comgr_get_data_name(amd_comgr_data_t data, size_t *size,
+                                           char *name);
+
+amd_comgr_status_t amd_comgr_create_data_set(amd_comgr_data_set_t *data_set);
+
+amd_comgr_status_t amd_comgr_destroy_data_set(amd_comgr_data_set_t data_set);
+
+amd_comgr_status_t amd_comgr_data_set_add(amd_comgr_data_set_t data_set,
+                                          amd_comgr_data_t data);
+
+amd_comgr_status_t amd_comgr_data_set_remove(amd_comgr_data_set_t data_set,
+                                             amd_comgr_data_kind_t data_kind);
+
+amd_comgr_status_t amd_comgr_action_data_count(amd_comgr_data_set_t data_set,
+                                               amd_comgr_data_kind_t data_kind,
+                                               size_t *count);
+
+amd_comgr_status_t
+amd_comgr_action_data_get_data(amd_comgr_data_set_t data_set,
+                               amd_comgr_data_kind_t data_kind, size_t index,
+                               amd_comgr_data_t *data);
+
+amd_comgr_status_t
+amd_comgr_create_action_info(amd_comgr_action_info_t *action_info);
+
+amd_comgr_status_t
+amd_comgr_destroy_action_info(amd_comgr_action_info_t action_info);
+
+amd_comgr_status_t
+amd_comgr_action_info_set_isa_name(amd_comgr_action_info_t action_info,
+                                   const char *isa_name);
+
+amd_comgr_status_t
+amd_comgr_action_info_set_language(amd_comgr_action_info_t action_info,
+                                   amd_comgr_language_t language);
+
+amd_comgr_status_t
+amd_comgr_action_info_set_option_list(amd_comgr_action_info_t action_info,
+                                      const char *options[], size_t count);
+
+amd_comgr_status_t amd_comgr_do_action(amd_comgr_action_kind_t kind,
+                                       amd_comgr_action_info_t info,
+                                       amd_comgr_data_set_t input,
+                                       amd_comgr_data_set_t result);
+
+amd_comgr_status_t amd_comgr_populate_name_expression_map(amd_comgr_data_t data,
+                                                          size_t *count);
+
+amd_comgr_status_t amd_comgr_map_name_expression_to_symbol_name(
+    amd_comgr_data_t data, size_t *size, char *name_expression,
+    char *symbol_name);
+
+#ifdef __cplusplus
+}
+#endif
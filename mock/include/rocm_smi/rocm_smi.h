@@ -0,0 +1,35 @@
+#pragma once
+
+// Subset of the rocm_smi API used by hiprtc, implemented by
+// mock/rocm_smi.cpp.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  RSMI_STATUS_SUCCESS = 0x0,
+  RSMI_STATUS_INVALID_ARGS,
+  RSMI_STATUS_NOT_SUPPORTED,
+  RSMI_STATUS_FILE_ERROR,
+  RSMI_STATUS_PERMISSION,
+  RSMI_STATUS_OUT_OF_RESOURCES,
+  RSMI_STATUS_INTERNAL_EXCEPTION,
+  RSMI_STATUS_INPUT_OUT_OF_BOUNDS,
+  RSMI_STATUS_INIT_ERROR,
+} rsmi_status_t;
+
+rsmi_status_t rsmi_init(uint64_t init_flags);
+
+rsmi_status_t rsmi_shut_down(void);
+
+rsmi_status_t rsmi_num_monitor_devices(uint32_t *num_devices);
+
+rsmi_status_t rsmi_dev_target_graphics_version_get(uint32_t dv_ind,
+                                                   uint64_t *gfx_version);
+
+#ifdef __cplusplus
+}
+#endif
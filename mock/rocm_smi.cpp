@@ -0,0 +1,20 @@
+#include <rocm_smi/rocm_smi.h>
+
+// Stand-in for rocm_smi reporting a single gfx90a device
+
+extern "C" {
+rsmi_status_t rsmi_init(uint64_t) { return RSMI_STATUS_SUCCESS; }
+
+rsmi_status_t rsmi_shut_down(void) { return RSMI_STATUS_SUCCESS; }
+
+rsmi_status_t rsmi_num_monitor_devices(uint32_t *num_devices) {
+  *num_devices = 1;
+  return RSMI_STATUS_SUCCESS;
+}
+
+rsmi_status_t rsmi_dev_target_graphics_version_get(uint32_t,
+                                                   uint64_t *gfx_version) {
+  *gfx_version = 90010;
+  return RSMI_STATUS_SUCCESS;
+}
+}
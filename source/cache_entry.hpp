@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Result of a compilation as stored by the code object caches
+ *
+ */
+struct cache_entry {
+  std::vector<char> object_; // Code object, empty for a bitcode only entry
+  std::shared_ptr<const std::vector<char>>
+      bitcode_; // Front end output the code object is built from, one buffer
+                // shared by the bitcode only entry and its code objects
+  std::unordered_map<std::string,
+                     std::string> lowered_names_; // Lowered names
+  std::string log_;                               // Build log
+
+  // Bitcode bytes, empty if there is none
+  std::string_view bitcode() const {
+    return (bitcode_ != nullptr)
+               ? std::string_view(bitcode_->data(), bitcode_->size())
+               : std::string_view();
+  }
+};
@@ -0,0 +1,322 @@
+#include "code_object.hpp"
+
+#include <elf.h>
+
+#include <cstring>
+#include <string_view>
+
+namespace code_object {
+namespace {
+constexpr uint32_t nt_amdgpu_metadata = 32; // NT_AMDGPU_METADATA
+constexpr std::string_view note_name = "AMDGPU";
+constexpr int max_depth = 16; // Metadata nests a few levels at most
+
+// Decoded msgpack value, ext types decode as nil
+struct msgpack_value {
+  enum class kind { nil, boolean, integer, floating, string, array, map };
+  kind kind_ = kind::nil;
+  uint64_t integer_ = 0; // Negative ones wrap, metadata has none
+  double floating_ = 0;
+  std::string_view string_;
+  std::vector<msgpack_value> items_; // Array elements, or keys and values
+                                     // of a map in turn
+
+  // Value of a map key, nullptr if absent
+  const msgpack_value *find(std::string_view key) const {
+    if (kind_ != kind::map) {
+      return nullptr;
+    }
+    for (size_t i = 0; i + 1 < items_.size(); i += 2) {
+      if (items_[i].kind_ == kind::string && items_[i].string_ == key) {
+        return &items_[i + 1];
+      }
+    }
+    return nullptr;
+  }
+};
+
+// Big endian integer of size bytes
+bool read_be(std::string_view data, size_t &pos, size_t size, uint64_t &out) {
+  if (size > data.size() - pos) {
+    return false;
+  }
+  out = 0;
+  for (size_t i = 0; i < size; i++) {
+    out = (out << 8) | uint8_t(data[pos++]);
+  }
+  return true;
+}
+
+bool read_value(std::string_view data, size_t &pos, msgpack_value &out,
+                int depth);
+
+// count values, or key value pairs of a map, each at least a byte
+bool read_items(std::string_view data, size_t &pos, uint64_t count,
+                msgpack_value &out, int depth) {
+  if (out.kind_ == msgpack_value::kind::map) {
+    if (count > (data.size() - pos) / 2) {
+      return false;
+    }
+    count *= 2;
+  } else if (count > data.size() - pos) {
+    return false;
+  }
+  out.items_.resize(count);
+  for (auto &item : out.items_) {
+    if (!read_value(data, pos, item, depth + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool read_value(std::string_view data, size_t &pos, msgpack_value &out,
+                int depth) {
+  using kind = msgpack_value::kind;
+  if (pos >= data.size() || depth > max_depth) {
+    return false;
+  }
+  auto byte = uint8_t(data[pos++]);
+  uint64_t value = 0;
+
+  auto read_string = [&](uint64_t size) {
+    if (size > data.size() - pos) {
+      return false;
+    }
+    out.kind_ = kind::string;
+    out.string_ = data.substr(pos, size);
+    pos += size;
+    return true;
+  };
+  auto read_signed = [&](size_t size) {
+    if (!read_be(data, pos, size, value)) {
+      return false;
+    }
+    // Sign extend
+    size_t shift = 64 - 8 * size;
+    out.kind_ = kind::integer;
+    out.integer_ = uint64_t(int64_t(value << shift) >> shift);
+    return true;
+  };
+
+  if (byte <= 0x7f) {
+    out.kind_ = kind::integer;
+    out.integer_ = byte;
+    return true;
+  }
+  if (byte >= 0xe0) {
+    out.kind_ = kind::integer;
+    out.integer_ = uint64_t(int64_t(int8_t(byte)));
+    return true;
+  }
+  if ((byte & 0xf0) == 0x80) {
+    out.kind_ = kind::map;
+    return read_items(data, pos, byte & 0x0f, out, depth);
+  }
+  if ((byte & 0xf0) == 0x90) {
+    out.kind_ = kind::array;
+    return read_items(data, pos, byte & 0x0f, out, depth);
+  }
+  if ((byte & 0xe0) == 0xa0) {
+    return read_string(byte & 0x1f);
+  }
+
+  switch (byte) {
+  case 0xc0:
+    out.kind_ = kind::nil;
+    return true;
+  case 0xc2:
+  case 0xc3:
+    out.kind_ = kind::boolean;
+    out.integer_ = byte & 1;
+    return true;
+  case 0xc4: // bin 8, 16, 32
+  case 0xc5:
+  case 0xc6:
+    return read_be(data, pos, size_t(1) << (byte - 0xc4), value) &&
+           read_string(value);
+  case 0xc7: // ext 8, 16, 32
+  case 0xc8:
+  case 0xc9:
+    if (!read_be(data, pos, size_t(1) << (byte - 0xc7), value) ||
+        value >= data.size() - pos) {
+      return false;
+    }
+    pos += value + 1; // Type byte and data
+    out.kind_ = kind::nil;
+    return true;
+  case 0xca: {
+    float f;
+    if (!read_be(data, pos, 4, value)) {
+      return false;
+    }
+    auto bits = uint32_t(value);
+    std::memcpy(&f, &bits, sizeof(f));
+    out.kind_ = kind::floating;
+    out.floating_ = f;
+    return true;
+  }
+  case 0xcb:
+    if (!read_be(data, pos, 8, value)) {
+      return false;
+    }
+    out.kind_ = kind::floating;
+    std::memcpy(&out.floating_, &value, sizeof(value));
+    return true;
+  case 0xcc: // uint 8, 16, 32, 64
+  case 0xcd:
+  case 0xce:
+  case 0xcf:
+    out.kind_ = kind::integer;
+    return read_be(data, pos, size_t(1) << (byte - 0xcc), out.integer_);
+  case 0xd0: // int 8, 16, 32, 64
+  case 0xd1:
+  case 0xd2:
+  case 0xd3:
+    return read_signed(size_t(1) << (byte - 0xd0));
+  case 0xd4: // fixext 1, 2, 4, 8, 16
+  case 0xd5:
+  case 0xd6:
+  case 0xd7:
+  case 0xd8:
+    value = uint64_t(1) << (byte - 0xd4);
+    if (value >= data.size() - pos) {
+      return false;
+    }
+    pos += value + 1;
+    out.kind_ = kind::nil;
+    return true;
+  case 0xd9: // str 8, 16, 32
+  case 0xda:
+  case 0xdb:
+    return read_be(data, pos, size_t(1) << (byte - 0xd9), value) &&
+           read_string(value);
+  case 0xdc: // array 16, 32
+  case 0xdd:
+    out.kind_ = kind::array;
+    return read_be(data, pos, size_t(2) << (byte - 0xdc), value) &&
+           read_items(data, pos, value, out, depth);
+  case 0xde: // map 16, 32
+  case 0xdf:
+    out.kind_ = kind::map;
+    return read_be(data, pos, size_t(2) << (byte - 0xde), value) &&
+           read_items(data, pos, value, out, depth);
+  default:
+    return false; // 0xc1 is never used
+  }
+}
+
+uint64_t get_integer(const msgpack_value &map, std::string_view key) {
+  auto value = map.find(key);
+  return (value != nullptr && value->kind_ == msgpack_value::kind::integer)
+             ? value->integer_
+             : 0;
+}
+
+std::string get_string(const msgpack_value &map, std::string_view key) {
+  auto value = map.find(key);
+  return (value != nullptr && value->kind_ == msgpack_value::kind::string)
+             ? std::string(value->string_)
+             : std::string();
+}
+
+// Descriptor of the AMDGPU metadata note in a note section, empty if none
+std::string_view find_metadata(std::string_view notes) {
+  auto align = [](size_t size) { return (size + 3) & ~size_t(3); };
+  size_t pos = 0;
+  while (notes.size() - pos >= sizeof(Elf64_Nhdr)) {
+    Elf64_Nhdr header;
+    std::memcpy(&header, notes.data() + pos, sizeof(header));
+    pos += sizeof(header);
+    size_t name_size = align(header.n_namesz);
+    size_t desc_size = align(header.n_descsz);
+    if (name_size > notes.size() - pos ||
+        desc_size > notes.size() - pos - name_size) {
+      return std::string_view();
+    }
+    auto name = notes.substr(pos, header.n_namesz);
+    auto desc = notes.substr(pos + name_size, header.n_descsz);
+    pos += name_size + desc_size;
+    if (header.n_type == nt_amdgpu_metadata &&
+        name.substr(0, name.find('\0')) == note_name) {
+      return desc;
+    }
+  }
+  return std::string_view();
+}
+} // namespace
+
+bool get_kernels(const std::vector<char> &object,
+                 std::vector<kernel_info> &kernels) {
+  if (object.size() < sizeof(Elf64_Ehdr) ||
+      std::memcmp(object.data(), ELFMAG, SELFMAG) != 0 ||
+      object[EI_CLASS] != ELFCLASS64) {
+    return false;
+  }
+  Elf64_Ehdr ehdr;
+  std::memcpy(&ehdr, object.data(), sizeof(ehdr));
+
+  std::string_view metadata;
+  for (size_t i = 0; i < ehdr.e_shnum && metadata.empty(); i++) {
+    size_t offset = ehdr.e_shoff + i * sizeof(Elf64_Shdr);
+    if (offset < ehdr.e_shoff || offset > object.size() ||
+        object.size() - offset < sizeof(Elf64_Shdr)) {
+      return false;
+    }
+    Elf64_Shdr section;
+    std::memcpy(&section, object.data() + offset, sizeof(section));
+    if (section.sh_type != SHT_NOTE || section.sh_offset > object.size() ||
+        section.sh_size > object.size() - section.sh_offset) {
+      continue;
+    }
+    metadata = find_metadata(std::string_view(
+        object.data() + section.sh_offset, section.sh_size));
+  }
+
+  msgpack_value root;
+  size_t pos = 0;
+  if (metadata.empty() || !read_value(metadata, pos, root, 0)) {
+    return false;
+  }
+  auto list = root.find("amdhsa.kernels");
+  if (list == nullptr || list->kind_ != msgpack_value::kind::array) {
+    return false;
+  }
+
+  kernels.clear();
+  kernels.reserve(list->items_.size());
+  for (auto &map : list->items_) {
+    kernel_info kernel;
+    kernel.name_ = get_string(map, ".name");
+    kernel.symbol_ = get_string(map, ".symbol");
+    kernel.vgpr_count_ = get_integer(map, ".vgpr_count");
+    kernel.sgpr_count_ = get_integer(map, ".sgpr_count");
+    kernel.agpr_count_ = get_integer(map, ".agpr_count");
+    kernel.vgpr_spill_count_ = get_integer(map, ".vgpr_spill_count");
+    kernel.sgpr_spill_count_ = get_integer(map, ".sgpr_spill_count");
+    kernel.group_segment_size_ = get_integer(map, ".group_segment_fixed_size");
+    kernel.private_segment_size_ =
+        get_integer(map, ".private_segment_fixed_size");
+    kernel.max_flat_workgroup_size_ =
+        get_integer(map, ".max_flat_workgroup_size");
+    kernel.wavefront_size_ = get_integer(map, ".wavefront_size");
+    kernel.kernarg_size_ = get_integer(map, ".kernarg_segment_size");
+    kernel.kernarg_align_ = get_integer(map, ".kernarg_segment_align");
+    if (auto args = map.find(".args");
+        args != nullptr && args->kind_ == msgpack_value::kind::array) {
+      for (auto &arg_map : args->items_) {
+        kernel_arg arg;
+        arg.name_ = get_string(arg_map, ".name");
+        arg.value_kind_ = get_string(arg_map, ".value_kind");
+        arg.offset_ = get_integer(arg_map, ".offset");
+        arg.size_ = get_integer(arg_map, ".size");
+        kernel.args_.push_back(std::move(arg));
+      }
+    }
+    if (!kernel.name_.empty()) {
+      kernels.push_back(std::move(kernel));
+    }
+  }
+  return true;
+}
+} // namespace code_object
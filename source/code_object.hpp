@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Kernel argument of the kernarg segment
+struct kernel_arg {
+  std::string name_;       // Name in the source, empty for hidden arguments
+  std::string value_kind_; // e.g. by_value, global_buffer, hidden_block_count_x
+  uint64_t offset_ = 0;    // Offset in the kernarg segment
+  uint64_t size_ = 0;      // Size in bytes
+};
+
+// Resources of a kernel as recorded by the compiler in the code object
+struct kernel_info {
+  std::string name_;   // Kernel name, mangled unless extern "C"
+  std::string symbol_; // Kernel descriptor symbol, name_ + ".kd"
+  uint64_t vgpr_count_ = 0;
+  uint64_t sgpr_count_ = 0;
+  uint64_t agpr_count_ = 0;
+  uint64_t vgpr_spill_count_ = 0;
+  uint64_t sgpr_spill_count_ = 0;
+  uint64_t group_segment_size_ = 0;   // LDS per workgroup
+  uint64_t private_segment_size_ = 0; // Scratch per work item
+  uint64_t max_flat_workgroup_size_ = 0;
+  uint64_t wavefront_size_ = 0;
+  uint64_t kernarg_size_ = 0;
+  uint64_t kernarg_align_ = 0;
+  std::vector<kernel_arg> args_;
+};
+
+namespace code_object {
+/**
+ * @brief Read the kernels of an AMDGPU code object
+ *
+ * Parses the AMDGPU metadata note, msgpack of code object v3 and later,
+ * without comgr or a device, so it works on machines without a GPU.
+ *
+ * @param object executable ELF code object
+ * @param kernels filled with one entry per kernel, in metadata order
+ * @return true success
+ * @return false not an ELF, no metadata note or malformed metadata
+ */
+bool get_kernels(const std::vector<char> &object,
+                 std::vector<kernel_info> &kernels);
+} // namespace code_object
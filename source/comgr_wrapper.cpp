@@ -1,6 +1,54 @@
 #include "comgr_wrapper.hpp"
 #include <algorithm>
 
+namespace {
+// Actions a thread asked for last, least recently used first. Only the owning
+// thread touches an action, so none of them is ever used concurrently.
+class action_cache {
+public:
+  ~action_cache() {
+    for (auto &entry : entries_) {
+      (void)amd_comgr_destroy_action_info(entry.action_);
+    }
+  }
+
+  bool get(amd_comgr_action_info_t &action, const std::string &isa_name,
+           const std::vector<std::string> &options) {
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [&](const entry &e) {
+                             return e.isa_name_ == isa_name &&
+                                    e.options_ == options;
+                           });
+    if (it != entries_.end()) {
+      std::rotate(it, it + 1, entries_.end());
+      action = entries_.back().action_;
+      return true;
+    }
+
+    if (!create_action(action, isa_name, options)) {
+      return false;
+    }
+    if (entries_.size() == capacity) {
+      (void)amd_comgr_destroy_action_info(entries_.front().action_);
+      entries_.erase(entries_.begin());
+    }
+    entries_.push_back(entry{isa_name, options, action});
+    return true;
+  }
+
+private:
+  // Enough for front end, code generation and link of a few targets
+  static constexpr size_t capacity = 8;
+
+  struct entry {
+    std::string isa_name_;
+    std::vector<std::string> options_;
+    amd_comgr_action_info_t action_;
+  };
+  std::vector<entry> entries_;
+};
+} // namespace
+
 /**
  * @brief Create a data object which holds source for comgr
  *
@@ -79,4 +127,131 @@ bool create_action(amd_comgr_action_info_t &action, const std::string &isa_name,
   }
 
   return true;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Get an action, created on first use by this thread
+ *
+ * Language, isa and option list are only set once per thread and key.
+ *
+ * @param action reference to action object to be set
+ * @param isa_name isa name in amdgcn-amd-amdhsa--gfxnnn:features
+ * @param options compiler options to be passed
+ * @return true
+ * @return false
+ */
+bool get_action(amd_comgr_action_info_t &action, const std::string &isa_name,
+                const std::vector<std::string> &options) {
+  thread_local action_cache cache;
+  return cache.get(action, isa_name, options);
+}
+
+/**
+ * @brief Create a data object and add it to a data set
+ *
+ * @param data_set data set to add to
+ * @param kind Kind of data
+ * @param src Source to be input
+ * @param src_len Length of src
+ * @param name Name
+ * @return true Success
+ * @return false Failed
+ */
+bool add_data(amd_comgr_data_set_t &data_set, amd_comgr_data_kind_t kind,
+              const char *src, size_t src_len, const char *name) {
+  amd_comgr_data_t data;
+  if (!create_data(data, kind, src, src_len, name)) {
+    return false;
+  }
+
+  if (auto comgr_res = amd_comgr_data_set_add(data_set, data);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    (void)amd_comgr_release_data(data);
+    return false;
+  }
+
+  // Data set holds its own reference
+  (void)amd_comgr_release_data(data);
+  return true;
+}
+
+/**
+ * @brief Copy out the first data object of a kind in a data set
+ *
+ * @param data_set data set, usually output of an action
+ * @param kind Kind of data
+ * @param out bytes of the data object
+ * @return true Success
+ * @return false Failed or data object is empty
+ */
+bool get_data(amd_comgr_data_set_t &data_set, amd_comgr_data_kind_t kind,
+              std::vector<char> &out) {
+  amd_comgr_data_t data;
+  if (auto comgr_res = amd_comgr_action_data_get_data(data_set, kind, 0, &data);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    return false;
+  }
+
+  size_t size = 0;
+  if (auto comgr_res = amd_comgr_get_data(data, &size, NULL);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS || size == 0) {
+    (void)amd_comgr_release_data(data);
+    return false;
+  }
+
+  out.resize(size);
+  if (auto comgr_res = amd_comgr_get_data(data, &size, out.data());
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    (void)amd_comgr_release_data(data);
+    out.clear();
+    return false;
+  }
+
+  (void)amd_comgr_release_data(data);
+  return true;
+}
+
+/**
+ * @brief Get the log an action left in its output data set
+ *
+ * @param data_set output of an action
+ * @return std::string log, empty if there is none
+ */
+std::string get_build_log(amd_comgr_data_set_t &data_set) {
+  size_t count = 0;
+  if (auto comgr_res = amd_comgr_action_data_count(
+          data_set, AMD_COMGR_DATA_KIND_LOG, &count);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    return "";
+  }
+
+  if (count > 0) {
+    amd_comgr_data_t binary_data;
+
+    if (auto res = amd_comgr_action_data_get_data(
+            data_set, AMD_COMGR_DATA_KIND_LOG, 0, &binary_data);
+        res != AMD_COMGR_STATUS_SUCCESS) {
+      return "";
+    }
+
+    size_t binary_size = 0;
+    if (auto res = amd_comgr_get_data(binary_data, &binary_size, NULL);
+        res != AMD_COMGR_STATUS_SUCCESS) {
+      (void)amd_comgr_release_data(binary_data);
+      return "";
+    }
+
+    std::string log(binary_size, 0);
+
+    if (auto res = amd_comgr_get_data(binary_data, &binary_size, log.data());
+        res != AMD_COMGR_STATUS_SUCCESS) {
+      (void)amd_comgr_release_data(binary_data);
+      return "";
+    }
+
+    (void)amd_comgr_release_data(binary_data);
+    return log;
+  } else {
+    return "";
+  }
+}
@@ -10,3 +10,27 @@ bool create_data(amd_comgr_data_t &data, amd_comgr_data_kind_t kind,
 
 bool create_action(amd_comgr_action_info_t &action, const std::string &isa_name,
                    const std::vector<std::string> &options);
+
+/**
+ * @brief Get an action for isa and options from a cache of the calling thread
+ *
+ * The action is owned by the cache and must not be destroyed. It stays valid
+ * until the thread exits or asks for a few other actions, so it is only used
+ * before the next get_action of the same thread.
+ *
+ * @param action reference to action object to be set
+ * @param isa_name isa name in amdgcn-amd-amdhsa--gfxnnn:features
+ * @param options compiler options to be passed
+ * @return true
+ * @return false
+ */
+bool get_action(amd_comgr_action_info_t &action, const std::string &isa_name,
+                const std::vector<std::string> &options);
+
+bool add_data(amd_comgr_data_set_t &data_set, amd_comgr_data_kind_t kind,
+              const char *src, size_t src_len, const char *name);
+
+bool get_data(amd_comgr_data_set_t &data_set, amd_comgr_data_kind_t kind,
+              std::vector<char> &out);
+
+std::string get_build_log(amd_comgr_data_set_t &data_set);
@@ -0,0 +1,255 @@
+#include "compile_daemon.hpp"
+#include "env.hpp"
+#include "ipc.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+// Bumped whenever the request or result layout changes
+constexpr uint64_t protocol_version = 2;
+
+// Set in the daemon, which compiles itself instead of connecting to itself
+std::atomic<bool> serving{false};
+
+bool make_address(const std::string &path, sockaddr_un &address) {
+  address = sockaddr_un{};
+  address.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+    return false;
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+int connect_to(const std::string &path) {
+  sockaddr_un address;
+  if (!make_address(path, address)) {
+    return -1;
+  }
+  int socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (socket < 0) {
+    return -1;
+  }
+  if (::connect(socket, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) != 0) {
+    close(socket);
+    return -1;
+  }
+  return socket;
+}
+
+// Compilation of one key, shared by all clients asking for it meanwhile
+struct in_flight {
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool done_ = false;
+  bool success_ = false;
+  std::shared_ptr<const cache_entry> entry_;
+  std::string log_;
+};
+
+std::mutex in_flight_mutex;
+std::unordered_map<std::string, std::shared_ptr<in_flight>> in_flight_compiles;
+
+// Compile once per key, later requests for a key in flight wait for it
+bool compile_deduplicated(const hiprtc_program &prog,
+                          const std::string &isa_name,
+                          const std::vector<std::string> &options,
+                          std::shared_ptr<const cache_entry> &out,
+                          std::string &log, compile_stats &stats) {
+  auto key = get_compile_key(&prog, isa_name, options);
+  std::shared_ptr<in_flight> compile;
+  bool owner = false;
+  {
+    std::lock_guard<std::mutex> lock(in_flight_mutex);
+    auto &slot = in_flight_compiles[key];
+    if (slot == nullptr) {
+      slot = std::make_shared<in_flight>();
+      owner = true;
+    }
+    compile = slot;
+  }
+
+  if (!owner) {
+    std::unique_lock<std::mutex> lock(compile->mutex_);
+    compile->cv_.wait(lock, [&] { return compile->done_; });
+    stats.cache_hits_++;
+    out = compile->entry_;
+    log = compile->log_;
+    return compile->success_;
+  }
+
+  bool success = compile_for_isa(&prog, isa_name, options, out, log, stats);
+  {
+    std::lock_guard<std::mutex> lock(compile->mutex_);
+    compile->done_ = true;
+    compile->success_ = success;
+    compile->entry_ = out;
+    compile->log_ = log;
+  }
+  compile->cv_.notify_all();
+
+  std::lock_guard<std::mutex> lock(in_flight_mutex);
+  in_flight_compiles.erase(key);
+  return success;
+}
+
+// Answer the requests of one client until it disconnects
+void serve_client(int socket) {
+  while (true) {
+    int request_fd = recv_fd(socket);
+    if (request_fd < 0) {
+      break;
+    }
+
+    shared_region request;
+    hiprtc_program prog;
+    std::string isa_name, log;
+    std::vector<std::string> options;
+    std::shared_ptr<const cache_entry> entry;
+    compile_stats stats;
+    bool success = false;
+    uint64_t version = 0;
+    if (!request.open(request_fd)) {
+      log = "Failed to map the request to the compile daemon, it has to be "
+            "sealed\n";
+    } else {
+      message_reader reader(request.data(), request.size());
+      if (!reader.get(version) || version != protocol_version) {
+        log = "Compile daemon speaks protocol version " +
+              std::to_string(protocol_version) + ", client " +
+              std::to_string(version) + "\n";
+      } else if (!read_program(reader, isa_name, prog, options)) {
+        log = "Malformed request to the compile daemon\n";
+      } else {
+        auto start = stats_clock::now();
+        success = compile_deduplicated(prog, isa_name, options, entry, log,
+                                       stats);
+        stats.total_ms_ = elapsed_ms(start);
+      }
+    }
+
+    cache_entry failed;
+    failed.log_ = log;
+    shared_region response;
+    if (!write_message(response, [&](message_writer &writer) {
+          write_result(writer, success, success ? *entry : failed, stats);
+        }) ||
+        !send_fd(socket, response.fd())) {
+      break;
+    }
+  }
+  close(socket);
+}
+} // namespace
+
+namespace compile_daemon {
+int connect() {
+  static const std::string path = get_env("HIPRTC_DAEMON_SOCKET");
+  if (path.empty() || serving) {
+    return -1;
+  }
+  return connect_to(path);
+}
+
+bool compile(int socket, const hiprtc_program *prog,
+             const std::string &isa_name,
+             const std::vector<std::string> &options, cache_entry &out,
+             compile_stats &stats) {
+  shared_region request;
+  bool written = write_message(request, [&](message_writer &writer) {
+    writer.put(protocol_version);
+    write_program(writer, prog, isa_name, options);
+  });
+  int response_fd = written ? exchange(socket, request) : -1;
+  close(socket);
+  if (response_fd < 0) {
+    out.log_ += "Compile daemon did not answer\n";
+    return false;
+  }
+
+  shared_region response;
+  if (!response.open(response_fd)) {
+    out.log_ += "Failed to map the response of the compile daemon\n";
+    return false;
+  }
+  // total_ms_ of the daemon is not part of this process's wall time
+  compile_stats daemon_stats;
+  bool success = false;
+  message_reader reader(response.data(), response.size());
+  if (!read_result(reader, success, out, daemon_stats)) {
+    out.log_ += "Malformed response of the compile daemon\n";
+    return false;
+  }
+  daemon_stats.total_ms_ = 0;
+  stats += daemon_stats;
+  return success;
+}
+
+int serve(const std::string &path) {
+  serving = true;
+
+  sockaddr_un address;
+  if (!make_address(path, address)) {
+    std::cerr << "Invalid socket path: " << path << std::endl;
+    return 1;
+  }
+
+  // Only replace the socket if nobody answers on it
+  if (int socket = connect_to(path); socket >= 0) {
+    close(socket);
+    std::cerr << "A compile daemon is already listening on " << path
+              << std::endl;
+    return 1;
+  }
+  unlink(path.c_str());
+
+  // Socket is created owner only, nobody else can connect in the meantime
+  int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  auto mask = umask(0177);
+  bool bound = listener >= 0 &&
+               bind(listener, reinterpret_cast<sockaddr *>(&address),
+                    sizeof(address)) == 0;
+  umask(mask);
+  if (!bound || listen(listener, SOMAXCONN) != 0) {
+    std::cerr << "Can not listen on " << path << ": " << std::strerror(errno)
+              << std::endl;
+    return 1;
+  }
+
+  while (true) {
+    int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      std::cerr << "Failed to accept: " << std::strerror(errno) << std::endl;
+      return 1;
+    }
+
+    // Options such as -Xclang -load run code in here, only serve this user
+    ucred peer{};
+    socklen_t peer_size = sizeof(peer);
+    if (getsockopt(client, SOL_SOCKET, SO_PEERCRED, &peer, &peer_size) != 0 ||
+        peer.uid != geteuid()) {
+      std::cerr << "Rejected a client of another user" << std::endl;
+      close(client);
+      continue;
+    }
+    std::thread(serve_client, client).detach();
+  }
+}
+} // namespace compile_daemon
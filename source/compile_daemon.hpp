@@ -0,0 +1,48 @@
+#pragma once
+
+#include "hiprtc_internal.hpp"
+
+#include <string>
+#include <vector>
+
+namespace compile_daemon {
+/**
+ * @brief Connect to the daemon listening on HIPRTC_DAEMON_SOCKET
+ *
+ * @return int connection, -1 if the variable is unset, no daemon is
+ * listening or this process is the daemon
+ */
+int connect();
+
+/**
+ * @brief Compile a program for one isa in the daemon
+ *
+ * The daemon answers from its caches, or waits for an identical compilation
+ * already in flight, before compiling itself.
+ *
+ * @param socket connection from connect, closed here
+ * @param prog program, not modified
+ * @param isa_name target isa
+ * @param options compile options
+ * @param out code object, bitcode, lowered names and log
+ * @param stats phases of the compilation in the daemon are added
+ * @return true success
+ * @return false failure, out.log_ has the reason
+ */
+bool compile(int socket, const hiprtc_program *prog,
+             const std::string &isa_name,
+             const std::vector<std::string> &options, cache_entry &out,
+             compile_stats &stats);
+
+/**
+ * @brief Serve clients on a unix socket until the process is killed
+ *
+ * Main loop of hiprtc-daemon. The socket is only accessible to its owner and
+ * clients of other users are turned away, as compile options can load code
+ * into the daemon. Requests have to be sealed, see shared_region::seal.
+ *
+ * @param path path of the socket, replaced if stale
+ * @return int exit code
+ */
+int serve(const std::string &path);
+} // namespace compile_daemon
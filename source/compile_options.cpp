@@ -0,0 +1,224 @@
+#include "compile_options.hpp"
+
+#include <algorithm>
+#include <map>
+#include <string_view>
+#include <utility>
+
+namespace compile_options {
+namespace {
+// Handled later by target::resolve and select_internal_modules
+constexpr std::string_view passed_options[] = {
+    "--offload-arch=", "--gpu-architecture=", "--hiprtc-modules="};
+
+constexpr std::string_view optimization_levels[] = {"0", "1", "2", "3",
+                                                    "s", "z", "fast"};
+
+constexpr std::string_view debug_levels[] = {
+    "-g", "-g0", "-g1", "-g2", "-g3", "-gline-tables-only",
+    "-gline-directives-only"};
+
+// Flags without a value that are neither -f, -m nor -W
+constexpr std::string_view plain_flags[] = {"-nogpuinc", "-nogpulib", "-w",
+                                            "-save-temps", "-v"};
+
+// Options with a joined value that are neither -f nor -m, the last one wins
+constexpr std::string_view value_options[] = {"--gpu-max-threads-per-block="};
+
+// -f flags whose occurrences add to or take from a list instead of replacing
+// each other, -fsanitize=address -fsanitize=undefined enables both
+constexpr std::string_view list_flags[] = {
+    "-fsanitize", "-fno-sanitize", "-fdebug-prefix-map=", "-ffile-prefix-map=",
+    "-fmacro-prefix-map=", "-fprofile-list="};
+
+template <size_t N>
+bool is_one_of(std::string_view option, const std::string_view (&list)[N]) {
+  return std::find(std::begin(list), std::end(list), option) != std::end(list);
+}
+
+bool starts_with(std::string_view str, std::string_view prefix) {
+  return str.substr(0, prefix.size()) == prefix;
+}
+
+bool is_identifier(std::string_view name) {
+  if (name.empty() || (name[0] >= '0' && name[0] <= '9')) {
+    return false;
+  }
+  return std::all_of(name.begin(), name.end(), [](char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+  });
+}
+
+// Macro of a -D or -U value: NAME, NAME=value or NAME(args)=value
+std::string_view get_macro_name(std::string_view value) {
+  return value.substr(0, value.find_first_of("=("));
+}
+
+// -fno-x, -fx and -fx=value all set x, same for -m
+std::string get_flag_name(std::string_view flag) {
+  auto name = flag.substr(2, flag.find('=') - 2);
+  if (starts_with(name, "no-")) {
+    name.remove_prefix(3);
+  }
+  return std::string(flag.substr(0, 2)) + std::string(name);
+}
+
+// Repeating an option does nothing beyond its last occurrence
+void put_last(std::vector<std::string> &list, std::string option) {
+  list.erase(std::remove(list.begin(), list.end(), option), list.end());
+  list.push_back(std::move(option));
+}
+} // namespace
+
+bool canonicalize(std::vector<std::string> &options, std::string &log) {
+  std::string optimization, standard, debug;
+  std::vector<std::string> passed, plain, search_paths, includes, warnings;
+  std::vector<std::string> llvm_options, clang_options, list_options;
+  std::vector<std::pair<std::string, std::string>> flags; // Name, option
+  std::map<std::string, std::string, std::less<>> macros;  // Name, option
+
+  for (size_t i = 0; i < options.size(); i++) {
+    std::string_view option = options[i];
+
+    // Options taking the next one as value, some also take it joined
+    auto get_value = [&](std::string_view name, bool joined,
+                         std::string &value) {
+      if (option.size() > name.size() && joined) {
+        value = option.substr(name.size());
+        return true;
+      }
+      if (option.size() > name.size() || i + 1 == options.size()) {
+        return false;
+      }
+      value = options[++i];
+      return !value.empty();
+    };
+    std::string value;
+
+    if (std::any_of(std::begin(passed_options), std::end(passed_options),
+                    [&](std::string_view opt) {
+                      return starts_with(option, opt);
+                    })) {
+      passed.push_back(options[i]);
+    } else if (option == "-O") {
+      optimization = "-O1"; // What clang takes a bare -O for
+    } else if (starts_with(option, "-O")) {
+      if (!is_one_of(option.substr(2), optimization_levels)) {
+        log = "Unknown optimization level: " + options[i] + "\n";
+        return false;
+      }
+      optimization = options[i];
+    } else if (starts_with(option, "-std=") || starts_with(option, "--std=")) {
+      auto version = option.substr(option.find('=') + 1);
+      if (!starts_with(version, "c++") && !starts_with(version, "gnu++")) {
+        log = "Unknown language standard: " + options[i] + "\n";
+        return false;
+      }
+      standard = "-std=" + std::string(version);
+    } else if (is_one_of(option, debug_levels)) {
+      debug = options[i];
+    } else if (is_one_of(option, plain_flags)) {
+      put_last(plain, options[i]);
+    } else if (starts_with(option, "-D") || starts_with(option, "-U")) {
+      auto kind = std::string(option.substr(0, 2));
+      if (!get_value(kind, true, value) ||
+          !is_identifier(get_macro_name(value))) {
+        log = "Invalid macro option: " + options[i] + "\n";
+        return false;
+      }
+      macros[std::string(get_macro_name(value))] = kind + value;
+    } else if (starts_with(option, "-isystem") || starts_with(option, "-I")) {
+      auto kind = std::string(starts_with(option, "-I") ? "-I" : "-isystem");
+      if (!get_value(kind, true, value)) {
+        log = "Missing directory of option: " + options[i] + "\n";
+        return false;
+      }
+      // First one of a directory decides where it is searched
+      if (std::find(search_paths.begin(), search_paths.end(), kind + value) ==
+          search_paths.end()) {
+        search_paths.push_back(kind + value);
+      }
+    } else if (option == "-include") {
+      if (!get_value(option, false, value)) {
+        log = "Missing file of option: -include\n";
+        return false;
+      }
+      includes.push_back(value);
+    } else if (option == "-mllvm" || option == "-Xclang") {
+      if (!get_value(option, false, value)) {
+        log = "Missing value of option: " + options[i] + "\n";
+        return false;
+      }
+      if (option == "-mllvm") {
+        put_last(llvm_options, value); // LLVM rejects a repeated option
+      } else {
+        clang_options.push_back(value); // Values may span several -Xclang
+      }
+    } else if (std::any_of(std::begin(list_flags), std::end(list_flags),
+                           [&](std::string_view flag) {
+                             return starts_with(option, flag);
+                           })) {
+      put_last(list_options, options[i]);
+    } else if (std::any_of(std::begin(value_options), std::end(value_options),
+                           [&](std::string_view opt) {
+                             return starts_with(option, opt) &&
+                                    option.size() > opt.size();
+                           }) ||
+               ((starts_with(option, "-f") || starts_with(option, "-m")) &&
+                option.size() > 2)) {
+      auto name = starts_with(option, "--")
+                      ? std::string(option.substr(0, option.find('=')))
+                      : get_flag_name(option);
+      flags.erase(std::remove_if(flags.begin(), flags.end(),
+                                 [&](auto &flag) { return flag.first == name; }),
+                  flags.end());
+      flags.emplace_back(name, options[i]);
+    } else if ((starts_with(option, "-W") || starts_with(option, "-R")) &&
+               option.size() > 2) {
+      put_last(warnings, options[i]); // Remarks go with the warnings
+    } else {
+      log = "Unknown option: " + options[i] + "\n";
+      return false;
+    }
+  }
+
+  std::vector<std::string> canonical = std::move(passed);
+  for (auto *single : {&optimization, &standard, &debug}) {
+    if (!single->empty()) {
+      canonical.push_back(*single);
+    }
+  }
+  canonical.insert(canonical.end(), plain.begin(), plain.end());
+  for (auto &macro : macros) {
+    canonical.push_back(macro.second);
+  }
+  for (auto &path : search_paths) {
+    if (starts_with(path, "-isystem")) {
+      canonical.push_back("-isystem");
+      canonical.push_back(path.substr(8));
+    } else {
+      canonical.push_back(path);
+    }
+  }
+  for (auto &include : includes) {
+    canonical.push_back("-include");
+    canonical.push_back(include);
+  }
+  for (auto &flag : flags) {
+    canonical.push_back(flag.second);
+  }
+  canonical.insert(canonical.end(), list_options.begin(), list_options.end());
+  canonical.insert(canonical.end(), warnings.begin(), warnings.end());
+  for (auto &llvm_option : llvm_options) {
+    canonical.push_back("-mllvm");
+    canonical.push_back(llvm_option);
+  }
+  for (auto &clang_option : clang_options) {
+    canonical.push_back("-Xclang");
+    canonical.push_back(clang_option);
+  }
+  options = std::move(canonical);
+  return true;
+}
+} // namespace compile_options
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace compile_options {
+/**
+ * @brief Check compile options and rewrite them in a canonical form
+ *
+ * Options that mean the same compile come out the same, so caches key on
+ * what is compiled and not on how it was spelled:
+ * - -O, -std and -g keep the last one given, -O0 overrides the default -O3,
+ *   -O is -O1 and --std= is -std=
+ * - -f and -m flags keep the last of a flag and its -fno-/-mno- form, except
+ *   list valued ones such as -fsanitize= and -fno-sanitize= which keep their
+ *   order and only drop exact repeats
+ * - --gpu-max-threads-per-block= keeps the last one given
+ * - -D and -U keep the last one per macro and are sorted by macro name,
+ *   "-D NAME" becomes "-DNAME"
+ * - exact repeats of other flags are dropped
+ * Options whose order matters, -I, -include, -W, -R, -mllvm and -Xclang, keep
+ * it.
+ * Target and header module options are only checked to have a value.
+ *
+ * @param options compile options, default ones first then user ones
+ * @param log names the first option that is rejected
+ * @return true success
+ * @return false an option is unknown or misses its value
+ */
+bool canonicalize(std::vector<std::string> &options, std::string &log);
+} // namespace compile_options
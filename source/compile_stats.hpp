@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+using stats_clock = std::chrono::steady_clock;
+
+inline double elapsed_ms(stats_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(stats_clock::now() - start)
+      .count();
+}
+
+/**
+ * @brief Time and bytes spent in each phase of a compilation
+ *
+ * Phases of several targets compiled in parallel add up, so their sum can
+ * exceed total_ms_.
+ */
+struct compile_stats {
+  double total_ms_ = 0;    // Wall time of the compilation
+  double target_ms_ = 0;   // Target resolution, includes rocm_smi
+  double cache_ms_ = 0;    // Code object and bitcode cache lookups and stores
+  double pch_ms_ = 0;      // Getting or building the precompiled header
+  double dataset_ms_ = 0;  // Building comgr data sets
+  double frontend_ms_ = 0; // Source to bitcode
+  double codegen_ms_ = 0;  // Bitcode to relocatable
+  double link_ms_ = 0;     // Relocatable to executable
+  double extract_ms_ = 0;  // Copying outputs out of comgr
+  double lowering_ms_ = 0; // Lowering name expressions
+  double bundle_ms_ = 0;   // Offload bundle of several targets
+  size_t source_bytes_ = 0;  // Source, with name expression code
+  size_t header_bytes_ = 0;  // Headers given to the program
+  size_t bitcode_bytes_ = 0; // Bitcode of all targets
+  size_t object_bytes_ = 0;  // Final code
+  size_t cache_hits_ = 0;    // Targets served from the code object cache
+  size_t bitcode_cache_hits_ = 0; // Targets that skipped the front end
+  size_t pch_hits_ = 0; // Front ends on a precompiled header built before
+
+  compile_stats &operator+=(const compile_stats &other) {
+    total_ms_ += other.total_ms_;
+    target_ms_ += other.target_ms_;
+    cache_ms_ += other.cache_ms_;
+    pch_ms_ += other.pch_ms_;
+    dataset_ms_ += other.dataset_ms_;
+    frontend_ms_ += other.frontend_ms_;
+    codegen_ms_ += other.codegen_ms_;
+    link_ms_ += other.link_ms_;
+    extract_ms_ += other.extract_ms_;
+    lowering_ms_ += other.lowering_ms_;
+    bundle_ms_ += other.bundle_ms_;
+    source_bytes_ += other.source_bytes_;
+    header_bytes_ += other.header_bytes_;
+    bitcode_bytes_ += other.bitcode_bytes_;
+    object_bytes_ += other.object_bytes_;
+    cache_hits_ += other.cache_hits_;
+    bitcode_cache_hits_ += other.bitcode_cache_hits_;
+    pch_hits_ += other.pch_hits_;
+    return *this;
+  }
+};
+
+/**
+ * @brief Adds its lifetime to a phase of compile_stats
+ *
+ */
+class scoped_timer {
+public:
+  explicit scoped_timer(double &ms) : ms_(ms), start_(stats_clock::now()) {}
+  ~scoped_timer() { ms_ += elapsed_ms(start_); }
+
+  scoped_timer(const scoped_timer &) = delete;
+  scoped_timer &operator=(const scoped_timer &) = delete;
+
+private:
+  double &ms_;
+  stats_clock::time_point start_;
+};
@@ -0,0 +1,165 @@
+#include "compression.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace compression {
+namespace {
+constexpr size_t min_match = 4;
+constexpr size_t max_offset = 65535;
+constexpr size_t hash_bits = 16;
+constexpr size_t max_candidates = 64; // Positions tried per hash chain
+
+uint32_t read32(std::string_view text, size_t pos) {
+  uint32_t value;
+  std::memcpy(&value, text.data() + pos, sizeof(value));
+  return value;
+}
+
+size_t get_hash(uint32_t value) {
+  return (value * 2654435761u) >> (32 - hash_bits);
+}
+
+void put_length(std::string &out, size_t length) {
+  for (; length >= 255; length -= 255) {
+    out += char(255);
+  }
+  out += char(length);
+}
+
+// Literals, then a match unless length is 0
+void put_sequence(std::string &out, std::string_view literals, size_t offset,
+                  size_t length) {
+  size_t match = (length == 0) ? 0 : length - min_match;
+  out += char((std::min<size_t>(literals.size(), 15) << 4) |
+              std::min<size_t>(match, 15));
+  if (literals.size() >= 15) {
+    put_length(out, literals.size() - 15);
+  }
+  out.append(literals);
+  if (length == 0) {
+    return;
+  }
+  out += char(offset & 0xff);
+  out += char(offset >> 8);
+  if (match >= 15) {
+    put_length(out, match - 15);
+  }
+}
+
+bool get_length(std::string_view data, size_t &pos, size_t &length) {
+  uint8_t byte = 255;
+  while (byte == 255) {
+    if (pos == data.size()) {
+      return false;
+    }
+    byte = uint8_t(data[pos++]);
+    length += byte;
+  }
+  return true;
+}
+} // namespace
+
+std::string compress(std::string_view text) {
+  std::string out;
+  out.reserve(text.size() / 2);
+
+  // Latest position of each hash, and the one before per position
+  std::vector<int64_t> head(size_t(1) << hash_bits, -1);
+  std::vector<int64_t> prev(text.size(), -1);
+
+  size_t anchor = 0, pos = 0;
+  while (pos + min_match <= text.size()) {
+    auto value = read32(text, pos);
+    auto hash = get_hash(value);
+    size_t best_length = 0, best_offset = 0;
+    auto candidate = head[hash];
+    for (size_t tries = 0; candidate >= 0 && tries < max_candidates &&
+                           pos - candidate <= max_offset;
+         tries++, candidate = prev[candidate]) {
+      if (read32(text, candidate) != value) {
+        continue;
+      }
+      size_t length = min_match;
+      while (pos + length < text.size() &&
+             text[candidate + length] == text[pos + length]) {
+        length++;
+      }
+      if (length > best_length) {
+        best_length = length;
+        best_offset = pos - candidate;
+      }
+    }
+    prev[pos] = head[hash];
+    head[hash] = pos;
+
+    if (best_length == 0) {
+      pos++;
+      continue;
+    }
+    put_sequence(out, text.substr(anchor, pos - anchor), best_offset,
+                 best_length);
+
+    // Positions inside the match stay reachable for later ones
+    for (size_t end = pos + best_length, i = pos + 1;
+         i < end && i + min_match <= text.size(); i++) {
+      auto inner = get_hash(read32(text, i));
+      prev[i] = head[inner];
+      head[inner] = i;
+    }
+    pos += best_length;
+    anchor = pos;
+  }
+  put_sequence(out, text.substr(anchor), 0, 0);
+  return out;
+}
+
+bool decompress(std::string_view data, size_t size, std::string &out) {
+  out.resize(size);
+  size_t pos = 0, written = 0;
+  while (pos < data.size()) {
+    auto token = uint8_t(data[pos++]);
+
+    size_t literals = token >> 4;
+    if (literals == 15 && !get_length(data, pos, literals)) {
+      return false;
+    }
+    if (literals > data.size() - pos || literals > size - written) {
+      return false;
+    }
+    std::memcpy(out.data() + written, data.data() + pos, literals);
+    pos += literals;
+    written += literals;
+    if (pos == data.size()) {
+      break; // Last sequence has no match
+    }
+
+    if (data.size() - pos < 2) {
+      return false;
+    }
+    size_t offset = uint8_t(data[pos]) | (size_t(uint8_t(data[pos + 1])) << 8);
+    pos += 2;
+    size_t length = token & 15;
+    if (length == 15 && !get_length(data, pos, length)) {
+      return false;
+    }
+    length += min_match;
+    if (offset == 0 || offset > written || length > size - written) {
+      return false;
+    }
+
+    // A match closer than its length overlaps what it writes
+    if (offset >= length) {
+      std::memcpy(out.data() + written, out.data() + written - offset, length);
+      written += length;
+      continue;
+    }
+    for (size_t i = 0; i < length; i++, written++) {
+      out[written] = out[written - offset];
+    }
+  }
+  return written == size;
+}
+} // namespace compression
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief LZ77 compression of text embedded in the library
+ *
+ * Sequences of a token, literals and a back reference in the layout of LZ4
+ * blocks: the token holds literal and match length nibbles, 15 is followed by
+ * 255 valued extension bytes, offsets are 16 bit little endian. The last
+ * sequence only has literals. Slow to compress, fast to decompress.
+ */
+namespace compression {
+/**
+ * @brief Compress text, used at build time
+ *
+ * @param text input
+ * @return std::string compressed text
+ */
+std::string compress(std::string_view text);
+
+/**
+ * @brief Decompress text from compress
+ *
+ * @param data compressed text
+ * @param size size of the text before compression
+ * @param out decompressed text
+ * @return true success
+ * @return false data is corrupt or not of the given size
+ */
+bool decompress(std::string_view data, size_t size, std::string &out);
+} // namespace compression
@@ -0,0 +1,322 @@
+#include "disk_cache.hpp"
+#include "env.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace disk_cache {
+namespace {
+constexpr size_t default_max_size = size_t(1) << 30; // 1 GiB
+constexpr char entry_magic[8] = {'H', 'I', 'P', 'R', 'T', 'C', 'C', '2'};
+constexpr const char *entry_ext = ".hco";
+
+struct cache_state {
+  std::mutex mutex_;
+  bool configured_ = false;
+  fs::path dir_;                     // empty when disabled
+  size_t max_size_ = default_max_size;
+  size_t size_ = 0;                  // Approximate size of entries in dir_
+  std::atomic<size_t> hits_{0};
+  std::atomic<size_t> misses_{0};
+  std::atomic<size_t> stores_{0};
+  std::atomic<size_t> evictions_{0};
+  std::atomic<size_t> tmp_counter_{0};
+};
+
+cache_state &get_state() {
+  static cache_state state;
+  return state;
+}
+
+void put_u64(std::string &buf, uint64_t value) {
+  buf.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void put_bytes(std::string &buf, const char *data, size_t size) {
+  put_u64(buf, size);
+  buf.append(data, size);
+}
+
+bool get_u64(const std::vector<char> &buf, size_t &pos, uint64_t &value) {
+  if (buf.size() - pos < sizeof(value)) {
+    return false;
+  }
+  std::memcpy(&value, buf.data() + pos, sizeof(value));
+  pos += sizeof(value);
+  return true;
+}
+
+bool get_bytes(const std::vector<char> &buf, size_t &pos, const char *&data,
+               size_t &size) {
+  uint64_t len = 0;
+  if (!get_u64(buf, pos, len) || buf.size() - pos < len) {
+    return false;
+  }
+  data = buf.data() + pos;
+  size = len;
+  pos += len;
+  return true;
+}
+
+std::string serialize(const std::string &key, const cache_entry &entry) {
+  std::string buf;
+  // Code objects leave their bitcode to the bitcode only entry
+  auto bitcode = entry.object_.empty() ? entry.bitcode() : std::string_view();
+  buf.reserve(sizeof(entry_magic) + key.size() + entry.object_.size() +
+              bitcode.size() + entry.log_.size() + 64);
+  buf.append(entry_magic, sizeof(entry_magic));
+  put_bytes(buf, key.data(), key.size());
+  put_bytes(buf, entry.object_.data(), entry.object_.size());
+  put_bytes(buf, bitcode.data(), bitcode.size());
+  put_bytes(buf, entry.log_.data(), entry.log_.size());
+  put_u64(buf, entry.lowered_names_.size());
+  for (auto &name_pair : entry.lowered_names_) {
+    put_bytes(buf, name_pair.first.data(), name_pair.first.size());
+    put_bytes(buf, name_pair.second.data(), name_pair.second.size());
+  }
+  return buf;
+}
+
+bool deserialize(const std::vector<char> &buf, const std::string &key,
+                 cache_entry &entry) {
+  if (buf.size() < sizeof(entry_magic) ||
+      std::memcmp(buf.data(), entry_magic, sizeof(entry_magic)) != 0) {
+    return false;
+  }
+
+  size_t pos = sizeof(entry_magic);
+  const char *data = nullptr;
+  size_t size = 0;
+
+  // Guard against a renamed or colliding file
+  if (!get_bytes(buf, pos, data, size) ||
+      std::string(data, size) != key) {
+    return false;
+  }
+
+  if (!get_bytes(buf, pos, data, size)) {
+    return false;
+  }
+  entry.object_.assign(data, data + size);
+
+  if (!get_bytes(buf, pos, data, size)) {
+    return false;
+  }
+  entry.bitcode_ = (size != 0) ? std::make_shared<const std::vector<char>>(
+                                      data, data + size)
+                                : nullptr;
+
+  // Either a code object or bitcode of a front end only entry
+  if (entry.object_.empty() && entry.bitcode_ == nullptr) {
+    return false;
+  }
+
+  if (!get_bytes(buf, pos, data, size)) {
+    return false;
+  }
+  entry.log_.assign(data, size);
+
+  uint64_t name_count = 0;
+  if (!get_u64(buf, pos, name_count)) {
+    return false;
+  }
+  entry.lowered_names_.clear();
+  for (uint64_t i = 0; i < name_count; i++) {
+    const char *name = nullptr, *lowered = nullptr;
+    size_t name_size = 0, lowered_size = 0;
+    if (!get_bytes(buf, pos, name, name_size) ||
+        !get_bytes(buf, pos, lowered, lowered_size)) {
+      return false;
+    }
+    entry.lowered_names_[std::string(name, name_size)] =
+        std::string(lowered, lowered_size);
+  }
+
+  return pos == buf.size();
+}
+
+// Recompute size of the directory and evict least recently used entries until
+// it drops below 3/4 of the limit. Needs state mutex held.
+void evict(cache_state &state) {
+  std::vector<std::tuple<fs::file_time_type, size_t, fs::path>> entries;
+  size_t total = 0;
+  std::error_code ec;
+
+  for (auto it = fs::directory_iterator(state.dir_, ec);
+       !ec && it != fs::directory_iterator(); it.increment(ec)) {
+    auto &path = it->path();
+    auto time = fs::last_write_time(path, ec);
+    if (ec) {
+      continue;
+    }
+
+    // Leftovers of a writer that died before publishing
+    if (path.extension() != entry_ext) {
+      if (path.filename().string().find(".tmp.") != std::string::npos &&
+          fs::file_time_type::clock::now() - time > std::chrono::hours(1)) {
+        fs::remove(path, ec);
+      }
+      continue;
+    }
+
+    auto size = fs::file_size(path, ec);
+    if (ec) {
+      continue;
+    }
+    entries.emplace_back(time, size, path);
+    total += size;
+  }
+
+  std::sort(entries.begin(), entries.end());
+
+  const size_t target = state.max_size_ / 4 * 3;
+  for (auto &entry : entries) {
+    if (total <= target) {
+      break;
+    }
+    if (fs::remove(std::get<2>(entry), ec)) {
+      total -= std::get<1>(entry);
+      state.evictions_++;
+    }
+  }
+
+  state.size_ = total;
+}
+
+// Needs state mutex held
+void configure_locked(cache_state &state, const std::string &dir,
+                      size_t max_size) {
+  state.configured_ = true;
+  state.max_size_ = (max_size != 0) ? max_size : default_max_size;
+  state.dir_.clear();
+  state.size_ = 0;
+
+  if (dir.empty()) {
+    return;
+  }
+
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  if (ec || !fs::is_directory(dir, ec)) {
+    return;
+  }
+
+  state.dir_ = dir;
+  evict(state);
+}
+
+// Returns the cache directory, empty when disabled
+fs::path get_dir(cache_state &state, size_t *max_size = nullptr) {
+  std::lock_guard<std::mutex> lock(state.mutex_);
+  if (!state.configured_) {
+    configure_locked(state, get_env("HIPRTC_CACHE_DIR"),
+                     get_env_size("HIPRTC_CACHE_MAX_SIZE", 0));
+  }
+  if (max_size != nullptr) {
+    *max_size = state.max_size_;
+  }
+  return state.dir_;
+}
+} // namespace
+
+bool configure(const std::string &dir, size_t max_size) {
+  auto &state = get_state();
+  std::lock_guard<std::mutex> lock(state.mutex_);
+  configure_locked(state, dir, max_size);
+  return dir.empty() || !state.dir_.empty();
+}
+
+bool enabled() { return !get_dir(get_state()).empty(); }
+
+bool load(const std::string &key, cache_entry &entry) {
+  auto &state = get_state();
+  auto dir = get_dir(state);
+  if (dir.empty()) {
+    return false;
+  }
+
+  auto path = dir / (key + entry_ext);
+  std::ifstream f(path, std::ios::binary | std::ios::ate);
+  if (!f) {
+    state.misses_++;
+    return false;
+  }
+
+  std::vector<char> buf(static_cast<size_t>(f.tellg()));
+  f.seekg(0);
+  if (!f.read(buf.data(), buf.size()) || !deserialize(buf, key, entry)) {
+    state.misses_++;
+    std::error_code ec;
+    fs::remove(path, ec);
+    return false;
+  }
+
+  // Bump the entry for LRU eviction
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+  state.hits_++;
+  return true;
+}
+
+void store(const std::string &key, const cache_entry &entry) {
+  auto &state = get_state();
+  size_t max_size = 0;
+  auto dir = get_dir(state, &max_size);
+  if (dir.empty()) {
+    return;
+  }
+
+  auto buf = serialize(key, entry);
+  if (buf.size() > max_size) {
+    return;
+  }
+
+  // Temporary name is unique across processes and threads
+  auto tmp = dir / (key + ".tmp." + std::to_string(getpid()) + "." +
+                    std::to_string(state.tmp_counter_++));
+  {
+    std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+    if (!f.write(buf.data(), buf.size()) || !f.flush()) {
+      f.close();
+      std::error_code ec;
+      fs::remove(tmp, ec);
+      return;
+    }
+  }
+
+  std::error_code ec;
+  fs::rename(tmp, dir / (key + entry_ext), ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+    return;
+  }
+  state.stores_++;
+
+  std::lock_guard<std::mutex> lock(state.mutex_);
+  if (state.dir_ != dir) {
+    return; // Reconfigured meanwhile
+  }
+  state.size_ += buf.size();
+  if (state.size_ > state.max_size_) {
+    evict(state);
+  }
+}
+
+stats get_stats() {
+  auto &state = get_state();
+  return stats{state.hits_.load(), state.misses_.load(), state.stores_.load(),
+               state.evictions_.load()};
+}
+} // namespace disk_cache
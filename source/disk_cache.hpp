@@ -0,0 +1,65 @@
+#pragma once
+
+#include "cache_entry.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace disk_cache {
+/**
+ * @brief Counters of the disk cache, accumulated over the process lifetime
+ *
+ */
+struct stats {
+  size_t hits;
+  size_t misses;
+  size_t stores;
+  size_t evictions;
+};
+
+/**
+ * @brief Set the cache directory and size limit
+ *
+ * The cache is configured from HIPRTC_CACHE_DIR and HIPRTC_CACHE_MAX_SIZE on
+ * first use, this overrides them.
+ *
+ * @param dir directory to keep code objects in, empty disables the cache
+ * @param max_size size limit in bytes, 0 for the default
+ * @return true cache directory is usable
+ * @return false cache directory could not be created
+ */
+bool configure(const std::string &dir, size_t max_size);
+
+/**
+ * @brief Is disk cache enabled
+ *
+ */
+bool enabled();
+
+/**
+ * @brief Load an entry from the cache
+ *
+ * @param key fingerprint of the compilation inputs
+ * @param entry entry to be filled
+ * @return true hit
+ * @return false miss
+ */
+bool load(const std::string &key, cache_entry &entry);
+
+/**
+ * @brief Publish an entry to the cache
+ *
+ * The entry is written to a temporary file and renamed in place, so
+ * concurrent readers, including other processes, never see a partial entry.
+ *
+ * @param key fingerprint of the compilation inputs
+ * @param entry entry to be stored
+ */
+void store(const std::string &key, const cache_entry &entry);
+
+/**
+ * @brief Get the counters
+ *
+ */
+stats get_stats();
+} // namespace disk_cache
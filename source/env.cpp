@@ -0,0 +1,42 @@
+#include "env.hpp"
+
+#include <cstdlib>
+
+std::string get_env(const char *name) {
+  const char *value = std::getenv(name);
+  return (value != nullptr) ? value : "";
+}
+
+size_t get_env_size(const char *name, size_t default_value) {
+  auto value = get_env(name);
+  if (value.empty()) {
+    return default_value;
+  }
+
+  char *end = nullptr;
+  unsigned long long size = std::strtoull(value.c_str(), &end, 10);
+  if (end == value.c_str()) {
+    return default_value;
+  }
+
+  switch (*end) {
+  case '\0':
+    break;
+  case 'k':
+  case 'K':
+    size <<= 10;
+    break;
+  case 'm':
+  case 'M':
+    size <<= 20;
+    break;
+  case 'g':
+  case 'G':
+    size <<= 30;
+    break;
+  default:
+    return default_value;
+  }
+
+  return static_cast<size_t>(size);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Get value of an environment variable
+ *
+ * @param name name of the variable
+ * @return std::string value, empty if not set
+ */
+std::string get_env(const char *name);
+
+/**
+ * @brief Get a size in bytes from an environment variable
+ *
+ * Accepts a plain number or one suffixed with K, M or G
+ *
+ * @param name name of the variable
+ * @param default_value value returned when unset or malformed
+ * @return size_t
+ */
+size_t get_env_size(const char *name, size_t default_value);
@@ -0,0 +1,53 @@
+#include "fingerprint.hpp"
+
+#include <cstring>
+
+namespace {
+constexpr uint64_t murmur_m = 0xc6a4a7935bd1e995ULL;
+constexpr int murmur_r = 47;
+
+// MurmurHash64A, processes 8 bytes at a time
+uint64_t murmur64(const unsigned char *data, size_t size, uint64_t seed) {
+  uint64_t h = seed ^ (size * murmur_m);
+
+  const unsigned char *end = data + (size / 8) * 8;
+  for (; data != end; data += 8) {
+    uint64_t k;
+    std::memcpy(&k, data, sizeof(k));
+    k *= murmur_m;
+    k ^= k >> murmur_r;
+    k *= murmur_m;
+    h ^= k;
+    h *= murmur_m;
+  }
+
+  uint64_t tail = 0;
+  std::memcpy(&tail, data, size & 7);
+  if ((size & 7) != 0) {
+    h ^= tail;
+    h *= murmur_m;
+  }
+
+  h ^= h >> murmur_r;
+  h *= murmur_m;
+  h ^= h >> murmur_r;
+  return h;
+}
+} // namespace
+
+fingerprint &fingerprint::add(const void *data, size_t size) {
+  auto bytes = static_cast<const unsigned char *>(data);
+  lo_ = murmur64(bytes, size, lo_);
+  hi_ = murmur64(bytes, size, hi_ ^ lo_);
+  return *this;
+}
+
+std::string fingerprint::hex() const {
+  static const char digits[] = "0123456789abcdef";
+  std::string res(32, '0');
+  for (int i = 0; i < 16; i++) {
+    res[15 - i] = digits[(hi_ >> (i * 4)) & 0xf];
+    res[31 - i] = digits[(lo_ >> (i * 4)) & 0xf];
+  }
+  return res;
+}
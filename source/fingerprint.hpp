@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Incremental 128 bit fingerprint of compilation inputs
+ *
+ * This is not a cryptographic hash, it is used to name cache entries. Every
+ * field is length prefixed so that ("ab", "c") and ("a", "bc") differ.
+ */
+class fingerprint {
+public:
+  fingerprint &add(const void *data, size_t size);
+  fingerprint &add(std::string_view str) {
+    return add(str.data(), str.size());
+  }
+  fingerprint &add(uint64_t value) { return add(&value, sizeof(value)); }
+
+  /**
+   * @brief Get the fingerprint as 32 hex characters
+   *
+   * @return std::string
+   */
+  std::string hex() const;
+
+private:
+  uint64_t lo_ = 0x9e3779b97f4a7c15ULL;
+  uint64_t hi_ = 0xc2b2ae3d27d4eb4fULL;
+};
@@ -1,8 +1,14 @@
 #include "comgr_wrapper.hpp"
+#include "compression.hpp"
+#include "internal_modules.hpp"
+
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <iostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 const char hiprtc_internal_header[] = {
@@ -13,18 +19,11 @@ const char hiprtc_header_append[] = {
 #include "hiprtc_defines.h"
 };
 
-bool get_internal_header(std::string &header) {
-  std::vector<std::string> options;
-  options.reserve(8);
-  options.push_back("-D__HIPCC_RTC__");
-  options.push_back("-std=c++17");
-  options.push_back("-include");
-  options.push_back("hiprtc_internal_header.hpp");
-  options.push_back("--cuda-device-only");
-  options.push_back("-nogpulib");
-  options.push_back("--cuda-gpu-arch=gfx1100");
-  options.push_back("-P");
-
+// Run a comgr action on one source, output of kind is copied to out
+bool run_action(amd_comgr_action_kind_t kind, const std::string &isa_name,
+                const std::vector<std::string> &options, const char *src,
+                size_t src_size, amd_comgr_data_kind_t out_kind,
+                std::vector<char> &out) {
   // Create comgr dataset, a superset of all compilation inputs
   amd_comgr_data_set_t data_set;
   if (auto comgr_res = amd_comgr_create_data_set(&data_set);
@@ -32,124 +31,205 @@ bool get_internal_header(std::string &header) {
     return false;
   }
 
-  const char custom_src[] = "#include <hiprtc_internal_header.hpp>";
-  // Create data for source
-  amd_comgr_data_t data;
-  if (!create_data(data, AMD_COMGR_DATA_KIND_SOURCE, custom_src,
-                   sizeof(custom_src), "custom.cc")) {
-    (void)amd_comgr_destroy_data_set(data_set);
-    return false;
-  }
-
-  // Add data to dataset
-  if (auto comgr_res = amd_comgr_data_set_add(data_set, data);
-      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+  // Add source
+  if (!add_data(data_set, AMD_COMGR_DATA_KIND_SOURCE, src, src_size,
+                "custom.cc")) {
     (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_release_data(data);
     return false;
   }
 
   // Add internal header
-  amd_comgr_data_t include_data;
-  if (!create_data(
-          include_data, AMD_COMGR_DATA_KIND_INCLUDE, hiprtc_internal_header,
-          sizeof(hiprtc_internal_header) - 1 /* -1 coz null terminated */,
-          "hiprtc_internal_header.hpp")) {
+  if (!add_data(data_set, AMD_COMGR_DATA_KIND_INCLUDE, hiprtc_internal_header,
+                sizeof(hiprtc_internal_header) - 1 /* -1 coz null terminated */,
+                "hiprtc_internal_header.hpp")) {
     (void)amd_comgr_destroy_data_set(data_set);
     return false;
   }
 
-  // Add include header to dataset
-  if (auto comgr_res = amd_comgr_data_set_add(data_set, include_data);
-      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
-    (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_release_data(include_data);
-    return false;
-  }
-
-  // Release include header
-  (void)amd_comgr_release_data(include_data);
-
-  // Todo, configure it at runtime
-  // Get isa name
-  // auto isa_name = "amdgcn-amd-amdhsa--gfx1100";
-
   // Create action
   amd_comgr_action_info_t action;
-  if (!create_action(action, /*isa_name*/ "", options)) {
+  if (!create_action(action, isa_name, options)) {
     (void)amd_comgr_destroy_data_set(data_set);
     return false;
   }
 
-  // Create relocatable
-  amd_comgr_data_set_t preprocess;
-  if (auto comgr_res = amd_comgr_create_data_set(&preprocess);
+  amd_comgr_data_set_t output;
+  if (auto comgr_res = amd_comgr_create_data_set(&output);
       comgr_res != AMD_COMGR_STATUS_SUCCESS) {
     (void)amd_comgr_destroy_data_set(data_set);
     (void)amd_comgr_destroy_action_info(action);
     return false;
   }
 
-  // Compile to preprocess
-  if (auto comgr_res =
-          amd_comgr_do_action(AMD_COMGR_ACTION_SOURCE_TO_PREPROCESSOR, action,
-                              data_set, preprocess);
-      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
-    (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_destroy_action_info(action);
-    (void)amd_comgr_destroy_data_set(preprocess);
-    return false;
-  }
+  auto comgr_res = amd_comgr_do_action(kind, action, data_set, output);
+  (void)amd_comgr_destroy_data_set(data_set);
+  (void)amd_comgr_destroy_action_info(action);
+  bool success = comgr_res == AMD_COMGR_STATUS_SUCCESS &&
+                 get_data(output, out_kind, out) && !out.empty();
+  (void)amd_comgr_destroy_data_set(output);
+  return success;
+}
 
-  // Extract Binary
-  amd_comgr_data_t p_header;
-  if (auto comgr_res = amd_comgr_action_data_get_data(
-          preprocess, AMD_COMGR_DATA_KIND_SOURCE, 0, &p_header);
-      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
-    (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_destroy_action_info(action);
-    (void)amd_comgr_destroy_data_set(preprocess);
-    return false;
-  }
+// Preprocess hip_runtime.h, line markers are kept to split it into modules
+bool get_internal_header(const std::string &arch, std::string &header) {
+  std::vector<std::string> options;
+  options.reserve(8);
+  options.push_back("-D__HIPCC_RTC__");
+  options.push_back("-std=c++17");
+  options.push_back("-include");
+  options.push_back("hiprtc_internal_header.hpp");
+  options.push_back("--cuda-device-only");
+  options.push_back("-nogpulib");
+  options.push_back("--cuda-gpu-arch=" + arch);
 
-  // Get binary size
-  size_t preprocess_size = 0;
-  if (auto comgr_res = amd_comgr_get_data(p_header, &preprocess_size, NULL);
-      comgr_res != AMD_COMGR_STATUS_SUCCESS || preprocess_size == 0) {
-    (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_destroy_action_info(action);
-    (void)amd_comgr_destroy_data_set(preprocess);
+  const char custom_src[] = "#include <hiprtc_internal_header.hpp>";
+  std::vector<char> preprocessed;
+  if (!run_action(AMD_COMGR_ACTION_SOURCE_TO_PREPROCESSOR, /*isa_name*/ "",
+                  options, custom_src, sizeof(custom_src),
+                  AMD_COMGR_DATA_KIND_SOURCE, preprocessed)) {
     return false;
   }
+  header.assign(preprocessed.begin(), preprocessed.end());
+  return true;
+}
 
-  // Allocate binary size to copy
-  header.resize(preprocess_size);
+// Check a header parses on its own, with a kernel as the mock wants one
+bool parses(const std::string &arch, const std::string &header) {
+  std::vector<std::string> options = {"-std=c++17", "-nogpuinc", "-nogpulib",
+                                      "-D__HIPCC_RTC__",
+                                      "-Wno-missing-prototypes"};
+  auto src = header + "\n__global__ void hiprtc_module_check() {}\n";
+  std::vector<char> bitcode;
+  return run_action(AMD_COMGR_ACTION_COMPILE_SOURCE_TO_BC,
+                    "amdgcn-amd-amdhsa--" + arch, options, src.c_str(),
+                    src.size(), AMD_COMGR_DATA_KIND_BC, bitcode);
+}
 
-  // Copy binary
-  if (auto comgr_res =
-          amd_comgr_get_data(p_header, &preprocess_size, header.data());
-      comgr_res != AMD_COMGR_STATUS_SUCCESS || preprocess_size == 0) {
-    (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_destroy_action_info(action);
-    (void)amd_comgr_destroy_data_set(preprocess);
-    return false;
+// C string literal of any bytes, split over lines
+std::string get_literal(std::string_view data) {
+  static const char digits[] = "01234567";
+  std::string literal = "\"";
+  for (size_t i = 0; i < data.size(); i++) {
+    auto c = static_cast<unsigned char>(data[i]);
+    if (i != 0 && i % 64 == 0) {
+      literal += "\"\n\"";
+    }
+    if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\' && c != '?') {
+      literal += char(c);
+    } else {
+      // Always three digits, a digit after it can not extend it
+      literal += '\\';
+      literal += digits[c >> 6];
+      literal += digits[(c >> 3) & 7];
+      literal += digits[c & 7];
+    }
   }
+  return literal + "\"";
+}
 
-  return true;
+// Module the lines of a file go to, the first one matching its path
+size_t get_module(std::string_view file, const std::vector<bool> &folded) {
+  for (size_t i = 1; i < internal_module_count; i++) {
+    if (folded[i]) {
+      continue;
+    }
+    for (auto path : internal_modules[i].paths_) {
+      if (path != nullptr && file.find(path) != std::string_view::npos) {
+        return i;
+      }
+    }
+  }
+  return 0;
+}
+
+// Split preprocessed text by the file each line comes from. Every file is
+// only expanded once, so modules share nothing.
+std::vector<std::string> split(const std::string &header,
+                               const std::vector<bool> &folded) {
+  std::vector<std::string> texts(internal_module_count);
+  texts[0] = hiprtc_header_append;
+  size_t module = 0;
+  std::string_view text = header;
+  while (!text.empty()) {
+    auto end = text.find('\n');
+    auto line = text.substr(0, end);
+    text = (end == std::string_view::npos) ? std::string_view()
+                                           : text.substr(end + 1);
+
+    // Line marker: # <line> "<file>" <flags>
+    if (line.size() > 2 && line[0] == '#' && line[1] == ' ' &&
+        line[2] >= '0' && line[2] <= '9') {
+      auto open = line.find('"');
+      auto close = line.rfind('"');
+      if (open != std::string_view::npos && close > open) {
+        module = get_module(line.substr(open + 1, close - open - 1), folded);
+      }
+      continue;
+    }
+    if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+      continue;
+    }
+    texts[module].append(line).append("\n");
+  }
+  return texts;
 }
 
 int main(int argc, char **argv) {
-  if (argc != 2) {
-    throw std::runtime_error("Pass location to write the header");
+  if (argc < 2 || argc > 3) {
+    throw std::runtime_error("Pass location to write the header, and "
+                             "optionally the gfx arch to preprocess for");
   }
+  std::string arch = (argc == 3) ? argv[2] : "gfx1100";
 
   std::string header;
-  if (!get_internal_header(header)) {
+  if (!get_internal_header(arch, header)) {
     throw std::runtime_error("Failed to generate header");
   }
 
-  header = "R\"(\n" + std::string(hiprtc_header_append) + header;
-  header += ")\"";
+  // A module that does not parse on top of core alone is folded into core,
+  // until all of them do. Core that needs a module gets all of them.
+  std::vector<bool> folded(internal_module_count, false);
+  auto texts = split(header, folded);
+  for (bool changed = true; changed;) {
+    changed = false;
+    if (!parses(arch, texts[0])) {
+      if (std::find(folded.begin() + 1, folded.end(), false) == folded.end()) {
+        throw std::runtime_error("Header does not parse");
+      }
+      std::cerr << "Folding all header modules into core" << std::endl;
+      folded.assign(internal_module_count, true);
+      texts = split(header, folded);
+      changed = true;
+      continue;
+    }
+    for (size_t i = 1; i < internal_module_count; i++) {
+      if (!folded[i] && !texts[i].empty() &&
+          !parses(arch, texts[0] + texts[i])) {
+        std::cerr << "Folding header module " << internal_modules[i].name_
+                  << " into core" << std::endl;
+        folded[i] = true;
+        changed = true;
+      }
+    }
+    if (changed) {
+      texts = split(header, folded);
+    }
+  }
+
+  // Compressed, the library only pays for the text once it compiles
+  std::string out = "// Generated by gen_hiprtc_header, per internal_modules "
+                    "entry: compressed text,\n// its size and the size of "
+                    "the text\n";
+  for (size_t i = 0; i < internal_module_count; i++) {
+    auto compressed = compression::compress(texts[i]);
+    std::cout << "Header module " << internal_modules[i].name_ << ": "
+              << texts[i].size() << " bytes, " << compressed.size()
+              << " compressed" << std::endl;
+    out += "{" + get_literal(compressed) + ",\n " +
+           std::to_string(compressed.size()) + ", " +
+           std::to_string(texts[i].size()) + "},\n";
+  }
+
   std::string location = argv[1];
   std::string header_name = "hiprtc_internal_header_generated.hpp";
   std::string full_name = location + "/" + header_name;
@@ -158,7 +238,7 @@ int main(int argc, char **argv) {
   }
 
   std::ofstream f(full_name);
-  f.write(header.c_str(), header.size());
+  f.write(out.c_str(), out.size());
   f.close();
   return 0;
-}
\ No newline at end of file
+}
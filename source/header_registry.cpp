@@ -0,0 +1,163 @@
+#include "header_registry.hpp"
+#include "comgr_wrapper.hpp"
+#include "fingerprint.hpp"
+#include "internal_header.hpp"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+struct registry_slot {
+  std::shared_ptr<const registered_header> header_;
+  size_t refs_ = 0; // References from hiprtcRegisterHeader
+};
+
+std::mutex registry_mutex;
+std::unordered_map<std::string, registry_slot> registry; // By hash_
+std::unordered_map<const registered_header *, std::string> handles;
+
+// Guards reference counts of shared comgr data
+std::mutex data_mutex;
+
+bool is_space(char c) { return c == ' ' || c == '\t'; }
+} // namespace
+
+registered_header::~registered_header() {
+  if (data_.handle != 0) {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    (void)amd_comgr_release_data(data_);
+  }
+}
+
+namespace header_registry {
+const registered_header *add(std::string_view name, std::string_view text) {
+  fingerprint fp;
+  fp.add(name).add(text);
+  auto hash = fp.hex();
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto &slot = registry[hash];
+  if (slot.header_ == nullptr) {
+    auto header = std::make_shared<registered_header>();
+    header->name_ = name;
+    header->text_ = text;
+    header->hash_ = hash;
+    header->computed_include_ = !scan_includes(text, header->includes_);
+    header->modules_ = detect_internal_modules(text);
+    if (!create_data(header->data_, AMD_COMGR_DATA_KIND_INCLUDE, text.data(),
+                     text.size(), header->name_.c_str())) {
+      header->data_.handle = 0;
+      registry.erase(hash);
+      return nullptr;
+    }
+    slot.header_ = std::move(header);
+    handles.emplace(slot.header_.get(), hash);
+  }
+  slot.refs_++;
+  return slot.header_.get();
+}
+
+bool release(const registered_header *header) {
+  std::shared_ptr<const registered_header> last; // Freed outside the lock
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto it = handles.find(header);
+  if (it == handles.end()) {
+    return false;
+  }
+  auto &slot = registry.at(it->second);
+  if (--slot.refs_ == 0) {
+    last = std::move(slot.header_);
+    registry.erase(it->second);
+    handles.erase(it);
+  }
+  return true;
+}
+
+std::shared_ptr<const registered_header> get(const registered_header *header) {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto it = handles.find(header);
+  return (it != handles.end()) ? registry.at(it->second).header_ : nullptr;
+}
+
+std::shared_ptr<const registered_header>
+internal_header(std::string_view name) {
+  // One per module combination in use, for the process lifetime
+  static std::unordered_map<std::string,
+                            std::shared_ptr<const registered_header>>
+      internal_headers;
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto &header = internal_headers[std::string(name)];
+  if (header == nullptr) {
+    auto text = get_internal_header(name);
+    auto built = std::make_shared<registered_header>();
+    built->name_ = name;
+    if (text.empty() ||
+        !create_data(built->data_, AMD_COMGR_DATA_KIND_INCLUDE, text.data(),
+                     text.size(), built->name_.c_str())) {
+      built->data_.handle = 0;
+      internal_headers.erase(std::string(name));
+      return nullptr;
+    }
+    header = std::move(built);
+  }
+  return header;
+}
+
+bool add_to(amd_comgr_data_set_t &data_set, const registered_header &header) {
+  std::lock_guard<std::mutex> lock(data_mutex);
+  return amd_comgr_data_set_add(data_set, header.data_) ==
+         AMD_COMGR_STATUS_SUCCESS;
+}
+
+void destroy_data_set(amd_comgr_data_set_t data_set) {
+  std::lock_guard<std::mutex> lock(data_mutex);
+  (void)amd_comgr_destroy_data_set(data_set);
+}
+
+bool scan_includes(std::string_view text, std::vector<std::string> &names) {
+  constexpr std::string_view include = "include";
+  bool literal = true;
+  for (size_t pos = text.find(include); pos != std::string_view::npos;
+       pos = text.find(include, pos)) {
+    size_t start = pos;
+    pos += include.size();
+
+    // #include or # include, else __has_include(
+    size_t back = start;
+    while (back > 0 && is_space(text[back - 1])) {
+      back--;
+    }
+    bool directive = (back > 0 && text[back - 1] == '#');
+    bool has_include = (start >= 6 && text.substr(start - 6, 6) == "__has_");
+    if (!directive && !has_include) {
+      continue;
+    }
+
+    if (text.substr(pos, 5) == "_next") {
+      pos += 5;
+    }
+    while (pos < text.size() && (is_space(text[pos]) ||
+                                 (has_include && text[pos] == '('))) {
+      pos++;
+    }
+    if (pos >= text.size()) {
+      break;
+    }
+
+    char close = (text[pos] == '"') ? '"' : (text[pos] == '<') ? '>' : 0;
+    if (close == 0) {
+      // Something like #include HEADER, or not an include after all
+      literal = literal && !directive;
+      continue;
+    }
+    const char terminators[] = {close, '\n', '\0'};
+    auto end = text.find_first_of(terminators, pos + 1);
+    if (end == std::string_view::npos || text[end] != close) {
+      continue;
+    }
+    names.emplace_back(text.substr(pos + 1, end - pos - 1));
+    pos = end + 1;
+  }
+  return literal;
+}
+} // namespace header_registry
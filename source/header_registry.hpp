@@ -0,0 +1,110 @@
+#pragma once
+
+#include <amd_comgr/amd_comgr.h>
+
+#include "internal_header.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Header interned once per process together with its comgr data
+ *
+ * Shared by every program that uses it, the comgr data object is added to
+ * their data sets by reference instead of being created and copied again.
+ */
+struct registered_header {
+  registered_header() = default;
+  ~registered_header();
+
+  registered_header(const registered_header &) = delete;
+  registered_header &operator=(const registered_header &) = delete;
+
+  std::string name_;                  // Include name
+  std::string text_;                  // Text, sent to out of process compiles
+  std::string hash_;                  // Fingerprint of name and text
+  std::vector<std::string> includes_; // Names it includes
+  bool computed_include_ = false;     // Includes a macro, may reach anything
+  internal_module_set modules_ = 0;   // Of the embedded header it uses
+  amd_comgr_data_t data_{0};
+};
+
+namespace header_registry {
+/**
+ * @brief Intern a header
+ *
+ * The same name and text give back the same header, each call counts a
+ * reference to be dropped with release.
+ *
+ * @param name include name
+ * @param text header text
+ * @return const registered_header* handle, nullptr if comgr fails
+ */
+const registered_header *add(std::string_view name, std::string_view text);
+
+/**
+ * @brief Drop a reference from add
+ *
+ * The header leaves the registry with its last reference, programs using it
+ * keep it alive until they are destroyed.
+ *
+ * @param header handle
+ * @return true success
+ * @return false header is not registered
+ */
+bool release(const registered_header *header);
+
+/**
+ * @brief Get a registered header to hold on to
+ *
+ * @param header handle
+ * @return std::shared_ptr<const registered_header> header, nullptr if it is
+ * not registered
+ */
+std::shared_ptr<const registered_header> get(const registered_header *header);
+
+/**
+ * @brief Get the embedded hip runtime header, built once per process and name
+ *
+ * @param name name the header is force included as, selects its modules
+ * @return std::shared_ptr<const registered_header> header, nullptr if the
+ * name is not one of the embedded header or comgr fails
+ */
+std::shared_ptr<const registered_header>
+internal_header(std::string_view name);
+
+/**
+ * @brief Add a registered header to a data set
+ *
+ * Shared data is only referenced from data sets under a lock, comgr does not
+ * count references atomically.
+ *
+ * @param data_set
+ * @param header
+ * @return true success
+ * @return false failure
+ */
+bool add_to(amd_comgr_data_set_t &data_set, const registered_header &header);
+
+/**
+ * @brief Destroy a data set that may hold registered headers
+ *
+ * @param data_set
+ */
+void destroy_data_set(amd_comgr_data_set_t data_set);
+
+/**
+ * @brief Collect the names a text includes
+ *
+ * Looks at #include, #include_next and __has_include, in comments as well,
+ * so it may find more than the preprocessor would.
+ *
+ * @param text source or header
+ * @param names included names are appended
+ * @return true all includes are literal names
+ * @return false an include is computed by a macro
+ */
+bool scan_includes(std::string_view text, std::vector<std::string> &names);
+} // namespace header_registry
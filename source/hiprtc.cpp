@@ -1,8 +1,22 @@
+#include "compile_options.hpp"
+#include "disk_cache.hpp"
+#include "header_registry.hpp"
 #include "hiprtc_internal.hpp"
+#include "internal_header.hpp"
+#include "link.hpp"
+#include "memory_cache.hpp"
+#include "occupancy.hpp"
+#include "target.hpp"
+#include "thread_pool.hpp"
 #include <hip/hiprtc.h>
 
+#include <algorithm>
 #include <cstring>
+#include <fstream>
+#include <iterator>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 const char *hiprtcGetErrorString(hiprtcResult result) {
@@ -29,6 +43,12 @@ const char *hiprtcGetErrorString(hiprtcResult result) {
     return "HIPRTC_ERROR_NO_LOWERED_NAMES_BEFORE_COMPILATION";
   case HIPRTC_ERROR_NAME_EXPRESSION_NOT_VALID:
     return "HIPRTC_ERROR_NAME_EXPRESSION_NOT_VALID";
+  case HIPRTC_ERROR_NOT_READY:
+    return "HIPRTC_ERROR_NOT_READY";
+  case HIPRTC_ERROR_CANCELLED:
+    return "HIPRTC_ERROR_CANCELLED";
+  case HIPRTC_ERROR_LINKING:
+    return "HIPRTC_ERROR_LINKING";
   default:
     return "HIPRTC_ERROR_INTERNAL_ERROR";
   }
@@ -49,49 +69,772 @@ hiprtcResult hiprtcVersion(int *major, int *minor) {
   return HIPRTC_SUCCESS;
 }
 
-hiprtcResult hiprtcCreateProgram(hiprtcProgram *prog, const char *src,
-                                 const char *name, int num_headers,
-                                 const char **headers,
-                                 const char **include_names) {
-  if (prog == nullptr || src == nullptr) {
+namespace {
+bool valid_options(int num_options, const char **options) {
+  return !((num_options == 0 && options != nullptr) ||
+           (num_options != 0 && options == nullptr) || num_options < 0);
+}
+
+// Compile a validated program, shared by all compile entry points
+hiprtcResult compile(hiprtc_program *p, int num_options,
+                     const char **options) {
+  p->stats_ = compile_stats();
+  scoped_timer total_timer(p->stats_.total_ms_);
+
+  /* Append user options */
+  std::vector<std::string> opts;
+  opts.reserve(num_options + 8);
+  opts.push_back("-O3");
+  opts.push_back("-std=c++17");
+  opts.push_back("-nogpuinc");
+  opts.push_back("-D__HIPCC_RTC__");
+  opts.push_back("-include");
+  opts.push_back(internal_header_name);
+  opts.push_back("-Wno-gnu-line-marker");
+  opts.push_back("-Wno-missing-prototypes");
+
+  if (num_options != 0) {
+    for (int i = 0; i < num_options; i++) {
+      opts.push_back(options[i]);
+    }
+  }
+
+  // Fail fast on bad options, before any device or compiler work
+  if (!compile_options::canonicalize(opts, p->log_)) {
+    return HIPRTC_ERROR_INVALID_OPTION;
+  }
+
+  // Pick targets, consumes target options
+  std::vector<std::string> target_ids;
+  auto target_start = stats_clock::now();
+  bool resolved = target::resolve(opts, target_ids);
+  p->stats_.target_ms_ = elapsed_ms(target_start);
+  if (!resolved) {
+    p->log_ = "Invalid target: " + target_ids.front() + "\n";
+    return HIPRTC_ERROR_INVALID_OPTION;
+  }
+
+  if (target_ids.empty()) {
+    p->log_ = "No device found, pass --offload-arch=<target> or set "
+              "HIPRTC_TARGET\n";
+    return HIPRTC_ERROR_COMPILATION;
+  }
+
+  // Pick modules of the internal header, consumes module options. Only
+  // headers the source reaches count, registered ones know their modules.
+  auto detect = [&] {
+    auto modules = detect_internal_modules(p->source_.view());
+    auto reached = find_reachable_headers(p, p->source_.view(), opts);
+    auto plain = p->headers_.size();
+    for (size_t i = 0; i < reached.size(); i++) {
+      if (reached[i]) {
+        modules |= (i < plain)
+                       ? detect_header_modules(p->headers_[i].second.view())
+                       : p->registered_headers_[i - plain]->modules_;
+      }
+    }
+    return modules;
+  };
+  if (!select_internal_modules(opts, detect, p->log_)) {
+    return HIPRTC_ERROR_INVALID_OPTION;
+  }
+
+  if (!compile_program(p, target_ids, opts)) {
+    return HIPRTC_ERROR_COMPILATION;
+  }
+
+  return HIPRTC_SUCCESS;
+}
+
+// Hand the code over to caller owned memory if an allocator is set. This is
+// the only copy of a compilation, without an allocator code_ points into the
+// entry shared with the caches.
+bool place_code(hiprtc_program *p) {
+  if (p->allocator_ == nullptr) {
+    return true;
+  }
+
+  auto code =
+      static_cast<char *>(p->allocator_(p->code_size_, p->allocator_data_));
+  if (code == nullptr) {
+    p->log_ += "Code allocator failed to allocate " +
+               std::to_string(p->code_size_) + " bytes\n";
+    return false;
+  }
+
+  std::memcpy(code, p->code_, p->code_size_);
+  p->code_ = code;
+  p->bundle_ = std::vector<char>();
+  return true;
+}
+
+// Drop what a compilation produced, nobody wants it anymore
+void discard_outputs(hiprtc_program *p) {
+  p->code_ = nullptr;
+  p->code_size_ = 0;
+  p->outputs_.clear();
+  p->targets_.clear();
+  p->kernels_.clear();
+  p->bundle_.clear();
+  p->log_.clear();
+  for (auto &name_pair : p->lowered_names_) {
+    name_pair.second.clear();
+  }
+}
+
+// Move program to the state matching the result of its compilation. With the
+// job of an asynchronous compilation its cancellation is checked under the
+// same locks, in the same order, as hiprtcCancelCompile takes them, so a
+// cancel either discards the result or finds the compilation over.
+hiprtcResult finish_compile(hiprtc_program *p, hiprtcResult res,
+                            hiprtc_async_job *job = nullptr) {
+  std::lock_guard<std::mutex> lock(p->mutex_);
+  if (job != nullptr) {
+    std::lock_guard<std::mutex> job_lock(job->mutex_);
+    if (job->cancelled_) {
+      discard_outputs(p);
+      res = HIPRTC_ERROR_CANCELLED;
+    }
+  }
+
+  // Cancelled compilations never reach the allocator
+  if (res == HIPRTC_SUCCESS && !place_code(p)) {
+    res = HIPRTC_ERROR_COMPILATION;
+  }
+
+  switch (res) {
+  case HIPRTC_SUCCESS:
+    p->state_ = hiprtc_program_state::Compiled;
+    break;
+  case HIPRTC_ERROR_INVALID_OPTION:
+  case HIPRTC_ERROR_CANCELLED:
+    p->state_ = hiprtc_program_state::Created;
+    break;
+  default:
+    p->state_ = hiprtc_program_state::Error;
+    break;
+  }
+  p->result_ = res;
+  p->cv_.notify_all();
+  return res;
+}
+
+bool in_flight(const hiprtc_program *p) {
+  auto state = p->state_.load();
+  return state == hiprtc_program_state::Queued ||
+         state == hiprtc_program_state::Compiling;
+}
+
+// Compiled programs can be compiled again, with the same or other options
+bool can_compile(const hiprtc_program *p) {
+  auto state = p->state_.load();
+  return state == hiprtc_program_state::Created ||
+         state == hiprtc_program_state::Compiled ||
+         state == hiprtc_program_state::Error;
+}
+
+// Program compiling one instantiation of a kernel template of p, borrows
+// the source and headers of p
+std::unique_ptr<hiprtc_program>
+create_specialization(const hiprtc_program *p,
+                      const std::string &name_expression) {
+  auto s = std::make_unique<hiprtc_program>();
+  s->name_ = p->name_;
+  auto source = p->source_.view();
+  s->source_ = source_buffer::borrow(source.data(), source.size());
+  s->state_ = hiprtc_program_state::Created;
+  for (auto &header : p->headers_) {
+    auto text = header.second.view();
+    s->headers_.emplace_back(header.first,
+                             source_buffer::borrow(text.data(), text.size()));
+  }
+  s->registered_headers_ = p->registered_headers_;
+  s->name_expressions_.push_back(name_expression);
+  s->lowered_names_.emplace(name_expression, std::string());
+  return s;
+}
+
+// Kernel of a compiled program for one of its targets, metadata is parsed
+// once per target and later queries only look up
+hiprtcResult find_kernel(hiprtc_program *p, const std::string &target_id,
+                         std::string_view name, program_kernels *&kernels,
+                         size_t &index) {
+  auto found = p->kernels_.find(target_id);
+  if (found == p->kernels_.end()) {
+    auto target = std::find(p->targets_.begin(), p->targets_.end(), target_id);
+    program_kernels parsed;
+    auto &object = p->outputs_[target - p->targets_.begin()]->object_;
+    if (!code_object::get_kernels(object, parsed.kernels_)) {
+      return HIPRTC_ERROR_INTERNAL_ERROR;
+    }
+    for (auto &k : parsed.kernels_) {
+      std::vector<hiprtcKernelArg> args;
+      for (auto &arg : k.args_) {
+        args.push_back({arg.name_.c_str(), arg.value_kind_.c_str(),
+                        static_cast<size_t>(arg.offset_),
+                        static_cast<size_t>(arg.size_)});
+      }
+      parsed.args_.push_back(std::move(args));
+    }
+    found = p->kernels_.emplace(target_id, std::move(parsed)).first;
+  }
+
+  kernels = &found->second;
+  auto &list = kernels->kernels_;
+  index = 0;
+  while (index < list.size() && list[index].name_ != name &&
+         list[index].symbol_ != name) {
+    index++;
+  }
+  return (index < list.size()) ? HIPRTC_SUCCESS : HIPRTC_ERROR_INVALID_INPUT;
+}
+
+// Call back once the result is published. Waiters of the program hold on
+// until the callback returns, it may still be using the program.
+void run_callback(hiprtc_program *p, hiprtc_async_job &job,
+                  hiprtcResult res) {
+  {
+    std::lock_guard<std::mutex> lock(job.mutex_);
+    job.callback_thread_ = std::this_thread::get_id();
+  }
+  if (job.callback_ != nullptr) {
+    job.callback_(reinterpret_cast<hiprtcProgram>(p), res, job.user_data_);
+  }
+
+  // Program may be gone by now, only the job is touched
+  std::lock_guard<std::mutex> lock(job.mutex_);
+  job.callback_done_ = true;
+  job.cv_.notify_all();
+}
+
+void run_async_job(hiprtc_program *p, std::shared_ptr<hiprtc_async_job> job,
+                   const std::vector<std::string> &options) {
+  {
+    // Cancelled while queued, program may already be gone
+    std::lock_guard<std::mutex> lock(job->mutex_);
+    if (job->cancelled_) {
+      return;
+    }
+    job->started_ = true;
+  }
+  p->state_ = hiprtc_program_state::Compiling;
+
+  std::vector<const char *> opts;
+  opts.reserve(options.size());
+  for (auto &option : options) {
+    opts.push_back(option.c_str());
+  }
+  auto res = compile(p, static_cast<int>(opts.size()),
+                     opts.empty() ? nullptr : opts.data());
+  res = finish_compile(p, res, job.get());
+  run_callback(p, *job, res);
+}
+
+// Create a program from a source buffer, headers are copied or borrowed
+hiprtcResult create_program(hiprtcProgram *prog, source_buffer source,
+                            const char *name, int num_headers,
+                            const char **headers, const char **include_names,
+                            bool borrow_headers) {
+  if (num_headers < 0 ||
+      (num_headers > 0 && (headers == nullptr || include_names == nullptr))) {
     return HIPRTC_ERROR_INVALID_INPUT;
   }
 
+  for (int i = 0; i < num_headers; i++) {
+    if (headers[i] == nullptr || include_names[i] == nullptr) {
+      return HIPRTC_ERROR_INVALID_INPUT;
+    }
+  }
+
   auto p = new hiprtc_program;
   p->name_ = (name != nullptr) ? name : "CompileSource";
-  p->source_ = src;
+  p->source_ = std::move(source);
   p->state_ = hiprtc_program_state::Created;
 
   // add headers
   for (int i = 0; i < num_headers; i++) {
-    if (headers[i] == nullptr || include_names[i] == nullptr) {
+    p->headers_.emplace_back(
+        std::string(include_names[i]),
+        borrow_headers
+            ? source_buffer::borrow(headers[i], std::strlen(headers[i]))
+            : source_buffer(std::string(headers[i])));
+  }
+
+  *prog = reinterpret_cast<hiprtcProgram>(p);
+
+  return HIPRTC_SUCCESS;
+}
+} // namespace
+
+hiprtcResult hiprtcCreateProgram(hiprtcProgram *prog, const char *src,
+                                 const char *name, int num_headers,
+                                 const char **headers,
+                                 const char **include_names) {
+  if (prog == nullptr || src == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  return create_program(prog, source_buffer(std::string(src)), name,
+                        num_headers, headers, include_names, false);
+}
+
+hiprtcResult hiprtcCreateProgramBorrowed(hiprtcProgram *prog, const char *src,
+                                         size_t src_size, const char *name,
+                                         int num_headers, const char **headers,
+                                         const char **include_names) {
+  if (prog == nullptr || src == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  return create_program(prog, source_buffer::borrow(src, src_size), name,
+                        num_headers, headers, include_names, true);
+}
+
+hiprtcResult hiprtcCreateProgramFromFile(hiprtcProgram *prog, const char *path,
+                                         const char *name, int num_headers,
+                                         const char **headers,
+                                         const char **include_names) {
+  if (prog == nullptr || path == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  source_buffer source;
+  if (!source_buffer::map(path, source)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  // File name reads better in diagnostics than the default
+  std::string file_name(path);
+  if (auto pos = file_name.find_last_of('/'); pos != std::string::npos) {
+    file_name = file_name.substr(pos + 1);
+  }
+
+  return create_program(prog, std::move(source),
+                        (name != nullptr) ? name : file_name.c_str(),
+                        num_headers, headers, include_names, false);
+}
+
+hiprtcResult hiprtcAppendProgramSource(hiprtcProgram prog, const char *chunk,
+                                       size_t chunk_size) {
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p == nullptr || (chunk == nullptr && chunk_size != 0)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  if (p->state_ != hiprtc_program_state::Created) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  if (!p->source_.append(chunk, chunk_size)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  // Instantiations are of the old source, which they also borrow
+  p->specializations_.clear();
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcDestroyProgram(hiprtcProgram *prog) {
+  if (prog == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  // Drop or wait out an asynchronous compilation and its callback
+  auto p = reinterpret_cast<hiprtc_program *>(*prog);
+  if (p != nullptr) {
+    if (in_flight(p)) {
+      (void)hiprtcCancelCompile(*prog);
+    }
+    (void)hiprtcWaitProgram(*prog);
+  }
+
+  delete p;
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcCompileProgram(hiprtcProgram prog, int num_options,
+                                  const char **options) {
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+
+  if (!valid_options(num_options, options) || (p == nullptr)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  if (!can_compile(p)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  return finish_compile(p, compile(p, num_options, options));
+}
+
+hiprtcResult hiprtcCompileProgramsBatch(hiprtcProgram *progs, int num_progs,
+                                        int num_options, const char **options,
+                                        hiprtcResult *results) {
+  if (progs == nullptr || num_progs < 0 ||
+      !valid_options(num_options, options)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  // Each program is compiled by one worker only
+  std::unordered_set<hiprtc_program *> unique_progs;
+  for (int i = 0; i < num_progs; i++) {
+    auto p = reinterpret_cast<hiprtc_program *>(progs[i]);
+    if (p == nullptr || !can_compile(p) || !unique_progs.insert(p).second) {
+      return HIPRTC_ERROR_INVALID_INPUT;
+    }
+  }
+
+  std::vector<hiprtcResult> res(num_progs, HIPRTC_SUCCESS);
+  thread_pool::get().parallel_for(num_progs, [&](size_t i) {
+    auto p = reinterpret_cast<hiprtc_program *>(progs[i]);
+    res[i] = finish_compile(p, compile(p, num_options, options));
+  });
+
+  hiprtcResult first_error = HIPRTC_SUCCESS;
+  for (int i = 0; i < num_progs; i++) {
+    if (results != nullptr) {
+      results[i] = res[i];
+    }
+    if (first_error == HIPRTC_SUCCESS) {
+      first_error = res[i];
+    }
+  }
+
+  return first_error;
+}
+
+hiprtcResult hiprtcCompileProgramAsync(hiprtcProgram prog, int num_options,
+                                       const char **options,
+                                       hiprtcCompileCallback callback,
+                                       void *user_data) {
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+
+  if (!valid_options(num_options, options) || (p == nullptr)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  // Caller's option strings need not outlive this call
+  std::vector<std::string> opts(options, options + num_options);
+  auto job = std::make_shared<hiprtc_async_job>();
+  job->callback_ = callback;
+  job->user_data_ = user_data;
+  {
+    std::lock_guard<std::mutex> lock(p->mutex_);
+    if (!can_compile(p)) {
       return HIPRTC_ERROR_INVALID_INPUT;
     }
-    p->headers_.push_back(
-        std::make_pair(std::string(include_names[i]), std::string(headers[i])));
+    p->state_ = hiprtc_program_state::Queued;
+    p->job_ = job;
+  }
+
+  thread_pool::get().submit([p, job, opts = std::move(opts)] {
+    run_async_job(p, job, opts);
+  });
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcQueryProgram(hiprtcProgram prog) {
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  if (in_flight(p)) {
+    return HIPRTC_ERROR_NOT_READY;
+  }
+
+  return p->result_;
+}
+
+hiprtcResult hiprtcWaitProgram(hiprtcProgram prog) {
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  std::unique_lock<std::mutex> lock(p->mutex_);
+  for (;;) {
+    p->cv_.wait(lock, [p] { return !in_flight(p); });
+    auto job = p->job_;
+    if (job == nullptr) {
+      break;
+    }
+
+    // Then for its callback, unless called from it
+    lock.unlock();
+    {
+      std::unique_lock<std::mutex> job_lock(job->mutex_);
+      job->cv_.wait(job_lock, [&job] {
+        return job->callback_done_ ||
+               job->callback_thread_ == std::this_thread::get_id();
+      });
+      if (!job->callback_done_) {
+        return p->result_;
+      }
+    }
+    lock.lock();
+
+    // Callback may have started another compilation
+    if (p->job_ == job) {
+      break;
+    }
+  }
+
+  return p->result_;
+}
+
+hiprtcResult hiprtcCancelCompile(hiprtcProgram prog) {
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  std::unique_lock<std::mutex> lock(p->mutex_);
+  if (!in_flight(p) || p->job_ == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  // Running compilation discards its result when it is done
+  auto job = p->job_;
+  std::unique_lock<std::mutex> job_lock(job->mutex_);
+  job->cancelled_ = true;
+  if (job->started_) {
+    return HIPRTC_SUCCESS;
+  }
+  job_lock.unlock();
+  lock.unlock();
+
+  // Queued work is dropped right away, worker skips it
+  finish_compile(p, HIPRTC_ERROR_CANCELLED);
+  run_callback(p, *job, HIPRTC_ERROR_CANCELLED);
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcGetProgramLogSize(hiprtcProgram prog, size_t *log_size) {
+  if (log_size == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (in_flight(p)) {
+    return HIPRTC_ERROR_NOT_READY;
+  }
+
+  *log_size = p->log_.size();
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcGetProgramLog(hiprtcProgram prog, const char *dst) {
+  if (dst == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (in_flight(p)) {
+    return HIPRTC_ERROR_NOT_READY;
+  }
+
+  std::memcpy((void *)dst, p->log_.data(), p->log_.size());
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcGetProgramStats(hiprtcProgram prog,
+                                   hiprtcProgramStats *stats) {
+  if (stats == nullptr || stats->struct_size < sizeof(size_t)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (in_flight(p)) {
+    return HIPRTC_ERROR_NOT_READY;
+  }
+
+  hiprtcProgramStats out;
+  out.struct_size = std::min(stats->struct_size, sizeof(out));
+  out.total_ms = p->stats_.total_ms_;
+  out.target_ms = p->stats_.target_ms_;
+  out.cache_ms = p->stats_.cache_ms_;
+  out.pch_ms = p->stats_.pch_ms_;
+  out.dataset_ms = p->stats_.dataset_ms_;
+  out.frontend_ms = p->stats_.frontend_ms_;
+  out.codegen_ms = p->stats_.codegen_ms_;
+  out.link_ms = p->stats_.link_ms_;
+  out.extract_ms = p->stats_.extract_ms_;
+  out.lowering_ms = p->stats_.lowering_ms_;
+  out.bundle_ms = p->stats_.bundle_ms_;
+  out.source_bytes = p->stats_.source_bytes_;
+  out.header_bytes = p->stats_.header_bytes_;
+  out.bitcode_bytes = p->stats_.bitcode_bytes_;
+  out.object_bytes = p->stats_.object_bytes_;
+  out.cache_hits = p->stats_.cache_hits_;
+  out.bitcode_cache_hits = p->stats_.bitcode_cache_hits_;
+  out.pch_hits = p->stats_.pch_hits_;
+
+  // Older callers only know a prefix of the struct
+  std::memcpy(stats, &out, out.struct_size);
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcGetKernelInfo(hiprtcProgram prog, const char *target,
+                                 const char *kernel, hiprtcKernelInfo *info) {
+  if (kernel == nullptr || info == nullptr ||
+      info->struct_size < sizeof(size_t)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p == nullptr || p->state_ != hiprtc_program_state::Compiled) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto it = (target != nullptr)
+                ? std::find(p->targets_.begin(), p->targets_.end(), target)
+                : p->targets_.begin();
+  if (it == p->targets_.end() ||
+      (target == nullptr && p->targets_.size() != 1)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  program_kernels *kernels = nullptr;
+  size_t i = 0;
+  if (auto res = find_kernel(p, *it, kernel, kernels, i);
+      res != HIPRTC_SUCCESS) {
+    return res;
+  }
+
+  auto &k = kernels->kernels_[i];
+  auto &args = kernels->args_[i];
+  hiprtcKernelInfo out;
+  out.struct_size = std::min(info->struct_size, sizeof(out));
+  out.name = k.name_.c_str();
+  out.symbol = k.symbol_.c_str();
+  out.vgpr_count = k.vgpr_count_;
+  out.sgpr_count = k.sgpr_count_;
+  out.agpr_count = k.agpr_count_;
+  out.vgpr_spill_count = k.vgpr_spill_count_;
+  out.sgpr_spill_count = k.sgpr_spill_count_;
+  out.lds_size = k.group_segment_size_;
+  out.scratch_size = k.private_segment_size_;
+  out.max_flat_workgroup_size = k.max_flat_workgroup_size_;
+  out.wavefront_size = k.wavefront_size_;
+  out.kernarg_size = k.kernarg_size_;
+  out.kernarg_align = k.kernarg_align_;
+  out.num_args = args.size();
+  out.args = args.empty() ? nullptr : args.data();
+
+  // Older callers only know a prefix of the struct
+  std::memcpy(info, &out, out.struct_size);
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcEstimateOccupancy(hiprtcProgram prog, const char *kernel,
+                                     size_t block_size, size_t dynamic_lds,
+                                     const char *target,
+                                     hiprtcOccupancy *occupancy) {
+  if (kernel == nullptr || occupancy == nullptr ||
+      occupancy->struct_size < sizeof(size_t)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p == nullptr || p->state_ != hiprtc_program_state::Compiled) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  // Without a target, the one a compile without target options would pick
+  std::vector<std::string> requested;
+  if (target != nullptr) {
+    requested.push_back(target);
+  } else if (p->targets_.size() == 1) {
+    requested = p->targets_;
+  } else {
+    std::vector<std::string> no_options;
+    target::resolve(no_options, requested);
+  }
+  auto it = std::find_first_of(p->targets_.begin(), p->targets_.end(),
+                               requested.begin(), requested.end());
+  if (it == p->targets_.end()) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto limits = occupancy::get_limits(*it);
+  if (limits == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  program_kernels *kernels = nullptr;
+  size_t i = 0;
+  if (auto res = find_kernel(p, *it, kernel, kernels, i);
+      res != HIPRTC_SUCCESS) {
+    return res;
+  }
+
+  auto &k = kernels->kernels_[i];
+  occupancy_estimate estimate;
+  if ((k.max_flat_workgroup_size_ != 0 &&
+       block_size > k.max_flat_workgroup_size_) ||
+      !occupancy::estimate(k, *limits, block_size, dynamic_lds, estimate)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
   }
 
-  *prog = reinterpret_cast<hiprtcProgram>(p);
+  hiprtcOccupancy out;
+  out.struct_size = std::min(occupancy->struct_size, sizeof(out));
+  out.waves_per_simd = double(estimate.waves_per_cu_) / limits->simds_per_cu_;
+  out.max_waves_per_simd = limits->max_waves_per_simd_;
+  out.workgroups_per_cu = estimate.workgroups_per_cu_;
+  out.limit = estimate.limit_;
+  out.suggested_block_size =
+      occupancy::suggest_block_size(k, *limits, dynamic_lds);
+  out.suggested_waves_per_simd = 0;
+  if (occupancy_estimate suggested;
+      occupancy::estimate(k, *limits, out.suggested_block_size, dynamic_lds,
+                          suggested)) {
+    out.suggested_waves_per_simd =
+        double(suggested.waves_per_cu_) / limits->simds_per_cu_;
+  }
+
+  // Older callers only know a prefix of the struct
+  std::memcpy(occupancy, &out, out.struct_size);
 
   return HIPRTC_SUCCESS;
 }
 
-hiprtcResult hiprtcDestroyProgram(hiprtcProgram *prog) {
-  if (prog == nullptr) {
+hiprtcResult hiprtcRegisterHeader(hiprtcHeader *header, const char *name,
+                                  const char *src) {
+  if (header == nullptr || name == nullptr || src == nullptr) {
     return HIPRTC_ERROR_INVALID_INPUT;
   }
 
-  delete reinterpret_cast<hiprtc_program *>(*prog);
+  auto registered = header_registry::add(name, src);
+  if (registered == nullptr) {
+    return HIPRTC_ERROR_BUILTIN_OPERATION_FAILURE;
+  }
+  *header = const_cast<registered_header *>(registered);
 
   return HIPRTC_SUCCESS;
 }
 
-hiprtcResult hiprtcCompileProgram(hiprtcProgram prog, int num_options,
-                                  const char **options) {
-  auto p = reinterpret_cast<hiprtc_program *>(prog);
+hiprtcResult hiprtcReleaseHeader(hiprtcHeader header) {
+  if (!header_registry::release(
+          reinterpret_cast<const registered_header *>(header))) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  return HIPRTC_SUCCESS;
+}
 
-  if ((num_options == 0 && options != nullptr) ||
-      (num_options != 0 && options == nullptr) || (p == nullptr)) {
+hiprtcResult hiprtcAddProgramHeaders(hiprtcProgram prog, int num_headers,
+                                     const hiprtcHeader *headers) {
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p == nullptr || num_headers < 0 ||
+      (num_headers > 0 && headers == nullptr)) {
     return HIPRTC_ERROR_INVALID_INPUT;
   }
 
@@ -99,57 +842,91 @@ hiprtcResult hiprtcCompileProgram(hiprtcProgram prog, int num_options,
     return HIPRTC_ERROR_INVALID_INPUT;
   }
 
-  /* Append user options */
-  std::vector<std::string> opts;
-  opts.reserve(num_options + 8);
-  opts.push_back("-O3");
-  opts.push_back("-std=c++17");
-  opts.push_back("-nogpuinc");
-  opts.push_back("-D__HIPCC_RTC__");
-  opts.push_back("-include");
-  opts.push_back("hiprtc_internal_header.h");
-  opts.push_back("-Wno-gnu-line-marker");
-  opts.push_back("-Wno-missing-prototypes");
-
-  if (num_options != 0) {
-    for (int i = 0; i < num_options; i++) {
-      opts.push_back(options[i]);
+  // Resolve all handles first, a bad one leaves the program unchanged
+  std::vector<std::shared_ptr<const registered_header>> added;
+  added.reserve(num_headers);
+  for (int i = 0; i < num_headers; i++) {
+    auto header = header_registry::get(
+        reinterpret_cast<const registered_header *>(headers[i]));
+    if (header == nullptr) {
+      return HIPRTC_ERROR_INVALID_INPUT;
     }
+    added.push_back(std::move(header));
   }
+  p->registered_headers_.insert(p->registered_headers_.end(), added.begin(),
+                                added.end());
+  p->specializations_.clear();
 
-  if (!compile_program(p, opts)) {
-    p->state_ = hiprtc_program_state::Error;
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcGetCodeSize(hiprtcProgram prog, size_t *binary_size) {
+  if (binary_size == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p->state_ != hiprtc_program_state::Compiled) {
     return HIPRTC_ERROR_COMPILATION;
   }
-  p->state_ = hiprtc_program_state::Compiled;
+
+  *binary_size = p->code_size_;
 
   return HIPRTC_SUCCESS;
 }
 
-hiprtcResult hiprtcGetProgramLogSize(hiprtcProgram prog, size_t *log_size) {
-  if (log_size == nullptr) {
+hiprtcResult hiprtcGetCode(hiprtcProgram prog, char *binary) {
+  if (binary == nullptr) {
     return HIPRTC_ERROR_INVALID_INPUT;
   }
 
   auto p = reinterpret_cast<hiprtc_program *>(prog);
-  *log_size = p->log_.size();
+  if (p->state_ != hiprtc_program_state::Compiled) {
+    return HIPRTC_ERROR_COMPILATION;
+  }
+
+  std::memcpy((void *)binary, p->code_, p->code_size_);
 
   return HIPRTC_SUCCESS;
 }
 
-hiprtcResult hiprtcGetProgramLog(hiprtcProgram prog, const char *dst) {
-  if (dst == nullptr) {
+hiprtcResult hiprtcGetCodePtr(hiprtcProgram prog, const void **code,
+                              size_t *code_size) {
+  if (code == nullptr || code_size == nullptr) {
     return HIPRTC_ERROR_INVALID_INPUT;
   }
 
   auto p = reinterpret_cast<hiprtc_program *>(prog);
-  std::memcpy((void *)dst, p->log_.data(), p->log_.size());
+  if (p->state_ != hiprtc_program_state::Compiled) {
+    return HIPRTC_ERROR_COMPILATION;
+  }
+
+  *code = p->code_;
+  *code_size = p->code_size_;
 
   return HIPRTC_SUCCESS;
 }
 
-hiprtcResult hiprtcGetCodeSize(hiprtcProgram prog, size_t *binary_size) {
-  if (binary_size == nullptr) {
+hiprtcResult hiprtcSetCodeAllocator(hiprtcProgram prog,
+                                    hiprtcCodeAllocator allocator,
+                                    void *user_data) {
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  if (in_flight(p)) {
+    return HIPRTC_ERROR_NOT_READY;
+  }
+
+  p->allocator_ = allocator;
+  p->allocator_data_ = user_data;
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcGetBitcodeSize(hiprtcProgram prog, size_t *bitcode_size) {
+  if (bitcode_size == nullptr) {
     return HIPRTC_ERROR_INVALID_INPUT;
   }
 
@@ -158,13 +935,18 @@ hiprtcResult hiprtcGetCodeSize(hiprtcProgram prog, size_t *binary_size) {
     return HIPRTC_ERROR_COMPILATION;
   }
 
-  *binary_size = p->object_.size();
+  // Code object from the disk cache whose bitcode was evicted
+  if (p->outputs_.size() != 1 || p->outputs_[0]->bitcode_ == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  *bitcode_size = p->outputs_[0]->bitcode().size();
 
   return HIPRTC_SUCCESS;
 }
 
-hiprtcResult hiprtcGetCode(hiprtcProgram prog, char *binary) {
-  if (binary == nullptr) {
+hiprtcResult hiprtcGetBitcode(hiprtcProgram prog, char *bitcode) {
+  if (bitcode == nullptr) {
     return HIPRTC_ERROR_INVALID_INPUT;
   }
 
@@ -173,14 +955,24 @@ hiprtcResult hiprtcGetCode(hiprtcProgram prog, char *binary) {
     return HIPRTC_ERROR_COMPILATION;
   }
 
-  std::memcpy((void *)binary, p->object_.data(), p->object_.size());
+  if (p->outputs_.size() != 1 || p->outputs_[0]->bitcode_ == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto output = p->outputs_[0]->bitcode();
+  std::memcpy((void *)bitcode, output.data(), output.size());
 
   return HIPRTC_SUCCESS;
 }
 
 hiprtcResult hiprtcAddNameExpression(hiprtcProgram prog,
                                      const char *name_expression) {
-  if (name_expression == nullptr) {
+  return hiprtcAddNameExpressions(prog, 1, &name_expression);
+}
+
+hiprtcResult hiprtcAddNameExpressions(hiprtcProgram prog, int num_names,
+                                      const char **name_expressions) {
+  if (num_names < 0 || (num_names > 0 && name_expressions == nullptr)) {
     return HIPRTC_ERROR_NAME_EXPRESSION_NOT_VALID;
   }
 
@@ -192,19 +984,20 @@ hiprtcResult hiprtcAddNameExpression(hiprtcProgram prog,
     return HIPRTC_ERROR_INVALID_INPUT;
   }
 
-  std::string name = name_expression;
-  p->lowered_names_[std::string(name_expression)] = std::string();
-
-  // Now add code that instantiates the template
-  std::string gcn_expr = "__amdgcn_name_expr_";
-  std::string size = std::to_string(p->lowered_names_.size());
-  const auto var1{"\n static __device__ const void* " + gcn_expr + size +
-                  "[]= {\"" + name + "\", (void*)&" + name + "};"};
-  const auto var2{"\n static auto __amdgcn_name_expr_stub_" + size + " = " +
-                  gcn_expr + size + ";\n"};
-  const auto code{var1 + var2};
+  for (int i = 0; i < num_names; i++) {
+    if (name_expressions[i] == nullptr) {
+      return HIPRTC_ERROR_NAME_EXPRESSION_NOT_VALID;
+    }
+  }
 
-  p->source_ += code;
+  // Code instantiating the templates is generated once at compile time
+  p->name_expressions_.reserve(p->name_expressions_.size() + num_names);
+  for (int i = 0; i < num_names; i++) {
+    std::string name(name_expressions[i]);
+    if (p->lowered_names_.emplace(name, std::string()).second) {
+      p->name_expressions_.push_back(std::move(name));
+    }
+  }
 
   return HIPRTC_SUCCESS;
 }
@@ -229,4 +1022,358 @@ hiprtcResult hiprtcGetLoweredName(hiprtcProgram prog,
   *lowered_name = p->lowered_names_[name].data();
 
   return HIPRTC_SUCCESS;
-}
\ No newline at end of file
+}
+
+hiprtcResult hiprtcAddSpecializationParameters(hiprtcProgram prog,
+                                               const char *kernel,
+                                               int num_params,
+                                               const char **params) {
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p == nullptr || kernel == nullptr || *kernel == '\0' ||
+      num_params <= 0 || params == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  std::vector<std::string> names;
+  names.reserve(num_params);
+  for (int i = 0; i < num_params; i++) {
+    if (params[i] == nullptr) {
+      return HIPRTC_ERROR_INVALID_INPUT;
+    }
+    names.push_back(params[i]);
+  }
+  p->specialization_parameters_[kernel] = std::move(names);
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcSpecializeKernel(hiprtcProgram prog, const char *kernel,
+                                    int num_values, const char **values,
+                                    int num_options, const char **options,
+                                    const char **lowered_name,
+                                    const void **code, size_t *code_size) {
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p == nullptr || kernel == nullptr || num_values < 0 ||
+      (num_values > 0 && values == nullptr) ||
+      !valid_options(num_options, options) || lowered_name == nullptr ||
+      code == nullptr || code_size == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  if (in_flight(p)) {
+    return HIPRTC_ERROR_NOT_READY;
+  }
+
+  auto params = p->specialization_parameters_.find(kernel);
+  if (params == p->specialization_parameters_.end()) {
+    p->log_ = "No specialization parameters declared for " +
+              std::string(kernel) + "\n";
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+  if (static_cast<size_t>(num_values) != params->second.size()) {
+    p->log_ = "Expected " + std::to_string(params->second.size()) +
+              " values to specialize " + std::string(kernel) + ", got " +
+              std::to_string(num_values) + "\n";
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  // Name expression of the instantiation, e.g. gemm<64, float>
+  std::string name_expression = std::string(kernel) + "<";
+  for (int i = 0; i < num_values; i++) {
+    if (values[i] == nullptr || *values[i] == '\0') {
+      p->log_ = "Missing value of specialization parameter " +
+                params->second[i] + " of " + std::string(kernel) + "\n";
+      return HIPRTC_ERROR_INVALID_INPUT;
+    }
+    name_expression += (i == 0) ? "" : ", ";
+    name_expression += values[i];
+  }
+  name_expression += ">";
+
+  // Values and options given before are served without compiling, options
+  // spelled differently for the same compile included
+  std::vector<std::string> key_options;
+  for (int i = 0; i < num_options; i++) {
+    if (options[i] == nullptr) {
+      return HIPRTC_ERROR_INVALID_INPUT;
+    }
+    key_options.push_back(options[i]);
+  }
+  if (!compile_options::canonicalize(key_options, p->log_)) {
+    return HIPRTC_ERROR_INVALID_OPTION;
+  }
+  std::string key = name_expression;
+  for (auto &option : key_options) {
+    key += '\0';
+    key += option;
+  }
+  auto &s = p->specializations_[key];
+  if (s == nullptr) {
+    auto specialization = create_specialization(p, name_expression);
+    auto res = finish_compile(specialization.get(),
+                              compile(specialization.get(), num_options,
+                                      options));
+    if (res != HIPRTC_SUCCESS) {
+      p->log_ = std::move(specialization->log_);
+      p->specializations_.erase(key);
+      return res;
+    }
+    s = std::move(specialization);
+  }
+
+  *lowered_name = s->lowered_names_[name_expression].data();
+  *code = s->code_;
+  *code_size = s->code_size_;
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcSetDiskCache(const char *path, size_t max_size) {
+  if (!disk_cache::configure((path != nullptr) ? path : "", max_size)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcGetDiskCacheStats(hiprtcDiskCacheStats *stats) {
+  if (stats == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto cache_stats = disk_cache::get_stats();
+  stats->hits = cache_stats.hits;
+  stats->misses = cache_stats.misses;
+  stats->stores = cache_stats.stores;
+  stats->evictions = cache_stats.evictions;
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcSetMemoryCacheLimit(size_t max_size) {
+  memory_cache::set_limit(max_size);
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcGetMemoryCacheStats(hiprtcMemoryCacheStats *stats) {
+  if (stats == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto cache_stats = memory_cache::get_stats();
+  stats->hits = cache_stats.hits;
+  stats->misses = cache_stats.misses;
+  stats->evictions = cache_stats.evictions;
+  stats->entries = cache_stats.entries;
+  stats->size = cache_stats.size;
+  stats->limit = cache_stats.limit;
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcFlushMemoryCache() {
+  memory_cache::flush();
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcGetTargetCodeSize(hiprtcProgram prog, const char *target,
+                                     size_t *binary_size) {
+  if (target == nullptr || binary_size == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p->state_ != hiprtc_program_state::Compiled) {
+    return HIPRTC_ERROR_COMPILATION;
+  }
+
+  auto it = std::find(p->targets_.begin(), p->targets_.end(), target);
+  if (it == p->targets_.end()) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  *binary_size = p->outputs_[it - p->targets_.begin()]->object_.size();
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcGetTargetCode(hiprtcProgram prog, const char *target,
+                                 char *binary) {
+  if (target == nullptr || binary == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto p = reinterpret_cast<hiprtc_program *>(prog);
+  if (p->state_ != hiprtc_program_state::Compiled) {
+    return HIPRTC_ERROR_COMPILATION;
+  }
+
+  auto it = std::find(p->targets_.begin(), p->targets_.end(), target);
+  if (it == p->targets_.end()) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto &object = p->outputs_[it - p->targets_.begin()]->object_;
+  std::memcpy((void *)binary, object.data(), object.size());
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcLinkCreate(hiprtcLinkState *state, int num_options,
+                              const char **options) {
+  if (state == nullptr || !valid_options(num_options, options)) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  auto link = new hiprtc_link;
+  link->options_.push_back("-O3");
+  for (int i = 0; i < num_options; i++) {
+    link->options_.push_back(options[i]);
+  }
+
+  *state = reinterpret_cast<hiprtcLinkState>(link);
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcLinkAddData(hiprtcLinkState state, hiprtcLinkInputType type,
+                               const void *data, size_t size,
+                               const char *name) {
+  auto link = reinterpret_cast<hiprtc_link *>(state);
+  if (link == nullptr || data == nullptr || size == 0 || link->completed_) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  std::vector<std::pair<std::string, std::vector<char>>> *inputs = nullptr;
+  switch (type) {
+  case HIPRTC_LINK_INPUT_RELOCATABLE:
+    inputs = &link->relocatables_;
+    break;
+  case HIPRTC_LINK_INPUT_BITCODE:
+    inputs = &link->bitcodes_;
+    break;
+  default:
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  // comgr needs distinct names for the inputs
+  std::string input_name = (name != nullptr) ? name : "input";
+  input_name = std::to_string(link->relocatables_.size() +
+                              link->bitcodes_.size()) +
+               "_" + input_name;
+
+  auto bytes = static_cast<const char *>(data);
+  inputs->emplace_back(std::move(input_name),
+                       std::vector<char>(bytes, bytes + size));
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcLinkAddFile(hiprtcLinkState state, hiprtcLinkInputType type,
+                               const char *path) {
+  if (path == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  std::vector<char> data((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+  if (file.bad()) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  std::string name(path);
+  if (auto pos = name.find_last_of('/'); pos != std::string::npos) {
+    name = name.substr(pos + 1);
+  }
+
+  return hiprtcLinkAddData(state, type, data.data(), data.size(),
+                           name.c_str());
+}
+
+hiprtcResult hiprtcLinkComplete(hiprtcLinkState state, void **code,
+                                size_t *code_size) {
+  auto link = reinterpret_cast<hiprtc_link *>(state);
+  if (link == nullptr || code == nullptr || code_size == nullptr ||
+      link->completed_) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  if (link->relocatables_.empty() && link->bitcodes_.empty()) {
+    link->log_ = "Nothing to link\n";
+    return HIPRTC_ERROR_LINKING;
+  }
+
+  // Pick target, consumes target options
+  auto options = link->options_;
+  std::vector<std::string> target_ids;
+  if (!target::resolve(options, target_ids)) {
+    link->log_ = "Invalid target: " + target_ids.front() + "\n";
+    return HIPRTC_ERROR_INVALID_OPTION;
+  }
+
+  if (target_ids.size() > 1) {
+    link->log_ = "Link supports a single target\n";
+    return HIPRTC_ERROR_INVALID_OPTION;
+  }
+
+  if (target_ids.empty()) {
+    link->log_ = "No device found, pass --offload-arch=<target> or set "
+                 "HIPRTC_TARGET\n";
+    return HIPRTC_ERROR_LINKING;
+  }
+
+  link->options_ = std::move(options);
+  if (!link_program(link, target::get_isa_name(target_ids.front()))) {
+    return HIPRTC_ERROR_LINKING;
+  }
+
+  // Inputs are not needed anymore
+  link->completed_ = true;
+  link->relocatables_.clear();
+  link->bitcodes_.clear();
+
+  *code = link->object_.data();
+  *code_size = link->object_.size();
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcGetLinkLogSize(hiprtcLinkState state, size_t *log_size) {
+  auto link = reinterpret_cast<hiprtc_link *>(state);
+  if (link == nullptr || log_size == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  *log_size = link->log_.size();
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcGetLinkLog(hiprtcLinkState state, char *log) {
+  auto link = reinterpret_cast<hiprtc_link *>(state);
+  if (link == nullptr || log == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  std::memcpy((void *)log, link->log_.data(), link->log_.size());
+
+  return HIPRTC_SUCCESS;
+}
+
+hiprtcResult hiprtcLinkDestroy(hiprtcLinkState *state) {
+  if (state == nullptr) {
+    return HIPRTC_ERROR_INVALID_INPUT;
+  }
+
+  delete reinterpret_cast<hiprtc_link *>(*state);
+  *state = nullptr;
+
+  return HIPRTC_SUCCESS;
+}
@@ -0,0 +1,17 @@
+#include "compile_daemon.hpp"
+#include "env.hpp"
+
+#include <iostream>
+#include <string>
+
+// Node local compile daemon, clients set HIPRTC_DAEMON_SOCKET to its socket
+int main(int argc, char **argv) {
+  std::string path = (argc > 1) ? argv[1] : get_env("HIPRTC_DAEMON_SOCKET");
+  if (path.empty()) {
+    std::cerr << "usage: hiprtc-daemon <socket path>, or set "
+                 "HIPRTC_DAEMON_SOCKET"
+              << std::endl;
+    return 1;
+  }
+  return compile_daemon::serve(path);
+}
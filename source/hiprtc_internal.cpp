@@ -2,58 +2,34 @@
 #include <string>
 
 #include "comgr_wrapper.hpp"
+#include "compile_daemon.hpp"
+#include "compile_stats.hpp"
+#include "disk_cache.hpp"
+#include "fingerprint.hpp"
+#include "header_registry.hpp"
 #include "hiprtc_internal.hpp"
-#include "rocm_smi.hpp"
-
-const char hiprtc_internal_header[] = {
-#include "hiprtc_internal_header_generated.hpp"
-};
-
-std::string get_build_log(amd_comgr_data_set_t &data_set) {
-  size_t count = 0;
-  if (auto comgr_res = amd_comgr_action_data_count(
-          data_set, AMD_COMGR_DATA_KIND_LOG, &count);
-      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
-    return "";
-  }
-
-  if (count > 0) {
-    amd_comgr_data_t binary_data;
-
-    if (auto res = amd_comgr_action_data_get_data(
-            data_set, AMD_COMGR_DATA_KIND_LOG, 0, &binary_data);
-        res != AMD_COMGR_STATUS_SUCCESS) {
-      return "";
-    }
-
-    size_t binary_size = 0;
-    if (auto res = amd_comgr_get_data(binary_data, &binary_size, NULL);
-        res != AMD_COMGR_STATUS_SUCCESS) {
-      (void)amd_comgr_release_data(binary_data);
-      return "";
-    }
-
-    std::string log(binary_size, 0);
-
-    if (auto res = amd_comgr_get_data(binary_data, &binary_size, log.data());
-        res != AMD_COMGR_STATUS_SUCCESS) {
-      (void)amd_comgr_release_data(binary_data);
-      return "";
-    }
-
-    (void)amd_comgr_release_data(binary_data);
-    return log;
-  } else {
-    return "";
-  }
-}
+#include "internal_header.hpp"
+#include "memory_cache.hpp"
+#include "name_expressions.hpp"
+#include "offload_bundle.hpp"
+#include "pch.hpp"
+#include "target.hpp"
+#include "thread_pool.hpp"
+#include "worker_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <unistd.h>
 
 bool get_mangled_names(
-    const std::vector<char> &exe,
+    const std::vector<char> &exe, amd_comgr_data_kind_t kind,
     std::unordered_map<std::string, std::string> &mangled_names) {
   amd_comgr_data_t data;
-  if (auto comgr_res =
-          amd_comgr_create_data(AMD_COMGR_DATA_KIND_EXECUTABLE, &data);
+  if (auto comgr_res = amd_comgr_create_data(kind, &data);
       comgr_res != AMD_COMGR_STATUS_SUCCESS) {
     return false;
   }
@@ -98,11 +74,278 @@ bool get_mangled_names(
   return true;
 }
 
-// Big func, might refactor later
-bool compile_program(hiprtc_program *prog,
-                     const std::vector<std::string> &options) {
-  // clear the existing log
-  prog->log_.clear();
+/**
+ * @brief Check if the program is compiled to relocatable device code
+ *
+ * @param options final option list, last of -fgpu-rdc and -fno-gpu-rdc wins
+ */
+bool is_relocatable_device_code(const std::vector<std::string> &options) {
+  bool rdc = false;
+  for (auto &option : options) {
+    if (option == "-fgpu-rdc") {
+      rdc = true;
+    } else if (option == "-fno-gpu-rdc") {
+      rdc = false;
+    }
+  }
+  return rdc;
+}
+
+/**
+ * @brief Split options between the front end and code generation
+ *
+ * -mllvm only tunes LLVM passes and code generation, so it does not reach the
+ * front end and changing it reuses the bitcode. -O and -m options are needed
+ * by both: the front end defines __OPTIMIZE__ and target features from them.
+ * With LLVM passes disabled -O1, -O2 and -O3 emit the same bitcode, the front
+ * end gets -O3 for any of them so that trying levels reuses it. -O0, -Os and
+ * -Oz change the bitcode and go as they are. -ftime-report and -ftime-trace
+ * go to both to time each stage.
+ *
+ * @param options final option list
+ * @param frontend_options options of source to bitcode
+ * @param codegen_options options of bitcode to relocatable
+ */
+void split_options(const std::vector<std::string> &options,
+                   std::vector<std::string> &frontend_options,
+                   std::vector<std::string> &codegen_options) {
+  frontend_options.clear();
+  codegen_options.clear();
+  for (size_t i = 0; i < options.size(); i++) {
+    auto &option = options[i];
+    if (option == "-mllvm") {
+      codegen_options.push_back(option);
+      if (i + 1 < options.size()) {
+        codegen_options.push_back(options[++i]);
+      }
+      continue;
+    }
+    if (option.rfind("-O", 0) == 0 || option.rfind("-m", 0) == 0 ||
+        option.rfind("-ftime-", 0) == 0) {
+      codegen_options.push_back(option);
+    }
+    if (option == "-O1" || option == "-O2") {
+      frontend_options.push_back("-O3");
+      continue;
+    }
+    frontend_options.push_back(option);
+  }
+
+  // Optimization is left to code generation, which runs the -O pipeline
+  frontend_options.push_back("-Xclang");
+  frontend_options.push_back("-disable-llvm-passes");
+}
+
+/**
+ * @brief Fingerprint everything that can change the bitcode of a program
+ *
+ * @param prog program, source already has name expressions appended
+ * @param isa_name target isa
+ * @param frontend_options option list passed to the front end
+ * @return std::string key of the bitcode cache entry
+ */
+std::string get_bitcode_key(const hiprtc_program *prog,
+                            const std::string &isa_name,
+                            const std::vector<std::string> &frontend_options) {
+  size_t comgr_major = 0, comgr_minor = 0;
+  amd_comgr_get_version(&comgr_major, &comgr_minor);
+
+  fingerprint fp;
+  fp.add(uint64_t(HIPRTC_MAJOR_VERSION))
+      .add(uint64_t(HIPRTC_MINOR_VERSION))
+      .add(uint64_t(comgr_major))
+      .add(uint64_t(comgr_minor))
+      .add(get_internal_header_hash())
+      .add(std::string("bitcode"))
+      .add(isa_name)
+      .add(prog->name_)
+      .add(prog->source_.view());
+
+  fp.add(uint64_t(prog->name_expressions_.size()));
+  for (auto &name : prog->name_expressions_) {
+    fp.add(name);
+  }
+
+  fp.add(uint64_t(prog->headers_.size()));
+  for (auto &header : prog->headers_) {
+    fp.add(header.first).add(header.second.view());
+  }
+
+  fp.add(uint64_t(prog->registered_headers_.size()));
+  for (auto &header : prog->registered_headers_) {
+    fp.add(header->hash_);
+  }
+
+  fp.add(uint64_t(frontend_options.size()));
+  for (auto &option : frontend_options) {
+    fp.add(option);
+  }
+
+  return fp.hex();
+}
+
+/**
+ * @brief Fingerprint everything that can change the output of a compilation
+ *
+ * @param bitcode_key key of the bitcode the code object is built from
+ * @param options final option list, used by code generation and link
+ * @return std::string key of the cache entry
+ */
+std::string get_cache_key(const std::string &bitcode_key,
+                          const std::vector<std::string> &options) {
+  fingerprint fp;
+  fp.add(bitcode_key).add(uint64_t(options.size()));
+  for (auto &option : options) {
+    fp.add(option);
+  }
+  return fp.hex();
+}
+
+/**
+ * @brief Check a cache entry has every lowered name the program asks for
+ *
+ * A code object read from disk may lack its bitcode, once the bitcode entry it
+ * shares is evicted. It is served all the same, only hiprtcGetBitcode fails.
+ */
+bool usable_cache_entry(const hiprtc_program *prog, const cache_entry &entry) {
+  for (auto &name_pair : prog->lowered_names_) {
+    if (entry.lowered_names_.find(name_pair.first) ==
+        entry.lowered_names_.end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Check if clang is asked to report its own timing
+ *
+ * Such compilations bypass the caches, a hit would have nothing to report.
+ */
+bool wants_time_report(const std::vector<std::string> &options) {
+  return std::any_of(options.begin(), options.end(), [](const std::string &o) {
+    return o == "-ftime-report" || o == "-ftime-trace";
+  });
+}
+
+/**
+ * @brief Point a bare -ftime-trace at a file to be read back into the log
+ *
+ * Without a path clang writes the trace next to its output, in a directory
+ * comgr removes. A path given by the user is left alone.
+ *
+ * @param options action options, rewritten in place
+ * @return std::string trace file, empty if no trace is requested
+ */
+std::string redirect_time_trace(std::vector<std::string> &options) {
+  static std::atomic<uint64_t> counter{0};
+  auto it = std::find(options.begin(), options.end(), "-ftime-trace");
+  if (it == options.end()) {
+    return "";
+  }
+  auto path = (std::filesystem::temp_directory_path() /
+               ("hiprtc_time_trace_" + std::to_string(getpid()) + "_" +
+                std::to_string(counter++) + ".json"))
+                  .string();
+  *it = "-ftime-trace=" + path;
+  return path;
+}
+
+/**
+ * @brief Move a time trace written by clang into the log
+ *
+ * @param path trace file from redirect_time_trace, nothing to do if empty
+ * @param stage name of the stage, heads the trace in the log
+ * @param log log to append to
+ */
+void append_time_trace(const std::string &path, const char *stage,
+                       std::string &log) {
+  if (path.empty()) {
+    return;
+  }
+  std::ifstream file(path);
+  if (file) {
+    log += std::string("Time trace of ") + stage + ":\n";
+    log.append(std::istreambuf_iterator<char>(file),
+               std::istreambuf_iterator<char>());
+    log += "\n";
+  }
+  std::error_code ec;
+  std::filesystem::remove(path, ec);
+}
+
+std::vector<bool>
+find_reachable_headers(const hiprtc_program *prog, std::string_view source,
+                       const std::vector<std::string> &options) {
+  auto file_name = [](std::string_view name) {
+    auto slash = name.rfind('/');
+    return (slash == std::string_view::npos) ? name : name.substr(slash + 1);
+  };
+
+  std::vector<std::string> pending;
+  bool literal = header_registry::scan_includes(source, pending);
+  for (size_t i = 0; i + 1 < options.size(); i++) {
+    if (options[i] == "-include") {
+      pending.push_back(options[++i]);
+    }
+  }
+
+  auto plain = prog->headers_.size();
+  std::vector<bool> reached(plain + prog->registered_headers_.size(), false);
+  while (literal && !pending.empty()) {
+    auto name = std::move(pending.back());
+    pending.pop_back();
+    for (size_t i = 0; i < reached.size(); i++) {
+      if (reached[i]) {
+        continue;
+      }
+      if (i < plain) {
+        auto &header = prog->headers_[i];
+        if (file_name(header.first) == file_name(name)) {
+          reached[i] = true;
+          literal = header_registry::scan_includes(header.second.view(),
+                                                   pending) &&
+                    literal;
+        }
+      } else {
+        auto &header = *prog->registered_headers_[i - plain];
+        if (file_name(header.name_) == file_name(name)) {
+          reached[i] = true;
+          pending.insert(pending.end(), header.includes_.begin(),
+                         header.includes_.end());
+          literal = !header.computed_include_ && literal;
+        }
+      }
+    }
+  }
+
+  if (!literal) {
+    reached.assign(reached.size(), true);
+  }
+  return reached;
+}
+
+/**
+ * @brief Run the front end, source and headers to bitcode
+ *
+ * Device libraries are linked in here so the bitcode is self contained.
+ *
+ * @param prog program
+ * @param isa_name target isa
+ * @param frontend_options front end options
+ * @param pch precompiled internal header, nullptr to parse it from text
+ * @param out bitcode_ and log_ are filled
+ * @param stats phases of the front end are added
+ * @return true success
+ * @return false failure, out.log_ has the reason
+ */
+bool compile_to_bitcode(const hiprtc_program *prog, const std::string &isa_name,
+                        const std::vector<std::string> &frontend_options,
+                        const std::vector<char> *pch, cache_entry &out,
+                        compile_stats &stats) {
+  out.log_.clear();
+  out.bitcode_.reset();
+  auto dataset_start = stats_clock::now();
 
   // Create comgr dataset, a superset of all compilation inputs
   amd_comgr_data_set_t data_set;
@@ -111,74 +354,180 @@ bool compile_program(hiprtc_program *prog,
     return false;
   }
 
-  // Create data for source
-  amd_comgr_data_t data;
-  if (!create_data(data, AMD_COMGR_DATA_KIND_SOURCE, prog->source_.data(),
-                   prog->source_.size(), prog->name_.c_str())) {
-    (void)amd_comgr_destroy_data_set(data_set);
+  // Add source, only joined with name expressions when there are any
+  std::string joined_source;
+  auto source = prog->source_.view();
+  if (!prog->name_expressions_.empty()) {
+    auto code = get_name_expression_code(prog->name_expressions_);
+    joined_source.reserve(source.size() + code.size());
+    joined_source.append(source).append(code);
+    source = joined_source;
+  }
+  if (!add_data(data_set, AMD_COMGR_DATA_KIND_SOURCE, source.data(),
+                source.size(), prog->name_.c_str())) {
+    header_registry::destroy_data_set(data_set);
     return false;
   }
 
-  // Add data to dataset
-  if (auto comgr_res = amd_comgr_data_set_add(data_set, data);
-      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
-    (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_release_data(data);
-    return false;
+  // Add internal header in the modules force included, its data is shared by
+  // every compilation
+  auto internal_name = find_internal_header(frontend_options);
+  if (!internal_name.empty()) {
+    auto internal_header = header_registry::internal_header(internal_name);
+    if (internal_header == nullptr ||
+        !header_registry::add_to(data_set, *internal_header)) {
+      header_registry::destroy_data_set(data_set);
+      return false;
+    }
   }
 
-  // release data here
-  (void)amd_comgr_release_data(data);
+  // Add precompiled internal header, comgr passes it with -include-pch
+  if (pch != nullptr) {
+    auto pch_name = std::string(internal_name) + ".pch";
+    if (!add_data(data_set, AMD_COMGR_DATA_KIND_PRECOMPILED_HEADER,
+                  pch->data(), pch->size(), pch_name.c_str())) {
+      header_registry::destroy_data_set(data_set);
+      return false;
+    }
+  }
 
-  // Add internal header
-  amd_comgr_data_t include_data;
-  if (!create_data(include_data, AMD_COMGR_DATA_KIND_INCLUDE,
-                   hiprtc_internal_header, sizeof(hiprtc_internal_header) - 1,
-                   "hiprtc_internal_header.h")) {
-    (void)amd_comgr_destroy_data_set(data_set);
+  // Add external headers provided by user, those the source never reaches
+  // are left out
+  auto reached = find_reachable_headers(prog, source, frontend_options);
+  auto plain = prog->headers_.size();
+  for (size_t i = 0; i < plain; i++) {
+    auto &header = prog->headers_[i];
+    auto text = header.second.view();
+    if (reached[i] &&
+        !add_data(data_set, AMD_COMGR_DATA_KIND_INCLUDE, text.data(),
+                  text.size(), header.first.c_str())) {
+      header_registry::destroy_data_set(data_set);
+      return false;
+    }
+  }
+  for (size_t i = plain; i < reached.size(); i++) {
+    if (reached[i] && !header_registry::add_to(
+                          data_set, *prog->registered_headers_[i - plain])) {
+      header_registry::destroy_data_set(data_set);
+      return false;
+    }
+  }
+  stats.dataset_ms_ += elapsed_ms(dataset_start);
+
+  // Get action, pch replaces the force include of internal header
+  auto action_options = (pch != nullptr)
+                            ? pch::strip_internal_header(frontend_options)
+                            : frontend_options;
+  auto trace_path = redirect_time_trace(action_options);
+  amd_comgr_action_info_t action;
+  if (!get_action(action, isa_name, action_options)) {
+    header_registry::destroy_data_set(data_set);
     return false;
   }
 
-  // Add include header to dataset
-  if (auto comgr_res = amd_comgr_data_set_add(data_set, include_data);
+  amd_comgr_data_set_t bitcode;
+  if (auto comgr_res = amd_comgr_create_data_set(&bitcode);
       comgr_res != AMD_COMGR_STATUS_SUCCESS) {
-    (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_release_data(include_data);
+    header_registry::destroy_data_set(data_set);
     return false;
   }
 
-  // Release include header
-  (void)amd_comgr_release_data(include_data);
+  // Compile to bitcode
+  auto frontend_start = stats_clock::now();
+  auto comgr_res = amd_comgr_do_action(
+      AMD_COMGR_ACTION_COMPILE_SOURCE_WITH_DEVICE_LIBS_TO_BC, action, data_set,
+      bitcode);
+  stats.frontend_ms_ += elapsed_ms(frontend_start);
+  if (comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    out.log_ += "Error in compilation to bitcode:";
+    out.log_ += get_build_log(bitcode);
+    append_time_trace(trace_path, "front end", out.log_);
+    header_registry::destroy_data_set(data_set);
+    (void)amd_comgr_destroy_data_set(bitcode);
+    return false;
+  }
 
-  // Add external headers provided by user
-  for (size_t i = 0; i < prog->headers_.size(); i++) {
-    amd_comgr_data_t user_header;
-    if (!create_data(user_header, AMD_COMGR_DATA_KIND_INCLUDE,
-                     prog->headers_[i].second.c_str(),
-                     prog->headers_[i].second.size(),
-                     prog->headers_[i].first.c_str())) {
-      (void)amd_comgr_destroy_data_set(data_set);
-      return false;
-    }
+  out.log_ += get_build_log(bitcode);
+  append_time_trace(trace_path, "front end", out.log_);
+  header_registry::destroy_data_set(data_set);
+
+  // Extract bitcode
+  scoped_timer extract_timer(stats.extract_ms_);
+  std::vector<char> bitcode_data;
+  bool success = get_data(bitcode, AMD_COMGR_DATA_KIND_BC, bitcode_data);
+  (void)amd_comgr_destroy_data_set(bitcode);
+  if (success) {
+    out.bitcode_ =
+        std::make_shared<const std::vector<char>>(std::move(bitcode_data));
+  }
+  return success;
+}
 
-    // Add include header to dataset
-    if (auto comgr_res = amd_comgr_data_set_add(data_set, user_header);
-        comgr_res != AMD_COMGR_STATUS_SUCCESS) {
-      (void)amd_comgr_destroy_data_set(data_set);
-      (void)amd_comgr_release_data(user_header);
-      return false;
-    }
+/**
+ * @brief Lower name expressions of a freshly built code object
+ *
+ * comgr is the slow path for code objects the ELF tables do not resolve.
+ *
+ * @param prog program, for the name expressions
+ * @param out reads object_ and bitcode_, fills lowered_names_
+ * @param rdc object_ is a relocatable
+ * @return true success
+ * @return false failure
+ */
+bool lower_names(const hiprtc_program *prog, cache_entry &out, bool rdc) {
+  if (out.lowered_names_.empty() ||
+      lower_names_from_elf(out.object_, prog->name_expressions_,
+                           out.lowered_names_)) {
+    return true;
+  }
+
+  // Symbols of a relocatable are only final after link, map on the bitcode
+  return rdc ? get_mangled_names(*out.bitcode_, AMD_COMGR_DATA_KIND_BC,
+                                 out.lowered_names_)
+             : get_mangled_names(out.object_, AMD_COMGR_DATA_KIND_EXECUTABLE,
+                                 out.lowered_names_);
+}
 
-    // Release include header
-    (void)amd_comgr_release_data(user_header);
+/**
+ * @brief Generate and link the code object from bitcode
+ *
+ * @param prog program, for the name expressions to lower
+ * @param isa_name target isa
+ * @param codegen_options code generation options
+ * @param options final option list, used for link
+ * @param out reads bitcode_, fills object_, lowered_names_ and appends to log_.
+ * object_ is a relocatable with -fgpu-rdc, else an executable.
+ * @param stats phases of code generation and link are added
+ * @return true success
+ * @return false failure, out.log_ has the reason
+ */
+bool compile_bitcode(const hiprtc_program *prog, const std::string &isa_name,
+                     const std::vector<std::string> &codegen_options,
+                     const std::vector<std::string> &options,
+                     cache_entry &out, compile_stats &stats) {
+  out.object_.clear();
+  out.lowered_names_ = prog->lowered_names_;
+  auto dataset_start = stats_clock::now();
+
+  amd_comgr_data_set_t data_set;
+  if (auto comgr_res = amd_comgr_create_data_set(&data_set);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    return false;
   }
 
-  // Get isa name
-  auto isa_name = rsmi::get_isa_name();
+  auto bitcode_name = prog->name_ + ".bc";
+  auto bitcode = out.bitcode();
+  if (!add_data(data_set, AMD_COMGR_DATA_KIND_BC, bitcode.data(),
+                bitcode.size(), bitcode_name.c_str())) {
+    (void)amd_comgr_destroy_data_set(data_set);
+    return false;
+  }
+  stats.dataset_ms_ += elapsed_ms(dataset_start);
 
-  // Create action
+  auto action_options = codegen_options;
+  auto trace_path = redirect_time_trace(action_options);
   amd_comgr_action_info_t action;
-  if (!create_action(action, isa_name, options)) {
+  if (!get_action(action, isa_name, action_options)) {
     (void)amd_comgr_destroy_data_set(data_set);
     return false;
   }
@@ -188,113 +537,434 @@ bool compile_program(hiprtc_program *prog,
   if (auto comgr_res = amd_comgr_create_data_set(&reloc);
       comgr_res != AMD_COMGR_STATUS_SUCCESS) {
     (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_destroy_action_info(action);
     return false;
   }
 
-  // Compile to relocatable
-  if (auto comgr_res =
-          amd_comgr_do_action(AMD_COMGR_ACTION_COMPILE_SOURCE_TO_RELOCATABLE,
-                              action, data_set, reloc);
-      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
-    prog->log_ += "Error in compilation to relocatable:";
-    prog->log_ += get_build_log(reloc);
+  // Optimize and generate code
+  auto codegen_start = stats_clock::now();
+  auto comgr_res = amd_comgr_do_action(
+      AMD_COMGR_ACTION_CODEGEN_BC_TO_RELOCATABLE, action, data_set, reloc);
+  stats.codegen_ms_ += elapsed_ms(codegen_start);
+  if (comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    out.log_ += "Error in compilation to relocatable:";
+    out.log_ += get_build_log(reloc);
+    append_time_trace(trace_path, "code generation", out.log_);
     (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_destroy_action_info(action);
     (void)amd_comgr_destroy_data_set(reloc);
     return false;
   }
 
-  prog->log_ += get_build_log(reloc);
+  out.log_ += get_build_log(reloc);
+  append_time_trace(trace_path, "code generation", out.log_);
+  (void)amd_comgr_destroy_data_set(data_set);
+
+  // Relocatable is the output, to be linked by hiprtcLinkComplete
+  if (is_relocatable_device_code(options)) {
+    bool extracted;
+    {
+      scoped_timer extract_timer(stats.extract_ms_);
+      extracted = get_data(reloc, AMD_COMGR_DATA_KIND_RELOCATABLE, out.object_);
+      (void)amd_comgr_destroy_data_set(reloc);
+    }
+    if (!extracted) {
+      return false;
+    }
 
-  // Destroy the action
-  (void)amd_comgr_destroy_action_info(action);
+    scoped_timer lowering_timer(stats.lowering_ms_);
+    return lower_names(prog, out, true);
+  }
 
   // Create executable
   amd_comgr_data_set_t exe;
   if (auto comgr_res = amd_comgr_create_data_set(&exe);
       comgr_res != AMD_COMGR_STATUS_SUCCESS) {
-    (void)amd_comgr_destroy_data_set(data_set);
     (void)amd_comgr_destroy_data_set(reloc);
     return false;
   }
 
-  // Create action again for reloc to exe
-  if (!create_action(action, isa_name, options)) {
-    (void)amd_comgr_destroy_data_set(data_set);
+  // Get action for reloc to exe, full options
+  if (!get_action(action, isa_name, options)) {
     (void)amd_comgr_destroy_data_set(reloc);
     (void)amd_comgr_destroy_data_set(exe);
     return false;
   }
 
-  // Compile to link
-  if (auto comgr_res = amd_comgr_do_action(
-          AMD_COMGR_ACTION_LINK_RELOCATABLE_TO_EXECUTABLE, action, reloc, exe);
-      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
-    prog->log_ += "Error in compilation to exe:";
-    prog->log_ += get_build_log(exe);
-    (void)amd_comgr_destroy_data_set(data_set);
+  // Link
+  auto link_start = stats_clock::now();
+  comgr_res = amd_comgr_do_action(
+      AMD_COMGR_ACTION_LINK_RELOCATABLE_TO_EXECUTABLE, action, reloc, exe);
+  stats.link_ms_ += elapsed_ms(link_start);
+  if (comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    out.log_ += "Error in compilation to exe:";
+    out.log_ += get_build_log(exe);
     (void)amd_comgr_destroy_data_set(reloc);
     (void)amd_comgr_destroy_data_set(exe);
-    (void)amd_comgr_destroy_action_info(action);
     return false;
   }
 
-  // Destroy the action
-  (void)amd_comgr_destroy_action_info(action);
+  (void)amd_comgr_destroy_data_set(reloc);
 
-  prog->log_ += get_build_log(exe);
+  out.log_ += get_build_log(exe);
 
   // Extract Binary
-  amd_comgr_data_t binary;
-  if (auto comgr_res = amd_comgr_action_data_get_data(
-          exe, AMD_COMGR_DATA_KIND_EXECUTABLE, 0, &binary);
-      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
-    (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_destroy_data_set(reloc);
+  bool extracted;
+  {
+    scoped_timer extract_timer(stats.extract_ms_);
+    extracted = get_data(exe, AMD_COMGR_DATA_KIND_EXECUTABLE, out.object_);
     (void)amd_comgr_destroy_data_set(exe);
+  }
+  if (!extracted) {
     return false;
   }
 
-  // Get binary size
-  size_t binary_size = 0;
-  if (auto comgr_res = amd_comgr_get_data(binary, &binary_size, NULL);
-      comgr_res != AMD_COMGR_STATUS_SUCCESS || binary_size == 0) {
-    (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_destroy_data_set(reloc);
-    (void)amd_comgr_destroy_data_set(exe);
-    (void)amd_comgr_release_data(binary);
+  // Fill up mangled names
+  scoped_timer lowering_timer(stats.lowering_ms_);
+  return lower_names(prog, out, false);
+}
+
+/**
+ * @brief Run the front end, on the precompiled header if it is usable
+ *
+ */
+bool run_frontend(const hiprtc_program *prog, const std::string &isa_name,
+                  const std::vector<std::string> &frontend_options,
+                  cache_entry &out, compile_stats &stats) {
+  std::shared_ptr<const std::vector<char>> pch;
+  bool reused = false;
+  {
+    scoped_timer pch_timer(stats.pch_ms_);
+    pch = pch::get(isa_name, frontend_options, reused);
+  }
+  if (compile_to_bitcode(prog, isa_name, frontend_options, pch.get(), out,
+                         stats)) {
+    stats.pch_hits_ += reused ? 1 : 0;
+    return true;
+  }
+  if (pch == nullptr) {
+    return false;
+  }
+
+  // Can not tell a bad pch from a bad program, retry on the raw header
+  if (!compile_to_bitcode(prog, isa_name, frontend_options, nullptr, out,
+                          stats)) {
     return false;
   }
+  pch::mark_unusable(isa_name, frontend_options);
+  return true;
+}
 
-  // Allocate binary size to copy
-  prog->object_.resize(binary_size);
+/**
+ * @brief Check if a front end error can come from a module left out of the
+ * internal header
+ *
+ */
+bool may_lack_module(const std::string &log) {
+  static const char *const errors[] = {
+      "undeclared identifier", "unknown type name", "no member named",
+      "no template named", "no matching function"};
+  return std::any_of(std::begin(errors), std::end(errors),
+                     [&](const char *error) {
+                       return log.find(error) != std::string::npos;
+                     });
+}
 
-  // Copy binary
-  if (auto comgr_res =
-          amd_comgr_get_data(binary, &binary_size, prog->object_.data());
-      comgr_res != AMD_COMGR_STATUS_SUCCESS || binary_size == 0) {
-    (void)amd_comgr_destroy_data_set(data_set);
-    (void)amd_comgr_destroy_data_set(reloc);
-    (void)amd_comgr_destroy_data_set(exe);
-    (void)amd_comgr_release_data(binary);
+bool run_compile_stage(compile_stage stage, const hiprtc_program *prog,
+                       const std::string &isa_name,
+                       const std::vector<std::string> &options,
+                       cache_entry &out, compile_stats &stats) {
+  std::vector<std::string> frontend_options, codegen_options;
+  split_options(options, frontend_options, codegen_options);
+
+  if (stage == compile_stage::codegen) {
+    return compile_bitcode(prog, isa_name, codegen_options, options, out,
+                           stats);
+  }
+
+  if (run_frontend(prog, isa_name, frontend_options, out, stats)) {
+    return true;
+  }
+
+  // Modules are picked by the names a program uses, which can miss one
+  if (!may_lack_module(out.log_) ||
+      !use_all_internal_modules(frontend_options)) {
     return false;
   }
+  return run_frontend(prog, isa_name, frontend_options, out, stats);
+}
 
-  // Fill up mangled names
-  if (prog->lowered_names_.size() > 0) {
-    if (!get_mangled_names(prog->object_, prog->lowered_names_)) {
-      (void)amd_comgr_destroy_data_set(data_set);
-      (void)amd_comgr_destroy_data_set(reloc);
-      (void)amd_comgr_destroy_data_set(exe);
-      (void)amd_comgr_release_data(binary);
+/**
+ * @brief Run a stage in a worker process if the pool is on, else in process
+ *
+ */
+bool run_stage(compile_stage stage, const hiprtc_program *prog,
+               const std::string &isa_name,
+               const std::vector<std::string> &options, cache_entry &out,
+               compile_stats &stats) {
+  return worker_pool::enabled()
+             ? worker_pool::run(stage, prog, isa_name, options, out, stats)
+             : run_compile_stage(stage, prog, isa_name, options, out, stats);
+}
+
+/**
+ * @brief Look up a cache entry, in process first then on disk
+ *
+ * @param key key of the entry
+ * @param bitcode_key for a code object, key of the bitcode entry it is built
+ * from. Code objects are stored on disk without bitcode, they get it back from
+ * that entry while it is cached, else they come without.
+ * @return std::shared_ptr<const cache_entry> entry shared with the cache,
+ * nullptr on miss
+ */
+std::shared_ptr<const cache_entry>
+cache_lookup(const std::string &key,
+             const std::string &bitcode_key = std::string()) {
+  if (memory_cache::enabled()) {
+    if (auto entry = memory_cache::lookup(key); entry != nullptr) {
+      return entry;
+    }
+  }
+
+  if (disk_cache::enabled()) {
+    auto entry = std::make_shared<cache_entry>();
+    if (disk_cache::load(key, *entry)) {
+      if (entry->bitcode_ == nullptr && !bitcode_key.empty()) {
+        if (auto bitcode_entry = cache_lookup(bitcode_key);
+            bitcode_entry != nullptr) {
+          entry->bitcode_ = bitcode_entry->bitcode_;
+        }
+      }
+      if (memory_cache::enabled()) {
+        memory_cache::insert(key, entry);
+      }
+      return entry;
+    }
+  }
+
+  return nullptr;
+}
+
+/**
+ * @brief Look up an earlier result of the program
+ *
+ * @param prog program
+ * @param key key of the entry
+ * @return std::shared_ptr<const cache_entry> entry, nullptr if the program
+ * did not compile it
+ */
+std::shared_ptr<const cache_entry> variant_lookup(const hiprtc_program *prog,
+                                                  const std::string &key) {
+  std::lock_guard<std::mutex> lock(prog->variants_mutex_);
+  auto it = prog->variants_.find(key);
+  return (it != prog->variants_.end()) ? it->second : nullptr;
+}
+
+void variant_store(const hiprtc_program *prog, const std::string &key,
+                   std::shared_ptr<const cache_entry> entry) {
+  std::lock_guard<std::mutex> lock(prog->variants_mutex_);
+  prog->variants_[key] = std::move(entry);
+}
+
+void cache_store(const std::string &key,
+                 std::shared_ptr<const cache_entry> entry) {
+  if (disk_cache::enabled()) {
+    disk_cache::store(key, *entry);
+  }
+  if (memory_cache::enabled()) {
+    memory_cache::insert(key, std::move(entry));
+  }
+}
+
+std::string get_compile_key(const hiprtc_program *prog,
+                            const std::string &isa_name,
+                            const std::vector<std::string> &options) {
+  std::vector<std::string> frontend_options, codegen_options;
+  split_options(options, frontend_options, codegen_options);
+  return get_cache_key(get_bitcode_key(prog, isa_name, frontend_options),
+                       options);
+}
+
+bool compile_for_isa(const hiprtc_program *prog, const std::string &isa_name,
+                     const std::vector<std::string> &options,
+                     std::shared_ptr<const cache_entry> &out, std::string &log,
+                     compile_stats &stats) {
+  // Earlier results of the program serve recompiles even without caches
+  bool use_variants = !wants_time_report(options);
+  bool use_cache = (memory_cache::enabled() || disk_cache::enabled()) &&
+                   use_variants;
+  std::string bitcode_key, key;
+  if (use_variants) {
+    std::vector<std::string> frontend_options, codegen_options;
+    split_options(options, frontend_options, codegen_options);
+    bitcode_key = get_bitcode_key(prog, isa_name, frontend_options);
+    key = get_cache_key(bitcode_key, options);
+    std::shared_ptr<const cache_entry> entry;
+    {
+      scoped_timer cache_timer(stats.cache_ms_);
+      entry = variant_lookup(prog, key);
+      if (entry == nullptr && use_cache) {
+        entry = cache_lookup(key, bitcode_key);
+      }
+    }
+    if (entry != nullptr && usable_cache_entry(prog, *entry)) {
+      variant_store(prog, key, entry);
+      stats.cache_hits_++;
+      stats.bitcode_bytes_ += entry->bitcode().size();
+      out = std::move(entry);
+      return true;
+    }
+  }
+
+  // A node local daemon compiles once for all processes, compile here if
+  // none is listening
+  if (int socket = compile_daemon::connect(); socket >= 0) {
+    auto entry = std::make_shared<cache_entry>();
+    if (!compile_daemon::compile(socket, prog, isa_name, options, *entry,
+                                 stats)) {
+      log = std::move(entry->log_);
+      return false;
+    }
+    if (use_variants) {
+      // Its bitcode gets an entry too, the code object only refers to it.
+      // The log of the front end alone is not known.
+      auto bitcode_entry = std::make_shared<cache_entry>();
+      bitcode_entry->bitcode_ = entry->bitcode_;
+      scoped_timer cache_timer(stats.cache_ms_);
+      variant_store(prog, bitcode_key, bitcode_entry);
+      variant_store(prog, key, entry);
+      if (use_cache) {
+        cache_store(bitcode_key, std::move(bitcode_entry));
+        cache_store(key, entry);
+      }
+    }
+    out = std::move(entry);
+    return true;
+  }
+
+  auto entry = std::make_shared<cache_entry>();
+  std::shared_ptr<const cache_entry> bitcode_entry;
+  if (use_variants) {
+    scoped_timer cache_timer(stats.cache_ms_);
+    bitcode_entry = variant_lookup(prog, bitcode_key);
+    if (bitcode_entry == nullptr && use_cache) {
+      bitcode_entry = cache_lookup(bitcode_key);
+    }
+  }
+  if (bitcode_entry != nullptr && bitcode_entry->bitcode_ != nullptr) {
+    stats.bitcode_cache_hits_++;
+    entry->bitcode_ = bitcode_entry->bitcode_; // Shared, not copied
+    entry->log_ = bitcode_entry->log_;
+  } else {
+    if (!run_stage(compile_stage::frontend, prog, isa_name, options, *entry,
+                   stats)) {
+      log = std::move(entry->log_);
       return false;
     }
+
+    if (use_variants) {
+      auto new_bitcode_entry = std::make_shared<cache_entry>();
+      new_bitcode_entry->bitcode_ = entry->bitcode_;
+      new_bitcode_entry->log_ = entry->log_;
+      scoped_timer cache_timer(stats.cache_ms_);
+      variant_store(prog, bitcode_key, new_bitcode_entry);
+      if (use_cache) {
+        cache_store(bitcode_key, std::move(new_bitcode_entry));
+      }
+    }
   }
+  stats.bitcode_bytes_ += entry->bitcode().size();
+
+  if (!run_stage(compile_stage::codegen, prog, isa_name, options, *entry,
+                 stats)) {
+    log = std::move(entry->log_);
+    return false;
+  }
+
+  if (use_cache) {
+    scoped_timer cache_timer(stats.cache_ms_);
+    cache_store(key, entry);
+  }
+  if (use_variants) {
+    variant_store(prog, key, entry);
+  }
+
+  out = std::move(entry);
+  return true;
+}
+
+bool compile_program(hiprtc_program *prog,
+                     const std::vector<std::string> &target_ids,
+                     const std::vector<std::string> &options) {
+  // clear the existing output
+  prog->log_.clear();
+  prog->code_ = nullptr;
+  prog->code_size_ = 0;
+  prog->outputs_.clear();
+  prog->bundle_.clear();
+  prog->kernels_.clear();
+  prog->targets_ = target_ids;
+
+  prog->stats_.source_bytes_ = prog->source_.view().size();
+  if (!prog->name_expressions_.empty()) {
+    prog->stats_.source_bytes_ +=
+        get_name_expression_code(prog->name_expressions_).size();
+  }
+  for (auto &header : prog->headers_) {
+    prog->stats_.header_bytes_ += header.second.view().size();
+  }
+  for (auto &header : prog->registered_headers_) {
+    prog->stats_.header_bytes_ += header->text_.size();
+  }
+
+  // Targets are independent, compile them in parallel
+  std::vector<std::shared_ptr<const cache_entry>> outputs(target_ids.size());
+  std::vector<std::string> logs(target_ids.size());
+  std::vector<compile_stats> stats(target_ids.size());
+  auto compile_target = [&](size_t i) {
+    (void)compile_for_isa(prog, target::get_isa_name(target_ids[i]), options,
+                          outputs[i], logs[i], stats[i]);
+  };
+  if (target_ids.size() == 1) {
+    compile_target(0);
+  } else {
+    thread_pool::get().parallel_for(target_ids.size(), compile_target);
+  }
+
+  bool success = !target_ids.empty();
+  for (size_t i = 0; i < target_ids.size(); i++) {
+    auto &log = (outputs[i] != nullptr) ? outputs[i]->log_ : logs[i];
+    if (target_ids.size() > 1 && !log.empty()) {
+      prog->log_ += target_ids[i] + ":\n";
+    }
+    prog->log_ += log;
+    prog->stats_ += stats[i];
+    success = success && (outputs[i] != nullptr);
+  }
+
+  if (!success) {
+    return false;
+  }
+
+  // Mangling does not depend on the target
+  for (auto &name_pair : prog->lowered_names_) {
+    name_pair.second = outputs[0]->lowered_names_.at(name_pair.first);
+  }
+
+  prog->outputs_ = std::move(outputs);
+  if (target_ids.size() == 1) {
+    prog->code_ = prog->outputs_[0]->object_.data();
+    prog->code_size_ = prog->outputs_[0]->object_.size();
+  } else {
+    scoped_timer bundle_timer(prog->stats_.bundle_ms_);
+    std::vector<std::pair<std::string, const std::vector<char> *>> objects;
+    for (size_t i = 0; i < target_ids.size(); i++) {
+      objects.emplace_back(target::get_isa_name(target_ids[i]),
+                           &prog->outputs_[i]->object_);
+    }
+    prog->bundle_ = create_offload_bundle(objects);
+    prog->code_ = prog->bundle_.data();
+    prog->code_size_ = prog->bundle_.size();
+  }
+  prog->stats_.object_bytes_ = prog->code_size_;
 
-  (void)amd_comgr_release_data(binary);
-  (void)amd_comgr_destroy_data_set(data_set);
-  (void)amd_comgr_destroy_data_set(reloc);
-  (void)amd_comgr_destroy_data_set(exe);
   return true;
 }
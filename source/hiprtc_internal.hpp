@@ -1,6 +1,21 @@
 #pragma once
 
+#include <hip/hiprtc.h>
+
+#include "cache_entry.hpp"
+#include "code_object.hpp"
+#include "compile_stats.hpp"
+#include "header_registry.hpp"
+#include "source_buffer.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -9,19 +24,161 @@ typedef enum hiprtc_program_state_e {
   Compiled = 1,
   Destroyed = 2,
   Error = 3,
+  Queued = 4,    // Asynchronous compilation waiting for a worker
+  Compiling = 5, // Asynchronous compilation running
 } hiprtc_program_state;
 
+// Kernels of one target of a program as hiprtcGetKernelInfo hands them out
+struct program_kernels {
+  std::vector<kernel_info> kernels_;
+  std::vector<std::vector<hiprtcKernelArg>> args_; // Per kernel, point into
+                                                   // kernels_
+};
+
+// Ticket of an asynchronous compilation, outlives the program if it is
+// destroyed while queued
+struct hiprtc_async_job {
+  std::mutex mutex_;
+  std::condition_variable cv_; // Signals callback_done_
+  bool started_ = false;
+  bool cancelled_ = false;
+  bool callback_done_ = false;       // Waiters may let go of the program
+  std::thread::id callback_thread_;  // Set while the callback runs
+  hiprtcCompileCallback callback_ = nullptr;
+  void *user_data_ = nullptr;
+};
+
 struct hiprtc_program {
-  hiprtc_program_state state_; // Current state of hiprtc program
+  std::atomic<hiprtc_program_state> state_; // Current state of hiprtc program
+  std::atomic<hiprtcResult> result_{
+      HIPRTC_ERROR_INVALID_INPUT};          // Result of last compilation
+  std::mutex mutex_;                        // Guards state changes of async
+  std::condition_variable cv_;              // compilations and job_
+  std::shared_ptr<hiprtc_async_job> job_;   // Last async compilation
   std::string name_;           // Name
-  std::string source_;         // Input source
-  std::vector<char> object_;   // Output code object
+  source_buffer source_;       // Input source
+  std::vector<std::string> name_expressions_; // In registration order,
+                                              // instantiated at compile time
   std::string log_;            // Log
   std::unordered_map<std::string,
                      std::string> lowered_names_; // Lowered names
   std::vector<std::pair<std::string,
-                        std::string>> headers_; // <name, source>
+                        source_buffer>> headers_; // <name, source>
+  std::vector<std::shared_ptr<const registered_header>>
+      registered_headers_;                      // From hiprtcAddProgramHeaders
+  std::vector<std::string> targets_;            // Target ids compiled for
+  std::vector<std::shared_ptr<const cache_entry>>
+      outputs_;                 // Per target results, shared with the caches
+  std::vector<char> bundle_;    // Offload bundle, several targets only
+  const char *code_ = nullptr;  // Code object handed out, points into
+  size_t code_size_ = 0;        // outputs_, bundle_ or allocated memory
+  hiprtcCodeAllocator allocator_ = nullptr; // Caller allocator of code_
+  void *allocator_data_ = nullptr;
+  compile_stats stats_;         // Phases of the last compilation
+  std::unordered_map<std::string, program_kernels>
+      kernels_; // By target id, read from the code object on first query
+  mutable std::mutex variants_mutex_; // Guards variants_, targets of a
+                                      // compilation run in parallel
+  mutable std::unordered_map<std::string,
+                             std::shared_ptr<const cache_entry>>
+      variants_; // Every earlier result by compile and bitcode key, kept
+                 // for recompiles whatever the caches evict
+  std::unordered_map<std::string, std::vector<std::string>>
+      specialization_parameters_; // Kernel template to its parameter names
+  std::unordered_map<std::string, std::unique_ptr<hiprtc_program>>
+      specializations_; // Compiled instantiations by kernel, values and
+                        // options, each a program of its own
 };
 
+/**
+ * @brief Compile the program for one isa, going through the caches
+ *
+ * Front end and code generation are cached separately, so a compile that only
+ * changes code generation options starts from the cached bitcode. Results are
+ * shared with the caches, neither a hit nor a store copies the code object.
+ * The program keeps its own results in variants_, looked up before the
+ * caches.
+ *
+ * @param prog program to be compiled, only variants_ is added to
+ * @param isa_name target isa
+ * @param options compile options
+ * @param out code object, bitcode, lowered names and log
+ * @param log log of a failed compilation
+ * @param stats phases of this isa are added
+ * @return true success
+ * @return false failure, log has the reason
+ */
+bool compile_for_isa(const hiprtc_program *prog, const std::string &isa_name,
+                     const std::vector<std::string> &options,
+                     std::shared_ptr<const cache_entry> &out, std::string &log,
+                     compile_stats &stats);
+
+/**
+ * @brief Key identifying the result of compile_for_isa
+ *
+ * @param prog program
+ * @param isa_name target isa
+ * @param options compile options
+ * @return std::string key, same as the one of the code object cache
+ */
+std::string get_compile_key(const hiprtc_program *prog,
+                            const std::string &isa_name,
+                            const std::vector<std::string> &options);
+
+/**
+ * @brief Find the headers a compilation can reach
+ *
+ * Follows the includes of the source and of -include options through the
+ * headers, matched by file name. Once an include is computed by a macro any
+ * header may be reached and all of them are kept.
+ *
+ * @param prog program, headers_ and registered_headers_ are searched
+ * @param source source with name expression code
+ * @param options front end options
+ * @return std::vector<bool> per header, headers_ first
+ */
+std::vector<bool>
+find_reachable_headers(const hiprtc_program *prog, std::string_view source,
+                       const std::vector<std::string> &options);
+
+/**
+ * @brief Compile the program for one or more targets
+ *
+ * With several targets the code objects are compiled in parallel and code_
+ * is an offload bundle of them. Phases are added to stats_.
+ *
+ * @param prog program
+ * @param target_ids targets to compile for
+ * @param options compile options
+ * @return true success
+ * @return false failure, log_ has the reason
+ */
 bool compile_program(hiprtc_program *prog,
+                     const std::vector<std::string> &target_ids,
                      const std::vector<std::string> &options);
+
+// Stages of a compilation, each can run in a worker process
+enum class compile_stage : uint64_t {
+  frontend = 0, // Source to bitcode
+  codegen = 1,  // Bitcode to code object and lowered names
+};
+
+/**
+ * @brief Run one stage of the compilation of a program in this process
+ *
+ * The front end fills bitcode_ and log_, code generation reads bitcode_,
+ * fills object_ and lowered_names_ and appends to log_.
+ *
+ * @param stage stage to run
+ * @param prog program, not modified
+ * @param isa_name target isa
+ * @param options compile options, split per stage here
+ * @param out result of the stage
+ * @param stats phases of the stage are added
+ * @return true success
+ * @return false failure, out.log_ has the reason
+ */
+bool run_compile_stage(compile_stage stage, const hiprtc_program *prog,
+                       const std::string &isa_name,
+                       const std::vector<std::string> &options,
+                       cache_entry &out, compile_stats &stats);
@@ -0,0 +1,11 @@
+#include "worker_pool.hpp"
+
+#include <cstdlib>
+
+// Compile worker started by the host process with its end of a socket
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    return 1;
+  }
+  return worker_pool::serve(std::atoi(argv[1]));
+}
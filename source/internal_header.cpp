@@ -0,0 +1,311 @@
+#include "internal_header.hpp"
+#include "compression.hpp"
+#include "fingerprint.hpp"
+#include "internal_modules.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+struct compressed_text {
+  const char *data_;
+  size_t size_;
+  size_t text_size_;
+};
+
+// Texts in the order of internal_modules, written by gen_hiprtc_header
+const compressed_text module_texts[] = {
+#include "hiprtc_internal_header_generated.hpp"
+};
+static_assert(sizeof(module_texts) / sizeof(module_texts[0]) ==
+                  internal_module_count,
+              "Embedded header is stale, regenerate it");
+
+// Decompressed on the first compile that needs the header, then shared
+const std::vector<std::string> &get_module_texts() {
+  static const std::vector<std::string> texts = [] {
+    std::vector<std::string> texts(internal_module_count);
+    for (size_t i = 0; i < internal_module_count; i++) {
+      auto &module = module_texts[i];
+      if (!compression::decompress({module.data_, module.size_},
+                                   module.text_size_, texts[i])) {
+        texts[i].clear(); // Compiles fail on the missing declarations
+      }
+    }
+    return texts;
+  }();
+  return texts;
+}
+
+using module_set = internal_module_set;
+constexpr module_set core_module = 1;
+constexpr module_set all_modules = (module_set(1) << internal_module_count) - 1;
+
+constexpr std::string_view name_prefix = "hiprtc_internal_header.";
+constexpr std::string_view name_suffix = ".h";
+constexpr std::string_view modules_option = "--hiprtc-modules=";
+
+size_t find_module(std::string_view name) {
+  for (size_t i = 0; i < internal_module_count; i++) {
+    if (name == internal_modules[i].name_) {
+      return i;
+    }
+  }
+  return internal_module_count;
+}
+
+// hiprtc_internal_header.h for every module, else one like
+// hiprtc_internal_header.math.atomics.h, or .core.h for core alone
+std::string get_name(module_set modules) {
+  if (modules == all_modules) {
+    return internal_header_name;
+  }
+  std::string list;
+  for (size_t i = 1; i < internal_module_count; i++) {
+    if (modules & (module_set(1) << i)) {
+      list += list.empty() ? "" : ".";
+      list += internal_modules[i].name_;
+    }
+  }
+  if (list.empty()) {
+    list = internal_modules[0].name_;
+  }
+  return std::string(name_prefix) + list + std::string(name_suffix);
+}
+
+// Inverse of get_name, false if it is not a name of the embedded header
+bool parse_name(std::string_view name, module_set &modules) {
+  if (name == internal_header_name) {
+    modules = all_modules;
+    return true;
+  }
+  if (name.size() <= name_prefix.size() + name_suffix.size() ||
+      name.substr(0, name_prefix.size()) != name_prefix ||
+      name.substr(name.size() - name_suffix.size()) != name_suffix) {
+    return false;
+  }
+  name = name.substr(name_prefix.size(),
+                     name.size() - name_prefix.size() - name_suffix.size());
+  modules = core_module;
+  while (!name.empty()) {
+    auto dot = name.find('.');
+    auto index = find_module(name.substr(0, dot));
+    if (index == internal_module_count) {
+      return false;
+    }
+    modules |= module_set(1) << index;
+    name = (dot == std::string_view::npos) ? std::string_view()
+                                           : name.substr(dot + 1);
+  }
+  return true;
+}
+
+bool is_identifier_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+// Triggers of every module, exact ones hashed and prefix ones hashed per
+// prefix length, so an identifier takes a few lookups instead of a scan
+using trigger_map = std::unordered_map<std::string_view, module_set>;
+struct trigger_table {
+  trigger_map exact_;
+  std::vector<std::pair<size_t, trigger_map>> prefixes_; // Shortest first
+  bool first_chars_[256]{}; // Characters a trigger starts with
+};
+
+const trigger_table &get_trigger_table() {
+  static const trigger_table table = [] {
+    trigger_table table;
+    std::map<size_t, trigger_map> prefixes; // By prefix length
+    for (size_t i = 1; i < internal_module_count; i++) {
+      for (auto trigger_text : internal_modules[i].triggers_) {
+        if (trigger_text == nullptr) {
+          break;
+        }
+        std::string_view trigger = trigger_text;
+        auto bit = module_set(1) << i;
+        table.first_chars_[static_cast<unsigned char>(trigger[0])] = true;
+        if (trigger.back() == '*') {
+          trigger.remove_suffix(1);
+          prefixes[trigger.size()][trigger] |= bit;
+        } else {
+          table.exact_[trigger] |= bit;
+        }
+      }
+    }
+    table.prefixes_.assign(prefixes.begin(), prefixes.end());
+    return table;
+  }();
+  return table;
+}
+
+// Modules whose triggers appear as identifiers in the text
+module_set detect_modules(std::string_view text) {
+  auto &table = get_trigger_table();
+  module_set modules = core_module;
+  for (size_t pos = 0; pos < text.size() && modules != all_modules;) {
+    if (!is_identifier_char(text[pos])) {
+      pos++;
+      continue;
+    }
+    size_t start = pos;
+    while (pos < text.size() && is_identifier_char(text[pos])) {
+      pos++;
+    }
+    if (!table.first_chars_[static_cast<unsigned char>(text[start])]) {
+      continue;
+    }
+    auto identifier = text.substr(start, pos - start);
+    if (auto it = table.exact_.find(identifier); it != table.exact_.end()) {
+      modules |= it->second;
+    }
+    for (auto &prefix : table.prefixes_) {
+      if (prefix.first > identifier.size()) {
+        break;
+      }
+      auto it = prefix.second.find(identifier.substr(0, prefix.first));
+      if (it != prefix.second.end()) {
+        modules |= it->second;
+      }
+    }
+  }
+  return modules;
+}
+
+// Force include of the embedded header, options.end() if there is none
+std::vector<std::string>::iterator
+find_force_include(std::vector<std::string> &options) {
+  for (auto it = options.begin(); it != options.end(); ++it) {
+    module_set modules;
+    if (*it == "-include" && it + 1 != options.end() &&
+        parse_name(*(it + 1), modules)) {
+      return it + 1;
+    }
+  }
+  return options.end();
+}
+} // namespace
+
+const std::string &get_internal_header_hash() {
+  static const std::string hash = [] {
+    fingerprint fp;
+    for (auto &module : module_texts) {
+      fp.add(module.data_, module.size_);
+    }
+    return fp.hex();
+  }();
+  return hash;
+}
+
+std::string_view get_internal_header(std::string_view name) {
+  module_set modules;
+  if (!parse_name(name, modules)) {
+    return std::string_view();
+  }
+
+  // Each combination is put together once, texts stay for the process
+  static std::mutex mutex;
+  static std::unordered_map<module_set, std::unique_ptr<std::string>> texts;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &text = texts[modules];
+  if (text == nullptr) {
+    auto &module_texts = get_module_texts();
+    text = std::make_unique<std::string>();
+    for (size_t i = 0; i < internal_module_count; i++) {
+      if (modules & (module_set(1) << i)) {
+        text->append(module_texts[i]);
+      }
+    }
+  }
+  return *text;
+}
+
+std::string_view find_internal_header(const std::vector<std::string> &options) {
+  for (size_t i = 0; i + 1 < options.size(); i++) {
+    module_set modules;
+    if (options[i] == "-include" && parse_name(options[i + 1], modules)) {
+      return options[i + 1];
+    }
+  }
+  return std::string_view();
+}
+
+internal_module_set detect_internal_modules(std::string_view text) {
+  return detect_modules(text);
+}
+
+internal_module_set detect_header_modules(std::string_view text) {
+  auto hash = fingerprint().add(text).hex();
+
+  // Dropped as a whole once full, headers are few in practice
+  static std::mutex mutex;
+  static std::unordered_map<std::string, module_set> detected;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto it = detected.find(hash); it != detected.end()) {
+      return it->second;
+    }
+  }
+  auto modules = detect_modules(text);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (detected.size() >= 4096) {
+    detected.clear();
+  }
+  detected.emplace(std::move(hash), modules);
+  return modules;
+}
+
+bool select_internal_modules(
+    std::vector<std::string> &options,
+    const std::function<internal_module_set()> &detect, std::string &log) {
+  // Last one given wins
+  std::string requested;
+  bool explicit_modules = false;
+  for (auto it = options.begin(); it != options.end();) {
+    if (it->rfind(modules_option, 0) == 0) {
+      requested = it->substr(modules_option.size());
+      explicit_modules = true;
+      it = options.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  module_set modules = core_module;
+  if (!explicit_modules) {
+    modules = detect() | core_module;
+  } else if (requested == "all") {
+    modules = all_modules;
+  } else {
+    std::string_view list = requested;
+    while (!list.empty()) {
+      auto comma = list.find(',');
+      auto name = list.substr(0, comma);
+      auto index = find_module(name);
+      if (index == internal_module_count) {
+        log = "Unknown header module: " + std::string(name) + "\n";
+        return false;
+      }
+      modules |= module_set(1) << index;
+      list = (comma == std::string_view::npos) ? std::string_view()
+                                               : list.substr(comma + 1);
+    }
+  }
+
+  if (auto it = find_force_include(options); it != options.end()) {
+    *it = get_name(modules);
+  }
+  return true;
+}
+
+bool use_all_internal_modules(std::vector<std::string> &options) {
+  auto it = find_force_include(options);
+  if (it == options.end() || *it == internal_header_name) {
+    return false;
+  }
+  *it = internal_header_name;
+  return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Name the embedded header is force included as, with every module
+constexpr const char *internal_header_name = "hiprtc_internal_header.h";
+
+// Bit per module of the embedded header, core is the lowest
+using internal_module_set = uint32_t;
+
+/**
+ * @brief Get a fingerprint of the embedded hip runtime header
+ *
+ * Taken over the compressed text, so it does not decompress the header.
+ *
+ * @return const std::string& fingerprint as hex
+ */
+const std::string &get_internal_header_hash();
+
+/**
+ * @brief Get the embedded header under one of its names
+ *
+ * The header is decompressed on the first call.
+ *
+ * @param name internal_header_name or a name from select_internal_modules
+ * @return std::string_view text of the modules the name stands for, empty if
+ * it is not a name of the embedded header
+ */
+std::string_view get_internal_header(std::string_view name);
+
+/**
+ * @brief Find the embedded header among the force includes of options
+ *
+ * @param options compile options
+ * @return std::string_view its name, empty if it is not included
+ */
+std::string_view find_internal_header(const std::vector<std::string> &options);
+
+/**
+ * @brief Find the modules of the embedded header a text uses
+ *
+ * @param text source or header
+ * @return internal_module_set modules whose identifiers appear, with core
+ */
+internal_module_set detect_internal_modules(std::string_view text);
+
+/**
+ * @brief detect_internal_modules remembered by the fingerprint of the text
+ *
+ * For headers, which programs keep passing unchanged.
+ *
+ * @param text header
+ * @return internal_module_set modules whose identifiers appear, with core
+ */
+internal_module_set detect_header_modules(std::string_view text);
+
+/**
+ * @brief Force include only the modules of the embedded header a program uses
+ *
+ * --hiprtc-modules=<all|name,...> names them and is consumed from options,
+ * otherwise modules are the ones detect returns. Core is always in.
+ *
+ * @param options compile options, force including internal_header_name
+ * @param detect modules the program uses, only called without the option
+ * @param log reason of a failure
+ * @return true success
+ * @return false an unknown module was asked for
+ */
+bool select_internal_modules(
+    std::vector<std::string> &options,
+    const std::function<internal_module_set()> &detect, std::string &log);
+
+/**
+ * @brief Force include every module of the embedded header instead of some
+ *
+ * @param options compile options
+ * @return true options only had some modules and are changed
+ * @return false nothing to add
+ */
+bool use_all_internal_modules(std::vector<std::string> &options);
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Part of the embedded hip runtime header
+ *
+ * The header generator assigns every file hip_runtime.h pulls in to the first
+ * module with a fragment of its path, core gets the rest. A module only builds
+ * on core, one that does not parse without another module is folded into
+ * core at generation time. Compilations pick modules by the identifiers their
+ * sources use.
+ */
+struct internal_module {
+  const char *name_;
+  const char *paths_[8];     // Path fragments of its files
+  const char *triggers_[48]; // Identifiers using it, * matches a prefix
+};
+
+// In the order they are concatenated, core first and always in
+inline constexpr internal_module internal_modules[] = {
+    {"core", {}, {}},
+    {"math",
+     {"math_functions", "math_fwd", "ocml", "complex"},
+     {"sqrt*",     "rsqrt*",    "cbrt*",    "hypot*",     "exp*",
+      "log*",      "pow*",      "sin*",     "cos*",       "tan*",
+      "asin*",     "acos*",     "atan*",    "erf*",       "lgamma*",
+      "tgamma*",   "fabs*",     "fmin*",    "fmax*",      "fmod*",
+      "fma",       "fmaf",      "floor*",   "ceil*",      "round*",
+      "lround*",   "trunc*",    "rint*",    "nearbyint*", "copysign*",
+      "isnan",     "isinf",     "isfinite", "signbit",    "remainder*",
+      "ldexp*",    "frexp*",    "modf*",    "min",        "max",
+      "abs",       "__fdiv*",   "__frcp*",  "__fsqrt*",   "__saturatef",
+      "__sin*",    "__cos*",    "__exp*"}},
+    {"half",
+     {"fp16", "bf16", "fp8"},
+     {"half", "half2", "__half*", "__float2half*", "__hip_bfloat16*",
+      "hip_bfloat16", "__bfloat16*", "__float2bfloat16*", "__hip_fp8*",
+      "__hadd*", "__hsub*", "__hmul*", "__hdiv*", "__hfma*", "__low2half*",
+      "__high2half*", "__halves2half2"}},
+    {"atomics",
+     {"atomic"},
+     {"atomic*", "__hip_atomic*", "unsafeAtomic*", "safeAtomic*"}},
+    {"warp",
+     {"warp_functions", "warp_sync"},
+     {"__shfl*", "__ballot*", "__any*", "__all*", "__activemask", "__reduce*",
+      "__match*", "__syncwarp", "__popc*", "__lane_id", "__fns*"}},
+    {"cooperative_groups",
+     {"cooperative_groups", "cooperative_launch"},
+     {"cooperative_groups", "this_thread_block", "this_grid",
+      "tiled_partition", "thread_block*", "grid_group", "coalesced_group",
+      "coalesced_threads"}},
+    {"texture",
+     {"texture", "surface"},
+     {"tex1D*", "tex2D*", "tex3D*", "texCubemap*", "surf1D*", "surf2D*",
+      "surf3D*", "texture", "hipTextureObject_t", "hipSurfaceObject_t"}},
+};
+
+inline constexpr size_t internal_module_count =
+    sizeof(internal_modules) / sizeof(internal_modules[0]);
@@ -0,0 +1,278 @@
+#include "ipc.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(std::is_trivially_copyable_v<compile_stats>,
+              "compile_stats is sent as raw bytes");
+
+namespace {
+// A receiver maps a region only once it can no longer change size or content
+constexpr int required_seals = F_SEAL_SHRINK | F_SEAL_WRITE;
+} // namespace
+
+void message_writer::put(uint64_t value) { write(&value, sizeof(value)); }
+
+void message_writer::put(std::string_view value) {
+  put(uint64_t(value.size()));
+  write(value.data(), value.size());
+}
+
+void message_writer::write(const void *src, size_t len) {
+  if (data_ != nullptr && len != 0) {
+    std::memcpy(data_ + size_, src, len);
+  }
+  size_ += len;
+}
+
+bool message_reader::get(uint64_t &value) {
+  if (size_ - offset_ < sizeof(value)) {
+    return false;
+  }
+  std::memcpy(&value, data_ + offset_, sizeof(value));
+  offset_ += sizeof(value);
+  return true;
+}
+
+bool message_reader::get(std::string_view &value) {
+  uint64_t len = 0;
+  if (!get(len) || size_ - offset_ < len) {
+    return false;
+  }
+  value = std::string_view(data_ + offset_, len);
+  offset_ += len;
+  return true;
+}
+
+shared_region::~shared_region() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool shared_region::create(size_t size) {
+  fd_ = memfd_create("hiprtc_message", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd_ < 0 || size == 0 || ftruncate(fd_, size) != 0) {
+    return false;
+  }
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  data_ = static_cast<char *>(data);
+  size_ = size;
+  return true;
+}
+
+bool shared_region::seal() {
+  // Writable mappings would make F_SEAL_WRITE fail
+  if (data_ != nullptr && munmap(data_, size_) != 0) {
+    return false;
+  }
+  data_ = nullptr;
+  return fcntl(fd_, F_ADD_SEALS,
+               required_seals | F_SEAL_GROW | F_SEAL_SEAL) == 0;
+}
+
+bool shared_region::open(int fd) {
+  fd_ = fd;
+  int seals = fcntl(fd_, F_GET_SEALS);
+  if (seals < 0 || (seals & required_seals) != required_seals) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd_, &st) != 0 || st.st_size == 0) {
+    return false;
+  }
+  void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  data_ = static_cast<char *>(data);
+  size_ = st.st_size;
+  return true;
+}
+
+bool send_fd(int socket, int fd) {
+  char byte = 0;
+  iovec iov{&byte, 1};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  auto cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+  ssize_t res;
+  do {
+    res = sendmsg(socket, &msg, MSG_NOSIGNAL);
+  } while (res < 0 && errno == EINTR);
+  return res == 1;
+}
+
+int recv_fd(int socket) {
+  char byte = 0;
+  iovec iov{&byte, 1};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  ssize_t res;
+  do {
+    res = recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
+  } while (res < 0 && errno == EINTR);
+  auto cmsg = CMSG_FIRSTHDR(&msg);
+  if (res != 1 || cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS) {
+    return -1;
+  }
+  int fd;
+  std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+  return fd;
+}
+
+int exchange(int socket, const shared_region &request) {
+  return send_fd(socket, request.fd()) ? recv_fd(socket) : -1;
+}
+
+void write_program(message_writer &writer, const hiprtc_program *prog,
+                   const std::string &isa_name,
+                   const std::vector<std::string> &options) {
+  writer.put(isa_name);
+  writer.put(prog->name_);
+  writer.put(prog->source_.view());
+  writer.put(uint64_t(prog->name_expressions_.size()));
+  for (auto &name : prog->name_expressions_) {
+    writer.put(name);
+  }
+  // Registered headers go as plain ones, the other side has its own registry
+  writer.put(uint64_t(prog->headers_.size() +
+                      prog->registered_headers_.size()));
+  for (auto &header : prog->headers_) {
+    writer.put(header.first);
+    writer.put(header.second.view());
+  }
+  for (auto &header : prog->registered_headers_) {
+    writer.put(header->name_);
+    writer.put(header->text_);
+  }
+  writer.put(uint64_t(options.size()));
+  for (auto &option : options) {
+    writer.put(option);
+  }
+}
+
+bool read_program(message_reader &reader, std::string &isa_name,
+                  hiprtc_program &prog, std::vector<std::string> &options) {
+  uint64_t count = 0;
+  std::string_view text, name;
+  if (!reader.get(text)) {
+    return false;
+  }
+  isa_name = text;
+
+  if (!reader.get(text)) {
+    return false;
+  }
+  prog.name_ = text;
+  if (!reader.get(text)) {
+    return false;
+  }
+  prog.source_ = source_buffer::borrow(text.data(), text.size());
+
+  if (!reader.get(count)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < count; i++) {
+    if (!reader.get(name)) {
+      return false;
+    }
+    prog.name_expressions_.emplace_back(name);
+    prog.lowered_names_.emplace(name, std::string());
+  }
+
+  if (!reader.get(count)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < count; i++) {
+    if (!reader.get(name) || !reader.get(text)) {
+      return false;
+    }
+    prog.headers_.emplace_back(
+        name, source_buffer::borrow(text.data(), text.size()));
+  }
+
+  if (!reader.get(count)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < count; i++) {
+    if (!reader.get(text)) {
+      return false;
+    }
+    options.emplace_back(text);
+  }
+  return true;
+}
+
+void write_result(message_writer &writer, bool success, const cache_entry &out,
+                  const compile_stats &stats) {
+  writer.put(uint64_t(success));
+  writer.put(out.log_);
+  writer.put(out.bitcode());
+  writer.put(std::string_view(out.object_.data(), out.object_.size()));
+  writer.put(uint64_t(out.lowered_names_.size()));
+  for (auto &name_pair : out.lowered_names_) {
+    writer.put(name_pair.first);
+    writer.put(name_pair.second);
+  }
+  writer.put(std::string_view(reinterpret_cast<const char *>(&stats),
+                              sizeof(stats)));
+}
+
+bool read_result(message_reader &reader, bool &success, cache_entry &out,
+                 compile_stats &stats) {
+  uint64_t value = 0, count = 0;
+  std::string_view log, bitcode, object, name, lowered, stats_bytes;
+  if (!reader.get(value) || !reader.get(log) || !reader.get(bitcode) ||
+      !reader.get(object) || !reader.get(count)) {
+    return false;
+  }
+  success = (value != 0);
+  out.log_ = log;
+  out.bitcode_ = bitcode.empty() ? nullptr
+                                 : std::make_shared<const std::vector<char>>(
+                                       bitcode.begin(), bitcode.end());
+  out.object_.assign(object.begin(), object.end());
+
+  for (uint64_t i = 0; i < count; i++) {
+    if (!reader.get(name) || !reader.get(lowered)) {
+      return false;
+    }
+    out.lowered_names_[std::string(name)] = lowered;
+  }
+
+  if (!reader.get(stats_bytes) || stats_bytes.size() != sizeof(stats)) {
+    return false;
+  }
+  compile_stats remote_stats;
+  std::memcpy(&remote_stats, stats_bytes.data(), sizeof(remote_stats));
+  stats += remote_stats;
+  return true;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "hiprtc_internal.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Writes length prefixed fields, without a buffer only counts their size
+ *
+ */
+class message_writer {
+public:
+  explicit message_writer(char *data = nullptr) : data_(data) {}
+
+  void put(uint64_t value);
+  void put(std::string_view value);
+
+  size_t size() const { return size_; }
+
+private:
+  void write(const void *src, size_t len);
+
+  char *data_;
+  size_t size_ = 0;
+};
+
+/**
+ * @brief Reads fields written by message_writer, bounds checked
+ *
+ */
+class message_reader {
+public:
+  message_reader(const char *data, size_t size) : data_(data), size_(size) {}
+
+  bool get(uint64_t &value);
+
+  // value points into the message, no copy is made
+  bool get(std::string_view &value);
+
+private:
+  const char *data_;
+  size_t size_;
+  size_t offset_ = 0;
+};
+
+/**
+ * @brief Memory backed by a memfd, handed to another process as a descriptor
+ *
+ */
+class shared_region {
+public:
+  shared_region() = default;
+  ~shared_region();
+
+  shared_region(const shared_region &) = delete;
+  shared_region &operator=(const shared_region &) = delete;
+
+  /**
+   * @brief Create a writable region
+   *
+   * @param size size in bytes, not 0
+   * @return true success
+   * @return false failure
+   */
+  bool create(size_t size);
+
+  /**
+   * @brief Make the region read only for good and unmap it here
+   *
+   * Sealed against writes and size changes, so a receiver can not be made
+   * to read changing data or fault on a truncated mapping.
+   *
+   * @return true success
+   * @return false failure
+   */
+  bool seal();
+
+  /**
+   * @brief Map a region received from another process read only
+   *
+   * @param fd descriptor of the region, owned by the region from here on
+   * @return true success
+   * @return false failure, or the region is not sealed
+   */
+  bool open(int fd);
+
+  char *data() const { return data_; }
+  size_t size() const { return size_; }
+  int fd() const { return fd_; }
+
+private:
+  int fd_ = -1;
+  char *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+/**
+ * @brief Lay a message out in a new region
+ *
+ * write is called twice, once to size the message and once to fill it. The
+ * region is sealed afterwards, ready to be sent.
+ *
+ * @param region region to create
+ * @param write writes the fields to the message_writer it is passed
+ * @return true success
+ * @return false region can not be created or sealed
+ */
+template <typename Write>
+bool write_message(shared_region &region, Write &&write) {
+  message_writer counter;
+  write(counter);
+  if (!region.create(counter.size())) {
+    return false;
+  }
+  message_writer writer(region.data());
+  write(writer);
+  return region.seal();
+}
+
+/**
+ * @brief Send a descriptor over a unix socket
+ *
+ */
+bool send_fd(int socket, int fd);
+
+/**
+ * @brief Receive a descriptor from a unix socket
+ *
+ * @return int descriptor, -1 once the other side is gone
+ */
+int recv_fd(int socket);
+
+/**
+ * @brief Send a request and wait for the response
+ *
+ * @param socket connection
+ * @param request request to send
+ * @return int descriptor of the response region, -1 if the other side is gone
+ */
+int exchange(int socket, const shared_region &request);
+
+/**
+ * @brief Write the inputs of a program
+ *
+ */
+void write_program(message_writer &writer, const hiprtc_program *prog,
+                   const std::string &isa_name,
+                   const std::vector<std::string> &options);
+
+/**
+ * @brief Read the inputs of a program
+ *
+ * Source and headers of prog borrow from the message, which has to outlive
+ * it.
+ *
+ * @return true success
+ * @return false malformed message
+ */
+bool read_program(message_reader &reader, std::string &isa_name,
+                  hiprtc_program &prog, std::vector<std::string> &options);
+
+/**
+ * @brief Write the result of a compilation
+ *
+ */
+void write_result(message_writer &writer, bool success, const cache_entry &out,
+                  const compile_stats &stats);
+
+/**
+ * @brief Read the result of a compilation
+ *
+ * @param reader
+ * @param success result of the compilation
+ * @param out code object, bitcode, lowered names and log
+ * @param stats phases of the compilation are added
+ * @return true success
+ * @return false malformed message
+ */
+bool read_result(message_reader &reader, bool &success, cache_entry &out,
+                 compile_stats &stats);
@@ -0,0 +1,142 @@
+#include "link.hpp"
+#include "comgr_wrapper.hpp"
+
+#include <amd_comgr/amd_comgr.h>
+
+namespace {
+// Link all bitcode inputs and generate a single relocatable from them
+bool compile_bitcodes(hiprtc_link *link, const std::string &isa_name,
+                      std::vector<char> &reloc_out) {
+  amd_comgr_data_set_t data_set;
+  if (auto comgr_res = amd_comgr_create_data_set(&data_set);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    return false;
+  }
+
+  for (auto &bitcode : link->bitcodes_) {
+    if (!add_data(data_set, AMD_COMGR_DATA_KIND_BC, bitcode.second.data(),
+                  bitcode.second.size(), bitcode.first.c_str())) {
+      (void)amd_comgr_destroy_data_set(data_set);
+      return false;
+    }
+  }
+
+  amd_comgr_action_info_t action;
+  if (!get_action(action, isa_name, link->options_)) {
+    (void)amd_comgr_destroy_data_set(data_set);
+    return false;
+  }
+
+  amd_comgr_data_set_t linked;
+  if (auto comgr_res = amd_comgr_create_data_set(&linked);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    (void)amd_comgr_destroy_data_set(data_set);
+    return false;
+  }
+
+  // Link bitcode
+  if (auto comgr_res = amd_comgr_do_action(AMD_COMGR_ACTION_LINK_BC_TO_BC,
+                                           action, data_set, linked);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    link->log_ += "Error in linking bitcode:";
+    link->log_ += get_build_log(linked);
+    (void)amd_comgr_destroy_data_set(data_set);
+    (void)amd_comgr_destroy_data_set(linked);
+    return false;
+  }
+
+  link->log_ += get_build_log(linked);
+  (void)amd_comgr_destroy_data_set(data_set);
+
+  amd_comgr_data_set_t reloc;
+  if (auto comgr_res = amd_comgr_create_data_set(&reloc);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    (void)amd_comgr_destroy_data_set(linked);
+    return false;
+  }
+
+  // Optimize the whole program and generate code
+  if (auto comgr_res =
+          amd_comgr_do_action(AMD_COMGR_ACTION_CODEGEN_BC_TO_RELOCATABLE,
+                              action, linked, reloc);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    link->log_ += "Error in compilation to relocatable:";
+    link->log_ += get_build_log(reloc);
+    (void)amd_comgr_destroy_data_set(linked);
+    (void)amd_comgr_destroy_data_set(reloc);
+    return false;
+  }
+
+  link->log_ += get_build_log(reloc);
+  (void)amd_comgr_destroy_data_set(linked);
+
+  bool success = get_data(reloc, AMD_COMGR_DATA_KIND_RELOCATABLE, reloc_out);
+  (void)amd_comgr_destroy_data_set(reloc);
+  return success;
+}
+} // namespace
+
+bool link_program(hiprtc_link *link, const std::string &isa_name) {
+  link->log_.clear();
+  link->object_.clear();
+
+  std::vector<char> bitcode_reloc;
+  if (!link->bitcodes_.empty() &&
+      !compile_bitcodes(link, isa_name, bitcode_reloc)) {
+    return false;
+  }
+
+  amd_comgr_data_set_t data_set;
+  if (auto comgr_res = amd_comgr_create_data_set(&data_set);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    return false;
+  }
+
+  for (auto &reloc : link->relocatables_) {
+    if (!add_data(data_set, AMD_COMGR_DATA_KIND_RELOCATABLE,
+                  reloc.second.data(), reloc.second.size(),
+                  reloc.first.c_str())) {
+      (void)amd_comgr_destroy_data_set(data_set);
+      return false;
+    }
+  }
+
+  if (!bitcode_reloc.empty() &&
+      !add_data(data_set, AMD_COMGR_DATA_KIND_RELOCATABLE,
+                bitcode_reloc.data(), bitcode_reloc.size(), "bitcode.o")) {
+    (void)amd_comgr_destroy_data_set(data_set);
+    return false;
+  }
+
+  amd_comgr_action_info_t action;
+  if (!get_action(action, isa_name, link->options_)) {
+    (void)amd_comgr_destroy_data_set(data_set);
+    return false;
+  }
+
+  amd_comgr_data_set_t exe;
+  if (auto comgr_res = amd_comgr_create_data_set(&exe);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    (void)amd_comgr_destroy_data_set(data_set);
+    return false;
+  }
+
+  // Link
+  if (auto comgr_res = amd_comgr_do_action(
+          AMD_COMGR_ACTION_LINK_RELOCATABLE_TO_EXECUTABLE, action, data_set,
+          exe);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    link->log_ += "Error in linking to exe:";
+    link->log_ += get_build_log(exe);
+    (void)amd_comgr_destroy_data_set(data_set);
+    (void)amd_comgr_destroy_data_set(exe);
+    return false;
+  }
+
+  link->log_ += get_build_log(exe);
+  (void)amd_comgr_destroy_data_set(data_set);
+
+  bool success = get_data(exe, AMD_COMGR_DATA_KIND_EXECUTABLE, link->object_);
+  (void)amd_comgr_destroy_data_set(exe);
+  return success;
+}
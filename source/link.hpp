@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+struct hiprtc_link {
+  std::vector<std::string> options_; // Code generation and link options
+  std::vector<std::pair<std::string,
+                        std::vector<char>>> relocatables_; // <name, object>
+  std::vector<std::pair<std::string,
+                        std::vector<char>>> bitcodes_; // <name, bitcode>
+  std::vector<char> object_;                           // Linked code object
+  std::string log_;                                    // Log
+  bool completed_ = false; // No more inputs once linked
+};
+
+/**
+ * @brief Link all inputs into a code object
+ *
+ * Bitcode inputs are linked together and compiled to one relocatable first,
+ * then every relocatable is linked to an executable.
+ *
+ * @param link link state, object_ and log_ are filled
+ * @param isa_name target isa
+ * @return true success
+ * @return false failure, log_ has the reason
+ */
+bool link_program(hiprtc_link *link, const std::string &isa_name);
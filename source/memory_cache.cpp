@@ -0,0 +1,123 @@
+#include "memory_cache.hpp"
+#include "env.hpp"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace memory_cache {
+namespace {
+constexpr size_t default_max_size = size_t(128) << 20; // 128 MiB
+
+using lru_list =
+    std::list<std::pair<std::string, std::shared_ptr<const cache_entry>>>;
+
+struct cache_state {
+  std::mutex mutex_;
+  lru_list lru_; // Most recently used first
+  std::unordered_map<std::string, lru_list::iterator> index_;
+  size_t size_ = 0;
+  size_t max_size_ =
+      get_env_size("HIPRTC_MEMORY_CACHE_SIZE", default_max_size);
+  size_t hits_ = 0;
+  size_t misses_ = 0;
+  size_t evictions_ = 0;
+};
+
+cache_state &get_state() {
+  static cache_state state;
+  return state;
+}
+
+// Bytes accounted against the budget for an entry, bitcode is counted once
+// by the bitcode only entry that code objects share it with
+size_t entry_size(const std::string &key, const cache_entry &entry) {
+  size_t size = key.size() + entry.object_.size() + entry.log_.size() +
+                sizeof(cache_entry);
+  if (entry.object_.empty()) {
+    size += entry.bitcode().size();
+  }
+  for (auto &name_pair : entry.lowered_names_) {
+    size += name_pair.first.size() + name_pair.second.size();
+  }
+  return size;
+}
+
+// Needs state mutex held
+void evict_to(cache_state &state, size_t max_size) {
+  while (state.size_ > max_size && !state.lru_.empty()) {
+    auto &victim = state.lru_.back();
+    state.size_ -= entry_size(victim.first, *victim.second);
+    state.index_.erase(victim.first);
+    state.lru_.pop_back();
+    state.evictions_++;
+  }
+}
+} // namespace
+
+void set_limit(size_t max_size) {
+  auto &state = get_state();
+  std::lock_guard<std::mutex> lock(state.mutex_);
+  state.max_size_ = max_size;
+  evict_to(state, max_size);
+}
+
+bool enabled() {
+  auto &state = get_state();
+  std::lock_guard<std::mutex> lock(state.mutex_);
+  return state.max_size_ != 0;
+}
+
+std::shared_ptr<const cache_entry> lookup(const std::string &key) {
+  auto &state = get_state();
+  std::lock_guard<std::mutex> lock(state.mutex_);
+
+  auto it = state.index_.find(key);
+  if (it == state.index_.end()) {
+    state.misses_++;
+    return nullptr;
+  }
+
+  state.lru_.splice(state.lru_.begin(), state.lru_, it->second);
+  state.hits_++;
+  return it->second->second;
+}
+
+void insert(const std::string &key, std::shared_ptr<const cache_entry> entry) {
+  auto &state = get_state();
+  auto size = entry_size(key, *entry);
+
+  std::lock_guard<std::mutex> lock(state.mutex_);
+  if (size > state.max_size_) {
+    return;
+  }
+
+  // Another thread may have compiled the same program meanwhile
+  if (auto it = state.index_.find(key); it != state.index_.end()) {
+    state.size_ -= entry_size(key, *it->second->second);
+    state.lru_.erase(it->second);
+    state.index_.erase(it);
+  }
+
+  evict_to(state, state.max_size_ - size);
+  state.lru_.emplace_front(key, std::move(entry));
+  state.index_[key] = state.lru_.begin();
+  state.size_ += size;
+}
+
+void flush() {
+  auto &state = get_state();
+  std::lock_guard<std::mutex> lock(state.mutex_);
+  state.lru_.clear();
+  state.index_.clear();
+  state.size_ = 0;
+}
+
+stats get_stats() {
+  auto &state = get_state();
+  std::lock_guard<std::mutex> lock(state.mutex_);
+  return stats{state.hits_,        state.misses_, state.evictions_,
+               state.index_.size(), state.size_,   state.max_size_};
+}
+} // namespace memory_cache
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "cache_entry.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace memory_cache {
+/**
+ * @brief Counters and occupancy of the in-memory cache
+ *
+ */
+struct stats {
+  size_t hits;
+  size_t misses;
+  size_t evictions;
+  size_t entries;
+  size_t size;
+  size_t limit;
+};
+
+/**
+ * @brief Set the byte budget of the cache
+ *
+ * Defaults to HIPRTC_MEMORY_CACHE_SIZE or 128 MiB. Entries over the new budget
+ * are evicted right away, 0 disables the cache.
+ *
+ * @param max_size budget in bytes
+ */
+void set_limit(size_t max_size);
+
+/**
+ * @brief Is memory cache enabled
+ *
+ */
+bool enabled();
+
+/**
+ * @brief Look up an entry and mark it most recently used
+ *
+ * @param key fingerprint of the compilation inputs
+ * @return std::shared_ptr<const cache_entry> entry, nullptr on a miss
+ */
+std::shared_ptr<const cache_entry> lookup(const std::string &key);
+
+/**
+ * @brief Insert an entry, evicting least recently used ones over the budget
+ *
+ * @param key fingerprint of the compilation inputs
+ * @param entry entry to be stored
+ */
+void insert(const std::string &key, std::shared_ptr<const cache_entry> entry);
+
+/**
+ * @brief Drop all entries
+ *
+ */
+void flush();
+
+/**
+ * @brief Get the counters
+ *
+ */
+stats get_stats();
+} // namespace memory_cache
@@ -0,0 +1,219 @@
+#include "name_expressions.hpp"
+
+#include <elf.h>
+
+#include <cstring>
+#include <map>
+#include <string_view>
+#include <utility>
+
+namespace {
+constexpr std::string_view expr_prefix = "__amdgcn_name_expr_";
+
+// Section header i, nullptr if out of bounds
+const Elf64_Shdr *get_section(const std::vector<char> &object,
+                              const Elf64_Ehdr &ehdr, size_t i) {
+  size_t offset = ehdr.e_shoff + i * sizeof(Elf64_Shdr);
+  if (i >= ehdr.e_shnum || offset + sizeof(Elf64_Shdr) > object.size()) {
+    return nullptr;
+  }
+  return reinterpret_cast<const Elf64_Shdr *>(object.data() + offset);
+}
+
+bool in_bounds(const std::vector<char> &object, const Elf64_Shdr &section) {
+  return section.sh_offset <= object.size() &&
+         section.sh_size <= object.size() - section.sh_offset;
+}
+
+// Allocated section holding an address of an executable, 0 if none
+uint16_t get_section_at(const std::vector<char> &object,
+                        const Elf64_Ehdr &ehdr, uint64_t address) {
+  for (size_t i = 1; i < ehdr.e_shnum; i++) {
+    auto section = get_section(object, ehdr, i);
+    if (section != nullptr && (section->sh_flags & SHF_ALLOC) != 0 &&
+        address >= section->sh_addr &&
+        address - section->sh_addr < section->sh_size) {
+      return static_cast<uint16_t>(i);
+    }
+  }
+  return 0;
+}
+
+struct symbol_table {
+  const Elf64_Sym *symbols_ = nullptr;
+  size_t count_ = 0;
+  std::string_view strings_;
+
+  std::string_view name(size_t i) const {
+    if (i >= count_ || symbols_[i].st_name >= strings_.size()) {
+      return std::string_view();
+    }
+    auto text = strings_.substr(symbols_[i].st_name);
+    return text.substr(0, text.find('\0'));
+  }
+};
+
+// Symbol table in section i with its string table
+bool get_symbol_table(const std::vector<char> &object, const Elf64_Ehdr &ehdr,
+                      size_t i, symbol_table &table) {
+  auto section = get_section(object, ehdr, i);
+  if (section == nullptr || !in_bounds(object, *section) ||
+      (section->sh_type != SHT_SYMTAB && section->sh_type != SHT_DYNSYM)) {
+    return false;
+  }
+  auto strtab = get_section(object, ehdr, section->sh_link);
+  if (strtab == nullptr || !in_bounds(object, *strtab)) {
+    return false;
+  }
+  table.symbols_ =
+      reinterpret_cast<const Elf64_Sym *>(object.data() + section->sh_offset);
+  table.count_ = section->sh_size / sizeof(Elf64_Sym);
+  table.strings_ =
+      std::string_view(object.data() + strtab->sh_offset, strtab->sh_size);
+  return true;
+}
+
+// Index of a name expression array symbol, 0 if it is not one. Being static
+// the array is mangled as _ZL<len>__amdgcn_name_expr_<index>.
+size_t get_expr_index(std::string_view name) {
+  auto pos = name.find(expr_prefix);
+  if (pos == std::string_view::npos) {
+    return 0;
+  }
+  size_t index = 0;
+  for (char c : name.substr(pos + expr_prefix.size())) {
+    if (c < '0' || c > '9') {
+      break; // Suffixes added to static variables in rdc mode
+    }
+    index = index * 10 + (c - '0');
+  }
+  return index;
+}
+} // namespace
+
+std::string get_name_expression_code(const std::vector<std::string> &names) {
+  std::string code;
+  code.reserve(names.size() * 128);
+  for (size_t i = 0; i < names.size(); i++) {
+    auto index = std::to_string(i + 1);
+    code += "\n static __device__ const void* __amdgcn_name_expr_";
+    code += index;
+    code += "[]= {\"";
+    code += names[i];
+    code += "\", (void*)&";
+    code += names[i];
+    code += "};\n static auto __amdgcn_name_expr_stub_";
+    code += index;
+    code += " = __amdgcn_name_expr_";
+    code += index;
+    code += ";\n";
+  }
+  return code;
+}
+
+bool lower_names_from_elf(
+    const std::vector<char> &object, const std::vector<std::string> &names,
+    std::unordered_map<std::string, std::string> &lowered_names) {
+  if (object.size() < sizeof(Elf64_Ehdr) ||
+      std::memcmp(object.data(), ELFMAG, SELFMAG) != 0 ||
+      object[EI_CLASS] != ELFCLASS64) {
+    return false;
+  }
+  auto &ehdr = *reinterpret_cast<const Elf64_Ehdr *>(object.data());
+
+  // Arrays are local, only in the static symbol table
+  symbol_table symtab;
+  bool found = false;
+  for (size_t i = 0; i < ehdr.e_shnum && !found; i++) {
+    auto section = get_section(object, ehdr, i);
+    found = section != nullptr && section->sh_type == SHT_SYMTAB &&
+            get_symbol_table(object, ehdr, i, symtab);
+  }
+  if (!found) {
+    return false;
+  }
+
+  // Address slot of each array is the second pointer. Values of a
+  // relocatable are section relative, so every symbol is keyed by section
+  // and value: functions in sections of their own all sit at 0.
+  using symbol_key = std::pair<uint16_t, uint64_t>;
+  std::map<symbol_key, size_t> slots; // name index
+  std::map<symbol_key, std::string_view> functions;
+  for (size_t i = 0; i < symtab.count_; i++) {
+    auto &symbol = symtab.symbols_[i];
+    auto name = symtab.name(i);
+    if (name.empty()) {
+      continue;
+    }
+    if (auto index = get_expr_index(name);
+        index != 0 && index <= names.size()) {
+      slots[{symbol.st_shndx, symbol.st_value + sizeof(uint64_t)}] = index;
+    } else if (ELF64_ST_TYPE(symbol.st_info) == STT_FUNC ||
+               ELF64_ST_TYPE(symbol.st_info) == STT_OBJECT) {
+      functions.emplace(symbol_key{symbol.st_shndx, symbol.st_value}, name);
+    }
+  }
+
+  bool relocatable = ehdr.e_type == ET_REL;
+  std::vector<std::string_view> resolved(names.size() + 1);
+  for (size_t i = 0; i < ehdr.e_shnum; i++) {
+    auto section = get_section(object, ehdr, i);
+    if (section == nullptr || section->sh_type != SHT_RELA ||
+        !in_bounds(object, *section)) {
+      continue;
+    }
+
+    // Dynamic relocations index the dynamic symbol table
+    symbol_table rela_symbols;
+    if (!get_symbol_table(object, ehdr, section->sh_link, rela_symbols)) {
+      continue;
+    }
+
+    auto relas = reinterpret_cast<const Elf64_Rela *>(object.data() +
+                                                      section->sh_offset);
+    size_t rela_count = section->sh_size / sizeof(Elf64_Rela);
+    for (size_t j = 0; j < rela_count; j++) {
+      // A relocatable patches the section named by sh_info at an offset, an
+      // executable patches an address
+      uint16_t target = relocatable
+                            ? static_cast<uint16_t>(section->sh_info)
+                            : get_section_at(object, ehdr, relas[j].r_offset);
+      auto slot = slots.find({target, relas[j].r_offset});
+      if (slot == slots.end()) {
+        continue;
+      }
+
+      // Relocated against the symbol, against its section with the offset as
+      // addend, or relative with the address as addend
+      auto symbol_index = ELF64_R_SYM(relas[j].r_info);
+      auto function = functions.end();
+      if (symbol_index >= rela_symbols.count_) {
+        continue;
+      } else if (symbol_index == 0) {
+        if (!relocatable) {
+          function = functions.find(
+              {get_section_at(object, ehdr, relas[j].r_addend),
+               relas[j].r_addend});
+        }
+      } else if (auto &symbol = rela_symbols.symbols_[symbol_index];
+                 ELF64_ST_TYPE(symbol.st_info) == STT_SECTION) {
+        function = functions.find({symbol.st_shndx, relas[j].r_addend});
+      } else {
+        resolved[slot->second] = rela_symbols.name(symbol_index);
+      }
+      if (function != functions.end()) {
+        resolved[slot->second] = function->second;
+      }
+    }
+  }
+
+  for (size_t i = 1; i <= names.size(); i++) {
+    if (resolved[i].empty()) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < names.size(); i++) {
+    lowered_names[names[i]] = std::string(resolved[i + 1]);
+  }
+  return true;
+}
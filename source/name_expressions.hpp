@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Generate the code instantiating name expressions
+ *
+ * Every name expression i gets a __amdgcn_name_expr_<i + 1> array holding the
+ * expression text and its address, which keeps the instantiation alive and
+ * lets it be found in the code object.
+ *
+ * @param names name expressions in registration order
+ * @return std::string code to be compiled after the source
+ */
+std::string get_name_expression_code(const std::vector<std::string> &names);
+
+/**
+ * @brief Lower name expressions from the symbol and relocation tables of a
+ * code object
+ *
+ * One pass over symbols and one over relocations, each name expression array
+ * is matched to the symbol its address slot is relocated against.
+ *
+ * @param object executable or relocatable ELF code object
+ * @param names name expressions in registration order
+ * @param lowered_names filled with <name expression, symbol name>
+ * @return true every name was lowered
+ * @return false not an ELF or some name was not found, lowered_names is
+ * unchanged
+ */
+bool lower_names_from_elf(
+    const std::vector<char> &object, const std::vector<std::string> &names,
+    std::unordered_map<std::string, std::string> &lowered_names);
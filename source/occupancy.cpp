@@ -0,0 +1,152 @@
+#include "occupancy.hpp"
+
+#include <algorithm>
+
+namespace occupancy {
+namespace {
+constexpr size_t max_block_size = 1024; // Largest workgroup of any target
+
+// Processor, SIMDs per CU, waves per SIMD, wavefront size, VGPRs and their
+// granule, unified AGPRs, SGPRs and their granule, LDS, workgroups per CU.
+// gfx10 and later are counted in CU mode, half of a WGP.
+constexpr hardware_limits limits_table[] = {
+    {"gfx900", 4, 10, 64, 256, 4, false, 800, 16, 65536, 16},
+    {"gfx902", 4, 10, 64, 256, 4, false, 800, 16, 65536, 16},
+    {"gfx904", 4, 10, 64, 256, 4, false, 800, 16, 65536, 16},
+    {"gfx906", 4, 10, 64, 256, 4, false, 800, 16, 65536, 16},
+    {"gfx908", 4, 10, 64, 256, 4, false, 800, 16, 65536, 16},
+    {"gfx909", 4, 10, 64, 256, 4, false, 800, 16, 65536, 16},
+    {"gfx90c", 4, 10, 64, 256, 4, false, 800, 16, 65536, 16},
+    {"gfx9-generic", 4, 10, 64, 256, 4, false, 800, 16, 65536, 16},
+    {"gfx90a", 4, 8, 64, 512, 8, true, 800, 16, 65536, 16},
+    {"gfx940", 4, 8, 64, 512, 8, true, 800, 16, 65536, 16},
+    {"gfx941", 4, 8, 64, 512, 8, true, 800, 16, 65536, 16},
+    {"gfx942", 4, 8, 64, 512, 8, true, 800, 16, 65536, 16},
+    {"gfx9-4-generic", 4, 8, 64, 512, 8, true, 800, 16, 65536, 16},
+    {"gfx950", 4, 8, 64, 512, 8, true, 800, 16, 163840, 16},
+    {"gfx1010", 2, 20, 32, 1024, 8, false, 0, 0, 65536, 16},
+    {"gfx1011", 2, 20, 32, 1024, 8, false, 0, 0, 65536, 16},
+    {"gfx1012", 2, 20, 32, 1024, 8, false, 0, 0, 65536, 16},
+    {"gfx1013", 2, 20, 32, 1024, 8, false, 0, 0, 65536, 16},
+    {"gfx10-1-generic", 2, 20, 32, 1024, 8, false, 0, 0, 65536, 16},
+    {"gfx1030", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx1031", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx1032", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx1033", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx1034", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx1035", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx1036", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx10-3-generic", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx1100", 2, 16, 32, 1536, 24, false, 0, 0, 65536, 16},
+    {"gfx1101", 2, 16, 32, 1536, 24, false, 0, 0, 65536, 16},
+    {"gfx1102", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx1103", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx1150", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx1151", 2, 16, 32, 1536, 24, false, 0, 0, 65536, 16},
+    {"gfx1152", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx1153", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx11-generic", 2, 16, 32, 1024, 16, false, 0, 0, 65536, 16},
+    {"gfx1200", 2, 16, 32, 1536, 24, false, 0, 0, 65536, 16},
+    {"gfx1201", 2, 16, 32, 1536, 24, false, 0, 0, 65536, 16},
+    {"gfx12-generic", 2, 16, 32, 1536, 24, false, 0, 0, 65536, 16},
+};
+
+size_t align_up(size_t value, size_t granule) {
+  return (value + granule - 1) / granule * granule;
+}
+} // namespace
+
+const hardware_limits *get_limits(std::string_view target_id) {
+  auto processor = target_id.substr(0, target_id.find(':'));
+  auto it = std::find_if(
+      std::begin(limits_table), std::end(limits_table),
+      [&](const hardware_limits &l) { return l.processor_ == processor; });
+  return (it != std::end(limits_table)) ? &*it : nullptr;
+}
+
+bool estimate(const kernel_info &kernel, const hardware_limits &limits,
+              size_t block_size, size_t dynamic_lds,
+              occupancy_estimate &estimate) {
+  size_t wavefront_size = (kernel.wavefront_size_ != 0)
+                              ? kernel.wavefront_size_
+                              : limits.wavefront_size_;
+  if (block_size == 0 || wavefront_size == 0) {
+    return false;
+  }
+
+  // Wave64 on a wave32 processor takes two lanes worth of registers
+  size_t vgprs = limits.vgprs_, vgpr_granule = limits.vgpr_granule_;
+  if (wavefront_size > limits.wavefront_size_) {
+    vgprs /= 2;
+    vgpr_granule /= 2;
+  }
+  // Unified targets already count their AGPRs in the VGPRs
+  size_t used_vgprs = limits.unified_agprs_
+                          ? kernel.vgpr_count_
+                          : std::max(kernel.vgpr_count_, kernel.agpr_count_);
+
+  size_t waves = limits.max_waves_per_simd_;
+  estimate.limit_ = HIPRTC_OCCUPANCY_LIMIT_WAVES;
+  if (used_vgprs != 0) {
+    if (auto vgpr_waves = vgprs / align_up(used_vgprs, vgpr_granule);
+        vgpr_waves < waves) {
+      waves = vgpr_waves;
+      estimate.limit_ = HIPRTC_OCCUPANCY_LIMIT_VGPRS;
+    }
+  }
+  if (limits.sgprs_ != 0 && kernel.sgpr_count_ != 0) {
+    if (auto sgpr_waves =
+            limits.sgprs_ / align_up(kernel.sgpr_count_, limits.sgpr_granule_);
+        sgpr_waves < waves) {
+      waves = sgpr_waves;
+      estimate.limit_ = HIPRTC_OCCUPANCY_LIMIT_SGPRS;
+    }
+  }
+
+  // Waves of a workgroup all run on the same CU
+  size_t waves_per_workgroup = (block_size + wavefront_size - 1) /
+                               wavefront_size;
+  size_t workgroups = limits.simds_per_cu_ * waves / waves_per_workgroup;
+
+  // Single wave workgroups need no barrier
+  if (waves_per_workgroup > 1 && limits.max_workgroups_ < workgroups) {
+    workgroups = limits.max_workgroups_;
+    estimate.limit_ = HIPRTC_OCCUPANCY_LIMIT_WORKGROUPS;
+  }
+
+  size_t lds = kernel.group_segment_size_ + dynamic_lds;
+  if (lds < dynamic_lds || lds > limits.lds_size_) {
+    return false;
+  }
+  if (lds != 0 && limits.lds_size_ / lds < workgroups) {
+    workgroups = limits.lds_size_ / lds;
+    estimate.limit_ = HIPRTC_OCCUPANCY_LIMIT_LDS;
+  }
+
+  estimate.workgroups_per_cu_ = workgroups;
+  estimate.waves_per_cu_ = workgroups * waves_per_workgroup;
+  return workgroups != 0;
+}
+
+size_t suggest_block_size(const kernel_info &kernel,
+                          const hardware_limits &limits, size_t dynamic_lds) {
+  size_t wavefront_size = (kernel.wavefront_size_ != 0)
+                              ? kernel.wavefront_size_
+                              : limits.wavefront_size_;
+  size_t largest = (kernel.max_flat_workgroup_size_ != 0)
+                       ? std::min(kernel.max_flat_workgroup_size_,
+                                  max_block_size)
+                       : max_block_size;
+
+  size_t best = 0, best_waves = 0;
+  for (size_t size = wavefront_size; size <= largest; size += wavefront_size) {
+    occupancy_estimate candidate;
+    if (estimate(kernel, limits, size, dynamic_lds, candidate) &&
+        candidate.waves_per_cu_ >= best_waves) {
+      best = size;
+      best_waves = candidate.waves_per_cu_;
+    }
+  }
+  return best;
+}
+} // namespace occupancy
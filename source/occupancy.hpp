@@ -0,0 +1,76 @@
+#pragma once
+
+#include <hip/hiprtc.h>
+
+#include "code_object.hpp"
+
+#include <cstddef>
+#include <string_view>
+
+// Resources of a compute unit that bound how many waves stay resident
+struct hardware_limits {
+  std::string_view processor_;
+  size_t simds_per_cu_;
+  size_t max_waves_per_simd_;
+  size_t wavefront_size_; // Native one, VGPR figures are for it
+  size_t vgprs_;          // VGPRs of a SIMD lane
+  size_t vgpr_granule_;   // Allocation unit of VGPRs
+  bool unified_agprs_;    // AGPRs come after VGPRs in the same file
+  size_t sgprs_;          // SGPRs a SIMD shares among its waves, 0 if every
+                          // wave has its own
+  size_t sgpr_granule_;
+  size_t lds_size_;       // LDS of a CU in bytes, also the most a workgroup
+                          // can use
+  size_t max_workgroups_; // Workgroups of several waves a CU holds, one
+                          // barrier each
+};
+
+// Resident work of a kernel on one compute unit
+struct occupancy_estimate {
+  size_t workgroups_per_cu_ = 0;
+  size_t waves_per_cu_ = 0;
+  hiprtcOccupancyLimit limit_ = HIPRTC_OCCUPANCY_LIMIT_WAVES;
+};
+
+namespace occupancy {
+/**
+ * @brief Get the hardware limits of a target
+ *
+ * Built in for gfx9, gfx10, gfx11 and gfx12 processors and their generic
+ * targets, features of the target id are ignored.
+ *
+ * @param target_id e.g. gfx90a:xnack- or gfx1100
+ * @return const hardware_limits* nullptr for an unknown processor
+ */
+const hardware_limits *get_limits(std::string_view target_id);
+
+/**
+ * @brief Estimate how many workgroups of a kernel a compute unit holds
+ *
+ * Follows the HIP runtime occupancy calculation: registers bound the waves
+ * of a SIMD, then LDS and barriers bound the workgroups of a CU. Scratch is
+ * not taken into account.
+ *
+ * @param kernel resources from the code object
+ * @param limits hardware of the target
+ * @param block_size work items per workgroup
+ * @param dynamic_lds LDS per workgroup on top of the static one, in bytes
+ * @param estimate filled on success
+ * @return true success
+ * @return false the workgroup does not fit on a compute unit
+ */
+bool estimate(const kernel_info &kernel, const hardware_limits &limits,
+              size_t block_size, size_t dynamic_lds,
+              occupancy_estimate &estimate);
+
+/**
+ * @brief Largest block size reaching the highest occupancy
+ *
+ * Tries every multiple of the wavefront size up to the largest workgroup the
+ * kernel allows, dynamic_lds is taken per workgroup whatever its size.
+ *
+ * @return size_t 0 if no block size fits
+ */
+size_t suggest_block_size(const kernel_info &kernel,
+                          const hardware_limits &limits, size_t dynamic_lds);
+} // namespace occupancy
@@ -0,0 +1,74 @@
+#include "offload_bundle.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+constexpr char bundle_magic[] = "__CLANG_OFFLOAD_BUNDLE__";
+constexpr size_t bundle_magic_size = sizeof(bundle_magic) - 1;
+// Code objects are page aligned inside the bundle
+constexpr size_t bundle_alignment = 4096;
+// Bundler expects exactly one host entry, it is empty for device only code
+constexpr char host_id[] = "host-x86_64-unknown-linux-gnu-";
+
+size_t align_up(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+void write_u64(std::vector<char> &buf, size_t &pos, uint64_t value) {
+  std::memcpy(buf.data() + pos, &value, sizeof(value));
+  pos += sizeof(value);
+}
+} // namespace
+
+std::vector<char> create_offload_bundle(
+    const std::vector<std::pair<std::string, const std::vector<char> *>>
+        &objects) {
+  std::vector<std::pair<std::string, const std::vector<char> *>> entries;
+  static const std::vector<char> empty;
+  entries.emplace_back(host_id, &empty);
+  for (auto &object : objects) {
+    entries.emplace_back("hipv4-" + object.first, object.second);
+  }
+
+  // Header: magic, entry count, then offset, size, id size and id per entry
+  size_t header_size = bundle_magic_size + sizeof(uint64_t);
+  for (auto &entry : entries) {
+    header_size += 3 * sizeof(uint64_t) + entry.first.size();
+  }
+
+  std::vector<size_t> offsets;
+  size_t total_size = header_size;
+  for (auto &entry : entries) {
+    if (entry.second->empty()) {
+      offsets.push_back(total_size);
+      continue;
+    }
+    total_size = align_up(total_size, bundle_alignment);
+    offsets.push_back(total_size);
+    total_size += entry.second->size();
+  }
+
+  std::vector<char> bundle(total_size, 0);
+  size_t pos = 0;
+  std::memcpy(bundle.data(), bundle_magic, bundle_magic_size);
+  pos += bundle_magic_size;
+  write_u64(bundle, pos, entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    write_u64(bundle, pos, offsets[i]);
+    write_u64(bundle, pos, entries[i].second->size());
+    write_u64(bundle, pos, entries[i].first.size());
+    std::memcpy(bundle.data() + pos, entries[i].first.data(),
+                entries[i].first.size());
+    pos += entries[i].first.size();
+  }
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (!entries[i].second->empty()) {
+      std::memcpy(bundle.data() + offsets[i], entries[i].second->data(),
+                  entries[i].second->size());
+    }
+  }
+
+  return bundle;
+}
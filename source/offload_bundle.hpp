@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Pack code objects of several targets into a clang offload bundle
+ *
+ * The bundle is accepted by hipModuleLoadData and clang-offload-bundler, the
+ * runtime picks the code object matching the device.
+ *
+ * @param objects <isa name, code object> pairs, code objects are only read
+ * @return std::vector<char> bundle
+ */
+std::vector<char> create_offload_bundle(
+    const std::vector<std::pair<std::string, const std::vector<char> *>>
+        &objects);
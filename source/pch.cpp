@@ -0,0 +1,255 @@
+#include "pch.hpp"
+#include "comgr_wrapper.hpp"
+#include "env.hpp"
+#include "internal_header.hpp"
+
+#include <amd_comgr/amd_comgr.h>
+
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace pch {
+namespace {
+// Each precompiled header is tens of MB
+constexpr size_t max_entries = 8;
+
+struct pch_slot {
+  std::once_flag built_;
+  std::shared_ptr<const std::vector<char>> data_; // nullptr if build failed
+};
+
+struct pch_state {
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<pch_slot>> slots_;
+  std::deque<std::string> order_; // Insertion order for eviction
+  // Header name and macro name -> the header mentions the macro
+  std::unordered_map<std::string, bool> mentions_;
+};
+
+pch_state &get_state() {
+  static pch_state state;
+  return state;
+}
+
+std::string get_key(const std::string &isa_name,
+                    const std::vector<std::string> &options) {
+  std::string key = isa_name;
+  for (auto &option : options) {
+    key += '\0';
+    key += option;
+  }
+  return key;
+}
+
+bool is_identifier_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+// Does the header use a macro name as an identifier anywhere, in code or in
+// a directive. Remembered per header, the text is several MB.
+bool mentions(std::string_view header_name, std::string_view name) {
+  auto key = std::string(header_name) + '\0' + std::string(name);
+  auto &state = get_state();
+  {
+    std::lock_guard<std::mutex> lock(state.mutex_);
+    if (auto it = state.mentions_.find(key); it != state.mentions_.end()) {
+      return it->second;
+    }
+  }
+
+  auto header = get_internal_header(header_name);
+  bool found = false;
+  for (auto pos = header.find(name); pos != std::string_view::npos && !found;
+       pos = header.find(name, pos + 1)) {
+    auto end = pos + name.size();
+    found = (pos == 0 || !is_identifier_char(header[pos - 1])) &&
+            (end == header.size() || !is_identifier_char(header[end]));
+  }
+
+  std::lock_guard<std::mutex> lock(state.mutex_);
+  state.mentions_.emplace(std::move(key), found);
+  return found;
+}
+
+// -D and -U of the program go in the header like every other option, so it
+// is parsed as without a pch. Only macros the header never mentions are left
+// out, they can not change it: compiles only differing by them share one and
+// get them as predefines on top.
+std::vector<std::string>
+get_header_options(std::string_view header_name,
+                   const std::vector<std::string> &options) {
+  std::vector<std::string> res;
+  res.reserve(options.size());
+  for (auto &option : options) {
+    if ((option.rfind("-D", 0) == 0 || option.rfind("-U", 0) == 0) &&
+        option.size() > 2) {
+      auto macro = std::string_view(option).substr(2);
+      if (!mentions(header_name, macro.substr(0, macro.find_first_of("=(")))) {
+        continue;
+      }
+    }
+    res.push_back(option);
+  }
+  return res;
+}
+
+std::shared_ptr<const std::vector<char>>
+build(const std::string &isa_name, const std::string &header_name,
+      const std::vector<std::string> &options) {
+  amd_comgr_data_set_t data_set;
+  if (auto comgr_res = amd_comgr_create_data_set(&data_set);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    return nullptr;
+  }
+
+  // Internal header in the modules force included is the whole translation
+  // unit
+  auto header = get_internal_header(header_name);
+  amd_comgr_data_t data;
+  if (!create_data(data, AMD_COMGR_DATA_KIND_SOURCE, header.data(),
+                   header.size(), header_name.c_str())) {
+    (void)amd_comgr_destroy_data_set(data_set);
+    return nullptr;
+  }
+
+  if (auto comgr_res = amd_comgr_data_set_add(data_set, data);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    (void)amd_comgr_destroy_data_set(data_set);
+    (void)amd_comgr_release_data(data);
+    return nullptr;
+  }
+  (void)amd_comgr_release_data(data);
+
+  // Frontend emits an AST instead of bitcode, last action flag wins in cc1
+  auto pch_options = options;
+  pch_options.push_back("-Xclang");
+  pch_options.push_back("-emit-pch");
+  pch_options.push_back("-Xclang");
+  pch_options.push_back("-fno-pch-timestamp");
+
+  amd_comgr_action_info_t action;
+  if (!get_action(action, isa_name, pch_options)) {
+    (void)amd_comgr_destroy_data_set(data_set);
+    return nullptr;
+  }
+
+  amd_comgr_data_set_t output;
+  if (auto comgr_res = amd_comgr_create_data_set(&output);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    (void)amd_comgr_destroy_data_set(data_set);
+    return nullptr;
+  }
+
+  auto comgr_res = amd_comgr_do_action(AMD_COMGR_ACTION_COMPILE_SOURCE_TO_BC,
+                                       action, data_set, output);
+  (void)amd_comgr_destroy_data_set(data_set);
+  if (comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    (void)amd_comgr_destroy_data_set(output);
+    return nullptr;
+  }
+
+  amd_comgr_data_t pch_data;
+  if (auto comgr_res = amd_comgr_action_data_get_data(
+          output, AMD_COMGR_DATA_KIND_BC, 0, &pch_data);
+      comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+    (void)amd_comgr_destroy_data_set(output);
+    return nullptr;
+  }
+
+  size_t pch_size = 0;
+  std::vector<char> pch;
+  if (auto comgr_res = amd_comgr_get_data(pch_data, &pch_size, NULL);
+      comgr_res == AMD_COMGR_STATUS_SUCCESS && pch_size != 0) {
+    pch.resize(pch_size);
+    if (auto comgr_res = amd_comgr_get_data(pch_data, &pch_size, pch.data());
+        comgr_res != AMD_COMGR_STATUS_SUCCESS) {
+      pch.clear();
+    }
+  }
+
+  (void)amd_comgr_release_data(pch_data);
+  (void)amd_comgr_destroy_data_set(output);
+
+  if (pch.empty()) {
+    return nullptr;
+  }
+  return std::make_shared<const std::vector<char>>(std::move(pch));
+}
+} // namespace
+
+std::shared_ptr<const std::vector<char>>
+get(const std::string &isa_name, const std::vector<std::string> &options,
+    bool &reused) {
+  reused = false;
+  if (get_env("HIPRTC_DISABLE_PCH") == "1") {
+    return nullptr;
+  }
+
+  std::string header_name(find_internal_header(options));
+  if (header_name.empty()) {
+    return nullptr; // Internal header not in use
+  }
+
+  // Options name the modules of the header, they are part of the key
+  auto header_options = get_header_options(header_name, options);
+  auto key = get_key(isa_name, header_options);
+  std::shared_ptr<pch_slot> slot;
+  {
+    auto &state = get_state();
+    std::lock_guard<std::mutex> lock(state.mutex_);
+    auto &entry = state.slots_[key];
+    if (entry == nullptr) {
+      entry = std::make_shared<pch_slot>();
+      state.order_.push_back(key);
+      if (state.order_.size() > max_entries) {
+        state.slots_.erase(state.order_.front());
+        state.order_.pop_front();
+      }
+    }
+    slot = entry;
+  }
+
+  // Concurrent compilations of the same set wait for one build
+  bool built = false;
+  std::call_once(slot->built_, [&] {
+    slot->data_ =
+        build(isa_name, header_name, strip_internal_header(header_options));
+    built = true;
+  });
+  reused = !built && slot->data_ != nullptr;
+  return slot->data_;
+}
+
+std::vector<std::string>
+strip_internal_header(const std::vector<std::string> &options) {
+  auto header_name = find_internal_header(options);
+  std::vector<std::string> res;
+  res.reserve(options.size());
+  for (size_t i = 0; i < options.size(); i++) {
+    if (options[i] == "-include" && i + 1 < options.size() &&
+        !header_name.empty() && options[i + 1] == header_name) {
+      i++;
+      continue;
+    }
+    res.push_back(options[i]);
+  }
+  return res;
+}
+
+void mark_unusable(const std::string &isa_name,
+                   const std::vector<std::string> &options) {
+  auto key = get_key(
+      isa_name, get_header_options(find_internal_header(options), options));
+  auto &state = get_state();
+  std::lock_guard<std::mutex> lock(state.mutex_);
+  if (auto it = state.slots_.find(key); it != state.slots_.end()) {
+    // Slot stays, with a failed build
+    auto slot = std::make_shared<pch_slot>();
+    std::call_once(slot->built_, [] {});
+    it->second = slot;
+  }
+}
+} // namespace pch
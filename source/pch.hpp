@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pch {
+/**
+ * @brief Get the precompiled internal header for an isa and option set
+ *
+ * Built lazily with comgr on first use and kept for the process lifetime, at
+ * most a few option sets at a time. Disabled by HIPRTC_DISABLE_PCH=1. -D and
+ * -U of macros the header never mentions are left out, so option sets only
+ * differing by those share one.
+ *
+ * @param isa_name target isa
+ * @param options options of the compilation, including the force include of
+ * the internal header, whose name picks its modules
+ * @param reused set if the header was built by an earlier call
+ * @return std::shared_ptr<const std::vector<char>> precompiled header, nullptr
+ * if disabled or it could not be built
+ */
+std::shared_ptr<const std::vector<char>>
+get(const std::string &isa_name, const std::vector<std::string> &options,
+    bool &reused);
+
+/**
+ * @brief Remove the force include of the internal header from options
+ *
+ * The precompiled header replaces it, including it again would redefine
+ * everything.
+ *
+ * @param options options of the compilation
+ * @return std::vector<std::string> options to be used along the pch
+ */
+std::vector<std::string>
+strip_internal_header(const std::vector<std::string> &options);
+
+/**
+ * @brief Stop using the precompiled header of an isa and option set
+ *
+ * Used when a compilation only succeeds without it.
+ *
+ * @param isa_name target isa
+ * @param options options of the compilation
+ */
+void mark_unusable(const std::string &isa_name,
+                   const std::vector<std::string> &options);
+} // namespace pch
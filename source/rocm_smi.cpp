@@ -3,26 +3,49 @@
 #include <rocm_smi/rocm_smi.h>
 
 namespace rsmi {
-unsigned int get_device_count() { return 0; }
+namespace {
+// rocm_smi reports either the digits of the gfx name (1100 for gfx1100) or the
+// KFD encoding major * 10000 + minor * 100 + stepping (90010 for gfx90a)
+std::string get_processor_name(uint64_t version) {
+  if (version < 10000) {
+    return "gfx" + std::to_string(version);
+  }
 
-std::string get_isa_name(unsigned int device) {
-  std::string isa = "amdgcn-amd-amdhsa--gfx";
+  static const char digits[] = "0123456789abcdef";
+  uint64_t major = version / 10000;
+  uint64_t minor = (version / 100) % 100;
+  uint64_t stepping = version % 100;
+  if (minor > 15 || stepping > 15) {
+    return "gfx" + std::to_string(version);
+  }
+  return "gfx" + std::to_string(major) + digits[minor] + digits[stepping];
+}
+} // namespace
 
-  // Fetch number from rocm_smi
-  // This is stupid, will change this in future
+std::vector<std::string> get_processor_names() {
+  std::vector<std::string> names;
   if (auto ret = rsmi_init(0); ret != RSMI_STATUS_SUCCESS) {
-    return "";
+    return names;
   }
 
-  uint64_t name = 0;
-  if (auto ret = rsmi_dev_target_graphics_version_get(device, &name);
+  uint32_t count = 0;
+  if (auto ret = rsmi_num_monitor_devices(&count);
       ret != RSMI_STATUS_SUCCESS) {
-    return "";
+    (void)rsmi_shut_down();
+    return names;
   }
 
-  isa += std::to_string(name);
+  for (uint32_t i = 0; i < count; i++) {
+    uint64_t name = 0;
+    if (auto ret = rsmi_dev_target_graphics_version_get(i, &name);
+        ret != RSMI_STATUS_SUCCESS) {
+      names.clear();
+      break;
+    }
+    names.push_back(get_processor_name(name));
+  }
 
   (void)rsmi_shut_down();
-  return isa;
+  return names;
 }
 } // namespace rsmi
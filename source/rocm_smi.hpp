@@ -1,20 +1,13 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace rsmi {
 /**
- * @brief Get the device count object
+ * @brief Get processor names (gfxnnn) of all devices with one rsmi session
  *
- * @return unsigned int
+ * @return std::vector<std::string> one entry per device, empty on failure
  */
-unsigned int get_device_count();
-
-/**
- * @brief Get the isa name
- *
- * @param device
- * @return std::string
- */
-std::string get_isa_name(unsigned int device = 0);
+std::vector<std::string> get_processor_names();
 } // namespace rsmi
@@ -0,0 +1,128 @@
+#include "source_buffer.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <utility>
+
+namespace {
+// Smaller files are read, a copy costs less than the mapping and can not
+// fault when the file is truncated
+constexpr off_t map_threshold = 64 * 1024;
+} // namespace
+
+source_buffer::~source_buffer() { release(); }
+
+source_buffer::source_buffer(source_buffer &&other) noexcept
+    : owned_(std::move(other.owned_)), data_(other.data_), size_(other.size_),
+      mapped_(other.mapped_), from_file_(other.from_file_) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+  other.mapped_ = false;
+  other.from_file_ = false;
+}
+
+source_buffer &source_buffer::operator=(source_buffer &&other) noexcept {
+  if (this != &other) {
+    release();
+    owned_ = std::move(other.owned_);
+    data_ = other.data_;
+    size_ = other.size_;
+    mapped_ = other.mapped_;
+    from_file_ = other.from_file_;
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mapped_ = false;
+    other.from_file_ = false;
+  }
+  return *this;
+}
+
+void source_buffer::release() {
+  if (mapped_) {
+    (void)munmap(const_cast<char *>(data_), size_);
+  }
+  owned_.clear();
+  data_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+  from_file_ = false;
+}
+
+source_buffer source_buffer::borrow(const char *data, size_t size) {
+  source_buffer buffer;
+  buffer.data_ = data;
+  buffer.size_ = size;
+  return buffer;
+}
+
+bool source_buffer::map(const std::string &path, source_buffer &out) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    (void)close(fd);
+    return false;
+  }
+
+  // Nothing to map, an empty owned buffer reads the same
+  if (st.st_size == 0) {
+    (void)close(fd);
+    out = source_buffer();
+    out.from_file_ = true;
+    return true;
+  }
+
+  if (st.st_size < map_threshold) {
+    std::string text(static_cast<size_t>(st.st_size), '\0');
+    size_t done = 0;
+    while (done < text.size()) {
+      ssize_t n = read(fd, text.data() + done, text.size() - done);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0) {
+        (void)close(fd);
+        return false;
+      }
+      if (n == 0) {
+        break; // File shrank since fstat
+      }
+      done += static_cast<size_t>(n);
+    }
+    (void)close(fd);
+    text.resize(done);
+    out = source_buffer(std::move(text));
+    out.from_file_ = true;
+    return true;
+  }
+
+  void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  (void)close(fd); // Mapping keeps the file alive
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+
+  source_buffer buffer;
+  buffer.data_ = static_cast<const char *>(addr);
+  buffer.size_ = static_cast<size_t>(st.st_size);
+  buffer.mapped_ = true;
+  buffer.from_file_ = true;
+  out = std::move(buffer);
+  return true;
+}
+
+bool source_buffer::append(const char *data, size_t size) {
+  // Files small enough to be read are refused like mapped ones
+  if (data_ != nullptr || from_file_) {
+    return false;
+  }
+  owned_.append(data, size);
+  return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Text of a source or header, owned, borrowed from the caller or
+ * mapped from a file
+ *
+ * Only owned text is copied into the buffer. Borrowed and mapped text is read
+ * in place up to the point comgr takes its own copy.
+ */
+class source_buffer {
+public:
+  source_buffer() = default;
+  explicit source_buffer(std::string text) : owned_(std::move(text)) {}
+  ~source_buffer();
+
+  source_buffer(source_buffer &&other) noexcept;
+  source_buffer &operator=(source_buffer &&other) noexcept;
+  source_buffer(const source_buffer &) = delete;
+  source_buffer &operator=(const source_buffer &) = delete;
+
+  /**
+   * @brief Refer to caller memory, which has to outlive the buffer
+   *
+   * @param data text
+   * @param size size of text
+   * @return source_buffer
+   */
+  static source_buffer borrow(const char *data, size_t size);
+
+  /**
+   * @brief Map a file read only
+   *
+   * Files under 64 KiB are read into an owned buffer instead, which can not be
+ * appended to all the same.
+   *
+   * @param path path of the file
+   * @param out mapped buffer
+   * @return true success
+   * @return false file can not be opened or mapped
+   */
+  static bool map(const std::string &path, source_buffer &out);
+
+  /**
+   * @brief Append text, only for owned buffers not read from a file
+   *
+   * @param data text
+   * @param size size of text
+   * @return true success
+   * @return false buffer is borrowed or from map
+   */
+  bool append(const char *data, size_t size);
+
+  std::string_view view() const {
+    return (data_ != nullptr) ? std::string_view(data_, size_)
+                              : std::string_view(owned_);
+  }
+
+  size_t size() const { return view().size(); }
+
+private:
+  void release();
+
+  std::string owned_;
+  const char *data_ = nullptr; // Borrowed or mapped text
+  size_t size_ = 0;
+  bool mapped_ = false;    // data_ is a mapping to unmap
+  bool from_file_ = false; // Made by map, mapped or not
+};
@@ -0,0 +1,139 @@
+#include "target.hpp"
+#include "env.hpp"
+#include "rocm_smi.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+
+namespace target {
+namespace {
+constexpr const char *target_options[] = {"--offload-arch=",
+                                          "--gpu-architecture="};
+
+// Processors that support the xnack feature
+constexpr const char *xnack_processors[] = {
+    "gfx900", "gfx902", "gfx904", "gfx906", "gfx908", "gfx909",
+    "gfx90a", "gfx90c", "gfx940", "gfx941", "gfx942", "gfx950",
+    "gfx1010", "gfx1011", "gfx1012", "gfx1013"};
+
+bool supports_xnack(const std::string &processor) {
+  return std::find(std::begin(xnack_processors), std::end(xnack_processors),
+                   processor) != std::end(xnack_processors);
+}
+
+std::vector<std::string> detect_device_targets() {
+  auto targets = rsmi::get_processor_names();
+
+  // Runtime xnack mode is only known if user forced it
+  auto xnack = get_env("HSA_XNACK");
+  if (xnack == "0" || xnack == "1") {
+    for (auto &target : targets) {
+      if (supports_xnack(target)) {
+        target += (xnack == "1") ? ":xnack+" : ":xnack-";
+      }
+    }
+  }
+
+  return targets;
+}
+} // namespace
+
+bool is_valid(const std::string &target_id) {
+  auto processor_end = target_id.find(':');
+  auto processor = target_id.substr(0, processor_end);
+  if (processor.size() <= 3 || processor.compare(0, 3, "gfx") != 0 ||
+      processor.find_first_not_of("0123456789abcdef", 3) !=
+          std::string::npos) {
+    return false;
+  }
+
+  // Each feature at most once
+  bool seen_xnack = false, seen_sramecc = false;
+  while (processor_end != std::string::npos) {
+    auto start = processor_end + 1;
+    processor_end = target_id.find(':', start);
+    auto feature = target_id.substr(start, processor_end - start);
+    if (feature == "xnack+" || feature == "xnack-") {
+      if (seen_xnack) {
+        return false;
+      }
+      seen_xnack = true;
+    } else if (feature == "sramecc+" || feature == "sramecc-") {
+      if (seen_sramecc) {
+        return false;
+      }
+      seen_sramecc = true;
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+const std::vector<std::string> &get_device_targets() {
+  static std::once_flag flag;
+  static std::vector<std::string> targets;
+  std::call_once(flag, [] { targets = detect_device_targets(); });
+  return targets;
+}
+
+bool resolve(std::vector<std::string> &options,
+             std::vector<std::string> &target_ids) {
+  target_ids.clear();
+
+  std::string requested;
+  for (auto it = options.begin(); it != options.end();) {
+    auto prefix = std::find_if(
+        std::begin(target_options), std::end(target_options),
+        [&](const char *opt) { return it->rfind(opt, 0) == 0; });
+    if (prefix == std::end(target_options)) {
+      ++it;
+      continue;
+    }
+    requested += it->substr(std::char_traits<char>::length(*prefix)) + ",";
+    it = options.erase(it);
+  }
+
+  if (requested.empty()) {
+    requested = get_env("HIPRTC_TARGET");
+  }
+
+  if (!requested.empty()) {
+    size_t start = 0;
+    while (start <= requested.size()) {
+      auto end = requested.find(',', start);
+      if (end == std::string::npos) {
+        end = requested.size();
+      }
+      auto target_id = requested.substr(start, end - start);
+      start = end + 1;
+      if (target_id.empty()) {
+        continue;
+      }
+      if (!is_valid(target_id)) {
+        target_ids = {target_id};
+        return false;
+      }
+      if (std::find(target_ids.begin(), target_ids.end(), target_id) ==
+          target_ids.end()) {
+        target_ids.push_back(target_id);
+      }
+    }
+    return true;
+  }
+
+  auto &targets = get_device_targets();
+  auto device = static_cast<size_t>(
+      std::strtoul(get_env("HIPRTC_DEVICE").c_str(), nullptr, 10));
+  if (device < targets.size()) {
+    target_ids.push_back(targets[device]);
+  }
+  return true;
+}
+
+std::string get_isa_name(const std::string &target_id) {
+  return "amdgcn-amd-amdhsa--" + target_id;
+}
+} // namespace target
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace target {
+/**
+ * @brief Check a target id
+ *
+ * A target id is a processor optionally followed by features, e.g. gfx1100,
+ * gfx90a:xnack- or gfx90a:sramecc+:xnack-
+ *
+ * @param target_id
+ * @return true valid
+ * @return false invalid
+ */
+bool is_valid(const std::string &target_id);
+
+/**
+ * @brief Get target ids of the devices of this machine
+ *
+ * Detected once per process through rocm_smi, which only reports the
+ * processor. xnack is taken from HSA_XNACK when set. sramecc is not detected
+ * and stays any, code for it loads whether ECC is on or off. Pass a full
+ * target id, e.g. gfx90a:sramecc+:xnack-, to compile for one mode.
+ *
+ * @return const std::vector<std::string>& one entry per device
+ */
+const std::vector<std::string> &get_device_targets();
+
+/**
+ * @brief Pick the targets of a compilation
+ *
+ * In order of preference, --offload-arch=<id> or --gpu-architecture=<id> in
+ * options, HIPRTC_TARGET, the device selected by HIPRTC_DEVICE (default 0).
+ * The first two do not touch rocm_smi at all, and take several targets either
+ * repeated or as a comma separated list. Target options are removed from
+ * options as comgr gets the target through the action isa.
+ *
+ * @param options compile options, target options are consumed
+ * @param target_ids resolved target ids without duplicates, empty if none
+ * could be found. On failure holds the invalid id.
+ * @return true success
+ * @return false an explicitly requested target is not valid
+ */
+bool resolve(std::vector<std::string> &options,
+             std::vector<std::string> &target_ids);
+
+/**
+ * @brief Get the comgr isa name of a target id
+ *
+ * @param target_id
+ * @return std::string amdgcn-amd-amdhsa--<target_id>
+ */
+std::string get_isa_name(const std::string &target_id);
+} // namespace target
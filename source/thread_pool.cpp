@@ -0,0 +1,96 @@
+#include "thread_pool.hpp"
+#include "env.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+thread_pool::thread_pool(size_t num_threads) {
+  workers_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; i++) {
+    workers_.emplace_back([this] { run(); });
+  }
+}
+
+thread_pool::~thread_pool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void thread_pool::submit(std::function<void()> job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(std::move(job));
+  }
+  cv_.notify_one();
+}
+
+void thread_pool::run() {
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+      if (jobs_.empty()) {
+        return; // stopping and drained
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    job();
+  }
+}
+
+void thread_pool::parallel_for(size_t count,
+                               const std::function<void(size_t)> &func) {
+  // Helpers may only get to run after the loop is over, so state they touch
+  // outlives this call
+  struct loop_state {
+    std::atomic<size_t> next_{0};
+    size_t count_ = 0;
+    size_t done_ = 0;
+    const std::function<void(size_t)> *func_ = nullptr;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+  };
+
+  auto state = std::make_shared<loop_state>();
+  state->count_ = count;
+  state->func_ = &func;
+
+  auto work = [state] {
+    size_t finished = 0;
+    for (size_t i = state->next_++; i < state->count_; i = state->next_++) {
+      (*state->func_)(i);
+      finished++;
+    }
+    if (finished != 0) {
+      std::lock_guard<std::mutex> lock(state->mutex_);
+      state->done_ += finished;
+      if (state->done_ == state->count_) {
+        state->cv_.notify_all();
+      }
+    }
+  };
+
+  for (size_t i = 1; i < std::min(count, size() + 1); i++) {
+    submit(work);
+  }
+  work();
+
+  std::unique_lock<std::mutex> lock(state->mutex_);
+  state->cv_.wait(lock, [&] { return state->done_ == state->count_; });
+}
+
+thread_pool &thread_pool::get() {
+  static thread_pool pool(std::max<size_t>(
+      1, get_env_size("HIPRTC_NUM_THREADS",
+                      std::thread::hardware_concurrency())));
+  return pool;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed size pool of worker threads running jobs in submission order
+ *
+ */
+class thread_pool {
+public:
+  explicit thread_pool(size_t num_threads);
+  ~thread_pool();
+
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+
+  /**
+   * @brief Queue a job to be run by a worker
+   *
+   * @param job
+   */
+  void submit(std::function<void()> job);
+
+  /**
+   * @brief Run func(0) .. func(count - 1) on the pool and wait for them
+   *
+   * The calling thread takes part, so this makes progress even when called
+   * from a worker of the same pool.
+   *
+   * @param count number of iterations
+   * @param func body of the loop
+   */
+  void parallel_for(size_t count, const std::function<void(size_t)> &func);
+
+  size_t size() const { return workers_.size(); }
+
+  /**
+   * @brief Get the process wide pool
+   *
+   * Sized to HIPRTC_NUM_THREADS, or the number of cores, on first use.
+   *
+   * @return thread_pool&
+   */
+  static thread_pool &get();
+
+private:
+  void run();
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> jobs_;
+  std::vector<std::thread> workers_;
+  bool stop_ = false;
+};
@@ -0,0 +1,340 @@
+#include "worker_pool.hpp"
+#include "env.hpp"
+#include "ipc.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace {
+// Descriptor a worker finds its end of the socket on
+constexpr int worker_socket_fd = 3;
+
+// Time a worker gets to answer a request, 10 minutes
+constexpr size_t default_timeout_ms = 600000;
+
+// Stage, program and, for code generation, the bitcode to start from
+void write_request(message_writer &writer, compile_stage stage,
+                   const hiprtc_program *prog, const std::string &isa_name,
+                   const std::vector<std::string> &options,
+                   const cache_entry &in) {
+  writer.put(uint64_t(stage));
+  write_program(writer, prog, isa_name, options);
+  writer.put(stage == compile_stage::codegen ? in.bitcode()
+                                             : std::string_view());
+}
+
+bool read_request(message_reader &reader, compile_stage &stage,
+                  std::string &isa_name, hiprtc_program &prog,
+                  std::vector<std::string> &options, cache_entry &in) {
+  uint64_t value = 0;
+  std::string_view bitcode;
+  if (!reader.get(value) || !read_program(reader, isa_name, prog, options) ||
+      !reader.get(bitcode)) {
+    return false;
+  }
+  stage = compile_stage(value);
+  in.bitcode_ = std::make_shared<const std::vector<char>>(bitcode.begin(),
+                                                         bitcode.end());
+  return true;
+}
+
+// Wait for a worker to answer, false once timeout_ms passed without an
+// answer. A timeout of 0 waits for ever.
+bool wait_response(int socket, size_t timeout_ms) {
+  if (timeout_ms == 0) {
+    return true;
+  }
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(timeout_ms);
+  pollfd fd{socket, POLLIN, 0};
+  while (true) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now())
+                    .count();
+    int res = poll(&fd, 1, int(std::clamp<decltype(left)>(left, 0, INT_MAX)));
+    if (res >= 0 || errno != EINTR) {
+      return res != 0; // Errors and hang ups are left to recv_fd
+    }
+  }
+}
+
+struct worker {
+  pid_t pid_ = -1;
+  int socket_ = -1;
+};
+
+/**
+ * @brief Worker processes and the idle ones among them
+ *
+ * The lock only guards handing workers out, compilations run unlocked.
+ */
+class pool {
+public:
+  pool() {
+    auto count = get_env_size("HIPRTC_WORKERS", 0);
+    if (count == 0) {
+      return;
+    }
+
+    timeout_ms_ = get_env_size("HIPRTC_WORKER_TIMEOUT_MS", default_timeout_ms);
+    path_ = get_env("HIPRTC_WORKER_PATH");
+    Dl_info info;
+    if (path_.empty() && dladdr(reinterpret_cast<void *>(&worker_pool::run),
+                                &info) != 0) {
+      // Installed next to the library
+      std::string library = info.dli_fname;
+      auto slash = library.rfind('/');
+      path_ = (slash == std::string::npos ? std::string(".")
+                                          : library.substr(0, slash)) +
+              "/hiprtc_worker";
+    }
+
+    for (size_t i = 0; i < count; i++) {
+      worker w;
+      if (spawn(w)) {
+        idle_.push_back(w);
+      }
+    }
+    size_ = idle_.size();
+  }
+
+  ~pool() {
+    // Workers exit once their socket is closed
+    for (auto &w : idle_) {
+      close(w.socket_);
+      (void)waitpid(w.pid_, nullptr, 0);
+    }
+  }
+
+  bool enabled() const { return size_ != 0; }
+
+  size_t timeout_ms() const { return timeout_ms_; }
+
+  // Idle worker, pid_ is -1 if none is left
+  worker acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !idle_.empty() || size_ == 0; });
+    if (idle_.empty()) {
+      return worker();
+    }
+    auto w = idle_.back();
+    idle_.pop_back();
+    return w;
+  }
+
+  void release(worker w) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      idle_.push_back(w);
+    }
+    cv_.notify_one();
+  }
+
+  // Reap a worker that went away, log why and start a new one in its place
+  void replace(worker w, std::string &log) {
+    close(w.socket_);
+    int status = 0;
+    if (waitpid(w.pid_, &status, 0) == w.pid_) {
+      if (WIFSIGNALED(status)) {
+        log += "Compile worker " + std::to_string(w.pid_) +
+               " terminated by signal " + std::to_string(WTERMSIG(status)) +
+               "\n";
+      } else {
+        log += "Compile worker " + std::to_string(w.pid_) +
+               " exited with status " + std::to_string(WEXITSTATUS(status)) +
+               "\n";
+      }
+    }
+
+    worker replacement;
+    bool spawned = spawn(replacement);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (spawned) {
+        idle_.push_back(replacement);
+      } else {
+        size_--;
+      }
+    }
+    cv_.notify_all();
+  }
+
+private:
+  bool spawn(worker &w) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+      return false;
+    }
+
+    // dup2 onto itself would keep close-on-exec
+    if (fds[1] == worker_socket_fd) {
+      int fd = fcntl(fds[1], F_DUPFD_CLOEXEC, worker_socket_fd + 1);
+      close(fds[1]);
+      fds[1] = fd;
+    }
+
+    // posix_spawn, fork is not safe in a process running other threads
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], worker_socket_fd);
+    auto fd_arg = std::to_string(worker_socket_fd);
+    char *argv[] = {path_.data(), fd_arg.data(), nullptr};
+    pid_t pid = -1;
+    int res = posix_spawn(&pid, path_.c_str(), &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (res != 0) {
+      close(fds[0]);
+      return false;
+    }
+
+    w.pid_ = pid;
+    w.socket_ = fds[0];
+    return true;
+  }
+
+  std::string path_;
+  size_t timeout_ms_ = default_timeout_ms;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<worker> idle_;
+  std::atomic<size_t> size_{0}; // Workers alive
+};
+
+pool &get_pool() {
+  static pool instance;
+  return instance;
+}
+} // namespace
+
+namespace worker_pool {
+bool enabled() { return get_pool().enabled(); }
+
+bool run(compile_stage stage, const hiprtc_program *prog,
+         const std::string &isa_name, const std::vector<std::string> &options,
+         cache_entry &out, compile_stats &stats) {
+  auto dataset_start = stats_clock::now();
+  shared_region request;
+  if (!write_message(request, [&](message_writer &writer) {
+        write_request(writer, stage, prog, isa_name, options, out);
+      })) {
+    out.log_ += "Failed to create shared memory for the compile worker\n";
+    return false;
+  }
+  stats.dataset_ms_ += elapsed_ms(dataset_start);
+
+  auto &workers = get_pool();
+  int response_fd = -1;
+  // A worker found dead before it got the request is retried once
+  for (int attempt = 0; attempt < 2 && response_fd < 0; attempt++) {
+    auto w = workers.acquire();
+    if (w.pid_ < 0) {
+      out.log_ += "No compile worker available\n";
+      return false;
+    }
+    bool sent = send_fd(w.socket_, request.fd());
+    bool answered = sent && wait_response(w.socket_, workers.timeout_ms());
+    if (sent && !answered) {
+      // Hung, kill it so it is reaped and replaced like one that crashed
+      out.log_ += "Compile worker " + std::to_string(w.pid_) +
+                  " did not answer within " +
+                  std::to_string(workers.timeout_ms()) + " ms\n";
+      (void)kill(w.pid_, SIGKILL);
+    }
+    response_fd = answered ? recv_fd(w.socket_) : -1;
+    if (response_fd < 0) {
+      workers.replace(w, out.log_);
+      if (sent) {
+        return false; // Died on this request, do not take down another
+      }
+    } else {
+      workers.release(w);
+    }
+  }
+  if (response_fd < 0) {
+    return false;
+  }
+
+  scoped_timer extract_timer(stats.extract_ms_);
+  shared_region response;
+  if (!response.open(response_fd)) {
+    out.log_ += "Failed to map the response of the compile worker\n";
+    return false;
+  }
+  cache_entry result;
+  bool success = false;
+  message_reader reader(response.data(), response.size());
+  if (!read_result(reader, success, result, stats)) {
+    out.log_ += "Malformed response of the compile worker\n";
+    return false;
+  }
+
+  out.log_ += result.log_;
+  if (stage == compile_stage::frontend) {
+    out.bitcode_ = std::move(result.bitcode_);
+  } else {
+    out.object_ = std::move(result.object_);
+    out.lowered_names_ = std::move(result.lowered_names_);
+  }
+  return success;
+}
+
+int serve(int socket) {
+  while (true) {
+    int request_fd = recv_fd(socket);
+    if (request_fd < 0) {
+      return 0; // Host is gone
+    }
+
+    shared_region request;
+    hiprtc_program prog;
+    compile_stage stage = compile_stage::frontend;
+    std::string isa_name;
+    std::vector<std::string> options;
+    cache_entry out;
+    compile_stats stats;
+    bool success = false;
+    if (request.open(request_fd)) {
+      message_reader reader(request.data(), request.size());
+      if (read_request(reader, stage, isa_name, prog, options, out)) {
+        // Precompiled headers stay loaded in this process across requests
+        success = run_compile_stage(stage, &prog, isa_name, options, out,
+                                    stats);
+        if (stage == compile_stage::codegen) {
+          out.bitcode_.reset(); // Host has it already
+        }
+      } else {
+        out.log_ = "Malformed request to the compile worker\n";
+      }
+    }
+
+    shared_region response;
+    if (!write_message(response, [&](message_writer &writer) {
+          write_result(writer, success, out, stats);
+        })) {
+      return 1;
+    }
+    if (!send_fd(socket, response.fd())) {
+      return 1;
+    }
+  }
+}
+} // namespace worker_pool
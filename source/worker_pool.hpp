@@ -0,0 +1,48 @@
+#pragma once
+
+#include "hiprtc_internal.hpp"
+
+#include <string>
+#include <vector>
+
+namespace worker_pool {
+/**
+ * @brief Is the out of process backend on
+ *
+ * On first use starts HIPRTC_WORKERS worker processes, the backend stays off
+ * when it is unset, 0 or none of them can be started.
+ *
+ */
+bool enabled();
+
+/**
+ * @brief Run a stage of a compilation in an idle worker process
+ *
+ * Inputs and outputs go through shared memory. Waits for a worker when all
+ * are busy. A worker that dies fails the compilation and is replaced, so does
+ * one that does not answer within HIPRTC_WORKER_TIMEOUT_MS after it is
+ * killed.
+ *
+ * @param stage stage to run
+ * @param prog program, not modified
+ * @param isa_name target isa
+ * @param options compile options
+ * @param out result of the stage, as from run_compile_stage
+ * @param stats phases of the stage in the worker are added
+ * @return true success
+ * @return false failure, out.log_ has the reason
+ */
+bool run(compile_stage stage, const hiprtc_program *prog,
+         const std::string &isa_name, const std::vector<std::string> &options,
+         cache_entry &out, compile_stats &stats);
+
+/**
+ * @brief Serve requests of the host process until it goes away
+ *
+ * Main loop of hiprtc_worker.
+ *
+ * @param socket connection to the host
+ * @return int exit code
+ */
+int serve(int socket);
+} // namespace worker_pool
@@ -0,0 +1,133 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <thread>
+
+struct callback_data {
+  std::atomic<int> calls{0};
+  std::atomic<hiprtcResult> result{HIPRTC_SUCCESS};
+  std::shared_future<void> release;
+};
+
+void on_compiled(hiprtcProgram, hiprtcResult result, void *user_data) {
+  auto data = static_cast<callback_data *>(user_data);
+  data->result = result;
+  data->calls++;
+  if (data->release.valid()) {
+    data->release.wait();
+  }
+}
+
+// Keeps using the program well after its result is published
+void on_compiled_slow(hiprtcProgram prog, hiprtcResult, void *user_data) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  size_t code_size = 0;
+  check(hiprtcGetCodeSize(prog, &code_size) == HIPRTC_SUCCESS);
+  check(code_size != 0);
+  *static_cast<std::atomic<bool> *>(user_data) = true;
+}
+
+void on_compiled_destroy(hiprtcProgram prog, hiprtcResult, void *user_data) {
+  check(hiprtcWaitProgram(prog) == HIPRTC_SUCCESS);
+  check(hiprtcDestroyProgram(&prog) == HIPRTC_SUCCESS);
+  *static_cast<std::atomic<bool> *>(user_data) = true;
+}
+
+hiprtcProgram create(int value) {
+  std::string source =
+      "extern \"C\" __global__ void kernel(int *a) { *a = " +
+      std::to_string(value) + "; }";
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  return prog;
+}
+
+int main() {
+  // One worker, so a blocked callback keeps later compilations queued
+  setenv("HIPRTC_NUM_THREADS", "1", 1);
+
+  std::promise<void> release;
+  callback_data first;
+  first.release = release.get_future().share();
+  auto prog = create(1);
+  hiprtc_check(hiprtcCompileProgramAsync(prog, 0, nullptr, on_compiled, &first));
+
+  callback_data second;
+  auto queued = create(2);
+  hiprtc_check(
+      hiprtcCompileProgramAsync(queued, 0, nullptr, on_compiled, &second));
+  check(hiprtcQueryProgram(queued) == HIPRTC_ERROR_NOT_READY);
+  check(hiprtcCompileProgram(queued, 0, nullptr) == HIPRTC_ERROR_INVALID_INPUT);
+
+  // Dropped before it started
+  hiprtc_check(hiprtcCancelCompile(queued));
+  check(hiprtcQueryProgram(queued) == HIPRTC_ERROR_CANCELLED);
+  check(second.calls == 1);
+  check(second.result == HIPRTC_ERROR_CANCELLED);
+  check(hiprtcCancelCompile(queued) == HIPRTC_ERROR_INVALID_INPUT);
+
+  release.set_value();
+  hiprtc_check(hiprtcWaitProgram(prog));
+  check(first.calls == 1);
+  check(first.result == HIPRTC_SUCCESS);
+
+  size_t code_size = 0;
+  hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+  check(code_size != 0);
+
+  // Cancelled program can be compiled again
+  hiprtc_check(hiprtcCompileProgramAsync(queued, 0, nullptr, nullptr, nullptr));
+  hiprtc_check(hiprtcWaitProgram(queued));
+  hiprtc_check(hiprtcQueryProgram(queued));
+
+  // A cancel that succeeds always discards the result, even when it comes in
+  // as the compilation finishes
+  for (int i = 0; i < 200; i++) {
+    hiprtc_check(
+        hiprtcCompileProgramAsync(queued, 0, nullptr, nullptr, nullptr));
+    auto cancelled = hiprtcCancelCompile(queued);
+    auto res = hiprtcWaitProgram(queued);
+    if (cancelled == HIPRTC_SUCCESS) {
+      check(res == HIPRTC_ERROR_CANCELLED);
+      check(hiprtcGetCodeSize(queued, &code_size) ==
+            HIPRTC_ERROR_COMPILATION);
+    } else {
+      hiprtc_check(res);
+    }
+  }
+
+  // Destroy while in flight
+  auto pending = create(3);
+  hiprtc_check(
+      hiprtcCompileProgramAsync(pending, 0, nullptr, nullptr, nullptr));
+  hiprtc_check(hiprtcDestroyProgram(&pending));
+
+  // Destroy waits for a callback still using the program
+  std::atomic<bool> used{false};
+  auto slow = create(4);
+  hiprtc_check(
+      hiprtcCompileProgramAsync(slow, 0, nullptr, on_compiled_slow, &used));
+  while (hiprtcQueryProgram(slow) == HIPRTC_ERROR_NOT_READY) {
+    std::this_thread::yield();
+  }
+  hiprtc_check(hiprtcDestroyProgram(&slow));
+  check(used);
+
+  // Wait and destroy from the callback itself do not block
+  std::atomic<bool> destroyed{false};
+  auto self = create(5);
+  hiprtc_check(hiprtcCompileProgramAsync(self, 0, nullptr, on_compiled_destroy,
+                                         &destroyed));
+  while (!destroyed) {
+    std::this_thread::yield();
+  }
+
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  hiprtc_check(hiprtcDestroyProgram(&queued));
+}
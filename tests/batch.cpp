@@ -0,0 +1,54 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <string>
+#include <vector>
+
+int main() {
+  constexpr int num_progs = 8;
+  constexpr int invalid_prog = 5;
+
+  std::vector<hiprtcProgram> progs(num_progs);
+  for (int i = 0; i < num_progs; i++) {
+    std::string source = (i == invalid_prog)
+                             ? "obviously invalid c++ program"
+                             : "extern \"C\" __global__ void kernel(int *a) { "
+                               "*a = " +
+                                   std::to_string(i) + "; }";
+    hiprtc_check(hiprtcCreateProgram(&progs[i], source.c_str(), nullptr, 0,
+                                     nullptr, nullptr));
+  }
+
+  std::vector<hiprtcResult> results(num_progs);
+  check(hiprtcCompileProgramsBatch(progs.data(), num_progs, 0, nullptr,
+                                   results.data()) ==
+        HIPRTC_ERROR_COMPILATION);
+
+  for (int i = 0; i < num_progs; i++) {
+    size_t code_size = 0;
+    if (i == invalid_prog) {
+      check(results[i] == HIPRTC_ERROR_COMPILATION);
+      check(hiprtcGetCodeSize(progs[i], &code_size) != HIPRTC_SUCCESS);
+    } else {
+      check(results[i] == HIPRTC_SUCCESS);
+      hiprtc_check(hiprtcGetCodeSize(progs[i], &code_size));
+      check(code_size != 0);
+    }
+  }
+
+  // Compiled programs compile again, duplicates are rejected up front
+  check(hiprtcCompileProgramsBatch(progs.data(), num_progs, 0, nullptr,
+                                   results.data()) ==
+        HIPRTC_ERROR_COMPILATION);
+  check(results[0] == HIPRTC_SUCCESS);
+  std::vector<hiprtcProgram> duplicates = {progs[0], progs[1], progs[0]};
+  check(hiprtcCompileProgramsBatch(duplicates.data(), 3, 0, nullptr,
+                                   nullptr) == HIPRTC_ERROR_INVALID_INPUT);
+
+  for (auto &prog : progs) {
+    hiprtc_check(hiprtcDestroyProgram(&prog));
+  }
+
+  // Empty batch
+  hiprtc_check(hiprtcCompileProgramsBatch(progs.data(), 0, 0, nullptr, nullptr));
+}
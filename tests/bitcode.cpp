@@ -0,0 +1,50 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <string>
+#include <vector>
+
+int main() {
+  const char *source = "extern \"C\" __global__ void kernel(int *a) { *a = 2; }";
+  hiprtcMemoryCacheStats before, after;
+
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+  const char *options[] = {"--offload-arch=gfx90a"};
+  hiprtc_check(hiprtcCompileProgram(prog, 1, options));
+
+  size_t bitcode_size = 0;
+  hiprtc_check(hiprtcGetBitcodeSize(prog, &bitcode_size));
+  check(bitcode_size != 0);
+  std::vector<char> bitcode(bitcode_size);
+  hiprtc_check(hiprtcGetBitcode(prog, bitcode.data()));
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // Only code generation options change, front end output is reused
+  hiprtc_check(hiprtcGetMemoryCacheStats(&before));
+  const char *codegen_options[] = {"--offload-arch=gfx90a", "-mllvm",
+                                   "-amdgpu-early-inline-all=true"};
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(prog, 3, codegen_options));
+  hiprtc_check(hiprtcGetMemoryCacheStats(&after));
+  check(after.hits == before.hits + 1);  // bitcode
+  check(after.misses == before.misses + 1); // code object
+
+  std::vector<char> reused(bitcode_size);
+  hiprtc_check(hiprtcGetBitcodeSize(prog, &bitcode_size));
+  check(bitcode_size == reused.size());
+  hiprtc_check(hiprtcGetBitcode(prog, reused.data()));
+  check(reused == bitcode);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // No single bitcode for several targets
+  const char *targets[] = {"--offload-arch=gfx90a,gfx1100"};
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(prog, 1, targets));
+  check(hiprtcGetBitcodeSize(prog, &bitcode_size) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+}
@@ -0,0 +1,75 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+struct allocations {
+  int count = 0;
+  void *last = nullptr;
+};
+
+void *counting_allocator(size_t size, void *user_data) {
+  auto allocs = static_cast<allocations *>(user_data);
+  allocs->count++;
+  allocs->last = std::malloc(size);
+  return allocs->last;
+}
+
+void *failing_allocator(size_t, void *) { return nullptr; }
+
+int main() {
+  const char *source = "extern \"C\" __global__ void kernel(int *a) { *a = 3; }";
+
+  // Borrowed code matches the copy
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  const void *code = nullptr;
+  size_t code_size = 0;
+  hiprtc_check(hiprtcGetCodePtr(prog, &code, &code_size));
+  check(code != nullptr && code_size != 0);
+  std::vector<char> copy(code_size);
+  hiprtc_check(hiprtcGetCode(prog, copy.data()));
+  check(std::memcmp(code, copy.data(), code_size) == 0);
+
+  // Same source again is served by the cache without a copy
+  hiprtcProgram other;
+  hiprtc_check(
+      hiprtcCreateProgram(&other, source, nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(other, 0, nullptr));
+  const void *other_code = nullptr;
+  size_t other_size = 0;
+  hiprtc_check(hiprtcGetCodePtr(other, &other_code, &other_size));
+  check(other_code == code && other_size == code_size);
+  hiprtc_check(hiprtcDestroyProgram(&other));
+
+  // So is a recompile of the program
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  hiprtc_check(hiprtcGetCodePtr(prog, &other_code, &other_size));
+  check(other_code == code);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // Code placed in caller memory, survives the program
+  allocations allocs;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcSetCodeAllocator(prog, counting_allocator, &allocs));
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  hiprtc_check(hiprtcGetCodePtr(prog, &code, &code_size));
+  check(allocs.count == 1);
+  check(code == allocs.last);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  check(std::memcmp(allocs.last, copy.data(), code_size) == 0);
+  std::free(allocs.last);
+
+  // Failed allocation fails the compilation
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcSetCodeAllocator(prog, failing_allocator, nullptr));
+  check(hiprtcCompileProgram(prog, 0, nullptr) == HIPRTC_ERROR_COMPILATION);
+  check(hiprtcGetCodePtr(prog, &code, &code_size) == HIPRTC_ERROR_COMPILATION);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+}
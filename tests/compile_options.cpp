@@ -0,0 +1,102 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <string>
+#include <vector>
+
+const std::string source =
+    "extern \"C\" __global__ void kernel(int *a) { *a = A + B; }";
+
+hiprtcResult compile(hiprtcProgram prog, std::vector<const char *> options) {
+  return hiprtcCompileProgram(prog, options.size(),
+                              options.empty() ? nullptr : options.data());
+}
+
+std::string get_log(hiprtcProgram prog) {
+  size_t log_size = 0;
+  hiprtc_check(hiprtcGetProgramLogSize(prog, &log_size));
+  std::string log(log_size, 0);
+  hiprtc_check(hiprtcGetProgramLog(prog, log.data()));
+  return log;
+}
+
+// Cache hits of compiling the source with options
+size_t cache_hits(std::vector<const char *> options) {
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  hiprtc_check(compile(prog, options));
+  hiprtcProgramStats stats{};
+  stats.struct_size = sizeof(stats);
+  hiprtc_check(hiprtcGetProgramStats(prog, &stats));
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  return stats.cache_hits;
+}
+
+int main() {
+  hiprtc_check(hiprtcFlushMemoryCache());
+
+  // Rejected before compiling, the program can still be compiled
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  check(compile(prog, {"-DA=1", "--bogus"}) == HIPRTC_ERROR_INVALID_OPTION);
+  check(get_log(prog).find("--bogus") != std::string::npos);
+  check(compile(prog, {"-O9"}) == HIPRTC_ERROR_INVALID_OPTION);
+  check(compile(prog, {"-std=c99"}) == HIPRTC_ERROR_INVALID_OPTION);
+  check(compile(prog, {"-D"}) == HIPRTC_ERROR_INVALID_OPTION);
+  check(compile(prog, {"-D1A"}) == HIPRTC_ERROR_INVALID_OPTION);
+  check(compile(prog, {"-mllvm"}) == HIPRTC_ERROR_INVALID_OPTION);
+  check(compile(prog, {"-include"}) == HIPRTC_ERROR_INVALID_OPTION);
+  check(compile(prog, {"-DA=1", "-DB=2", "-R"}) ==
+        HIPRTC_ERROR_INVALID_OPTION);
+  check(compile(prog, {"--gpu-max-threads-per-block="}) ==
+        HIPRTC_ERROR_INVALID_OPTION);
+  hiprtc_check(compile(prog, {"-DA=1", "-DB=2"}));
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // Options clang takes are accepted
+  for (auto *option :
+       {"--gpu-max-threads-per-block=256", "-save-temps",
+        "-Rpass-analysis=kernel-resource-usage", "-Ofast", "-v"}) {
+    hiprtc_check(hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0,
+                                     nullptr, nullptr));
+    hiprtc_check(compile(prog, {"-DA=1", "-DB=2", option}));
+    hiprtc_check(hiprtcDestroyProgram(&prog));
+  }
+
+  // Same compile spelled differently is a cache hit
+  check(cache_hits({"-DB=2", "-DA=1"}) == 1);
+  check(cache_hits({"-D", "B=2", "-DA=1", "-DA=1"}) == 1);
+  check(cache_hits({"-DA=2", "-DB=2", "-UA", "-DA=1"}) == 1);
+
+  check(cache_hits({"-DA=1", "-DB=2", "-O0"}) == 0);
+  check(cache_hits({"-O2", "-DA=1", "-O0", "-DB=2"}) == 1);
+  check(cache_hits({"-DA=1", "-DB=2", "-O3"}) == 1); // -O3 is the default
+
+  check(cache_hits({"-DA=1", "-DB=2", "-ffast-math"}) == 0);
+  check(cache_hits({"-fno-fast-math", "-ffast-math", "-DA=1", "-DB=2"}) == 1);
+  check(cache_hits({"-DA=1", "-DB=2", "-ffast-math", "-fno-fast-math"}) == 0);
+  check(cache_hits({"-fno-fast-math", "-DB=2", "-DA=1"}) == 1);
+
+  check(cache_hits({"-DA=1", "-DB=2", "-O1"}) == 0);
+  check(cache_hits({"-O", "-DA=1", "-DB=2"}) == 1);
+  check(cache_hits({"-DA=1", "-DB=2", "-std=c++20"}) == 0);
+  check(cache_hits({"--std=c++20", "-DA=1", "-DB=2"}) == 1);
+
+  // List valued flags add up, only exact repeats are dropped
+  check(cache_hits({"-DA=1", "-DB=2", "-fsanitize=undefined"}) == 0);
+  check(cache_hits({"-DA=1", "-DB=2", "-fsanitize=address",
+                    "-fsanitize=undefined"}) == 0);
+  check(cache_hits({"-fsanitize=address", "-DA=1", "-fsanitize=address",
+                    "-DB=2", "-fsanitize=undefined"}) == 1);
+  check(cache_hits({"-DA=1", "-DB=2", "-fsanitize=address",
+                    "-fno-sanitize=address", "-fsanitize=undefined"}) == 0);
+
+  check(cache_hits({"-DA=1", "-DB=2", "--gpu-max-threads-per-block=128"}) ==
+        0);
+  check(cache_hits({"--gpu-max-threads-per-block=64", "-DA=1", "-DB=2",
+                    "--gpu-max-threads-per-block=128"}) == 1);
+
+  hiprtc_check(hiprtcFlushMemoryCache());
+}
@@ -0,0 +1,79 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::string get_source(int i) {
+  return "extern \"C\" __global__ void kernel(int *a) { *a = " +
+         std::to_string(i) + "; }";
+}
+
+std::vector<char> compile(const std::string &source) {
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  size_t code_size = 0;
+  hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+  std::vector<char> code(code_size);
+  hiprtc_check(hiprtcGetCode(prog, code.data()));
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  return code;
+}
+
+// Compile programs first..first + threads * per_thread, each thread its own
+// share, and return the time taken in ms
+double compile_concurrently(int threads, int per_thread, int first,
+                            std::vector<std::vector<char>> &codes) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      for (int i = t * per_thread; i < (t + 1) * per_thread; i++) {
+        codes[i] = compile(get_source(first + i));
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+int main() {
+  // Compiles take long enough to overlap, read on the first action
+  setenv("HIPRTC_MOCK_ACTION_US", "2000", 1);
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+  hiprtc_check(hiprtcSetDiskCache(nullptr, 0));
+
+  // Every program gets its own code object, same as compiled alone
+  const int threads = 4, per_thread = 8;
+  std::vector<std::vector<char>> codes(threads * per_thread);
+  (void)compile_concurrently(threads, per_thread, 0, codes);
+  for (int i = 0; i < threads * per_thread; i += 5) {
+    check(codes[i] == compile(get_source(i)));
+  }
+
+  // Throughput rises with threads, distinct sources keep the caches out
+  std::vector<std::vector<char>> serial(per_thread), parallel(codes.size());
+  double serial_ms = compile_concurrently(1, per_thread, 1000, serial);
+  double parallel_ms =
+      compile_concurrently(threads, per_thread, 2000, parallel);
+  double speedup = (threads * serial_ms) / parallel_ms;
+  std::cout << "Speedup with " << threads << " threads: " << speedup
+            << std::endl;
+#ifdef HIPRTC_TEST_MOCK
+  bool can_scale = true; // Mock actions sleep
+#else
+  bool can_scale = std::thread::hardware_concurrency() >= unsigned(threads);
+#endif
+  if (can_scale) {
+    check(speedup > 2);
+  }
+}
@@ -0,0 +1,166 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+hiprtcProgram create(const std::string &source) {
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  return prog;
+}
+
+// Compile, returns code and how many targets were served without compiling
+std::vector<char> compile(const std::string &source, size_t &cache_hits) {
+  auto prog = create(source);
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  size_t code_size = 0;
+  hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+  std::vector<char> code(code_size);
+  hiprtc_check(hiprtcGetCode(prog, code.data()));
+  hiprtcProgramStats stats{};
+  stats.struct_size = sizeof(stats);
+  hiprtc_check(hiprtcGetProgramStats(prog, &stats));
+  cache_hits = stats.cache_hits;
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  return code;
+}
+
+// Send a request the client can still change to the daemon, returns the log
+// of its answer, empty if there was none
+std::string send_unsealed(const std::string &path) {
+  int socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  check(connect(socket, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) == 0);
+
+  int request = memfd_create("request", MFD_CLOEXEC);
+  check(request >= 0 && ftruncate(request, 4096) == 0);
+  char byte = 0;
+  iovec iov{&byte, 1};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  auto cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(cmsg), &request, sizeof(int));
+  check(sendmsg(socket, &msg, 0) == 1);
+  close(request);
+
+  // Answer is a success flag followed by the length prefixed log
+  std::string log;
+  if (recvmsg(socket, &msg, MSG_CMSG_CLOEXEC) == 1 &&
+      (cmsg = CMSG_FIRSTHDR(&msg)) != nullptr) {
+    int response;
+    std::memcpy(&response, CMSG_DATA(cmsg), sizeof(int));
+    auto size = lseek(response, 0, SEEK_END);
+    auto data = static_cast<const char *>(
+        mmap(nullptr, size, PROT_READ, MAP_SHARED, response, 0));
+    uint64_t success = 1, log_size = 0;
+    std::memcpy(&success, data, sizeof(success));
+    std::memcpy(&log_size, data + sizeof(success), sizeof(log_size));
+    check(success == 0);
+    log.assign(data + 2 * sizeof(uint64_t), log_size);
+    munmap(const_cast<char *>(data), size);
+    close(response);
+  }
+  close(socket);
+  return log;
+}
+
+int main() {
+  auto socket_path =
+      std::filesystem::temp_directory_path() /
+      ("hiprtc_daemon_test_" + std::to_string(getpid()) + ".sock");
+  std::string path = socket_path.string();
+  char *argv[] = {const_cast<char *>(HIPRTC_DAEMON_PATH), path.data(),
+                  nullptr};
+  pid_t daemon = -1;
+  check(posix_spawn(&daemon, HIPRTC_DAEMON_PATH, nullptr, nullptr, argv,
+                    environ) == 0);
+  for (int i = 0; i < 500 && !std::filesystem::exists(socket_path); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  check(std::filesystem::exists(socket_path));
+
+  // Only the owner can connect, and requests have to be sealed
+  namespace fs = std::filesystem;
+  check((fs::status(socket_path).permissions() & fs::perms::all) ==
+        (fs::perms::owner_read | fs::perms::owner_write));
+  check(send_unsealed(path).find("sealed") != std::string::npos);
+
+  // Read on first compile, local caches off so every compile asks the daemon
+  setenv("HIPRTC_DAEMON_SOCKET", path.c_str(), 1);
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+  hiprtc_check(hiprtcSetDiskCache(nullptr, 0));
+
+  std::string source =
+      "extern \"C\" __global__ void kernel(int *a) { *a = 10; }";
+  size_t cache_hits = 0;
+  auto code = compile(source, cache_hits);
+  check(!code.empty());
+  check(cache_hits == 0);
+
+  // Served from the cache of the daemon
+  check(compile(source, cache_hits) == code);
+  check(cache_hits == 1);
+
+  // Identical programs at once are compiled once
+  std::string batch_source =
+      "extern \"C\" __global__ void kernel(int *a) { *a = 20; }";
+  const int count = 8;
+  std::vector<hiprtcProgram> progs;
+  for (int i = 0; i < count; i++) {
+    progs.push_back(create(batch_source));
+  }
+  hiprtc_check(hiprtcCompileProgramsBatch(progs.data(), count, 0, nullptr,
+                                          nullptr));
+  size_t batch_hits = 0;
+  for (auto &prog : progs) {
+    hiprtcProgramStats stats{};
+    stats.struct_size = sizeof(stats);
+    hiprtc_check(hiprtcGetProgramStats(prog, &stats));
+    batch_hits += stats.cache_hits;
+    hiprtc_check(hiprtcDestroyProgram(&prog));
+  }
+  check(batch_hits == count - 1);
+
+  // Errors come back with their log
+  auto prog = create("#error invalid\nextern \"C\" __global__ void kernel() {}");
+  check(hiprtcCompileProgram(prog, 0, nullptr) == HIPRTC_ERROR_COMPILATION);
+  size_t log_size = 0;
+  hiprtc_check(hiprtcGetProgramLogSize(prog, &log_size));
+  check(log_size != 0);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // Without a daemon programs are compiled in process
+  kill(daemon, SIGTERM);
+  waitpid(daemon, nullptr, 0);
+  check(compile(source, cache_hits) == code);
+  check(cache_hits == 0);
+  std::filesystem::remove(socket_path);
+}
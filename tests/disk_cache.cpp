@@ -0,0 +1,95 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+std::vector<char> compile(const std::string &source) {
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+
+  size_t code_size = 0;
+  hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+  std::vector<char> code(code_size, 0);
+  hiprtc_check(hiprtcGetCode(prog, code.data()));
+
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  return code;
+}
+
+int main() {
+  auto cache_dir =
+      std::filesystem::temp_directory_path() / "hiprtc_disk_cache_test";
+  std::filesystem::remove_all(cache_dir);
+  hiprtc_check(hiprtcSetDiskCache(cache_dir.c_str(), 0));
+  // Second compile would be served by the in-memory cache otherwise
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+
+  // Large enough for its bitcode to dominate the size of an entry
+  std::string source =
+      "extern \"C\" __global__ void kernel(int *a) { *a = 10; }\n// " +
+      std::string(64 * 1024, 'x') + "\n";
+  auto first = compile(source);
+  auto second = compile(source);
+  check(!first.empty());
+  check(first == second);
+
+  hiprtcDiskCacheStats stats;
+  hiprtc_check(hiprtcGetDiskCacheStats(&stats));
+  // Bitcode and code object are stored separately, the code object gets its
+  // bitcode back from the bitcode entry
+  check(stats.misses == 2);
+  check(stats.stores == 2);
+  check(stats.hits == 2);
+
+  // Bitcode is only stored once, in the bitcode entry
+  size_t bitcode_size = 0, stored_size = 0;
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  hiprtc_check(hiprtcGetBitcodeSize(prog, &bitcode_size));
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  check(bitcode_size > 64 * 1024);
+  for (auto &file : std::filesystem::recursive_directory_iterator(cache_dir)) {
+    if (file.is_regular_file()) {
+      stored_size += file.file_size();
+    }
+  }
+  check(stored_size < bitcode_size + first.size() + 4096);
+
+  // With the bitcode entry evicted the code object is still served, only
+  // without bitcode
+  for (auto &file : std::filesystem::recursive_directory_iterator(cache_dir)) {
+    std::ifstream in(file.path(), std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+    if (file.is_regular_file() && bytes.find("\x7f" "ELF") == bytes.npos) {
+      std::filesystem::remove(file.path());
+      break;
+    }
+  }
+  hiprtc_check(hiprtcGetDiskCacheStats(&stats));
+  auto hits = stats.hits, stores = stats.stores;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  check(hiprtcGetBitcodeSize(prog, &bitcode_size) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+  size_t code_size = 0;
+  hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+  std::vector<char> code(code_size, 0);
+  hiprtc_check(hiprtcGetCode(prog, code.data()));
+  check(code == first);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  hiprtc_check(hiprtcGetDiskCacheStats(&stats));
+  check(stats.hits == hits + 1 && stats.stores == stores);
+
+  hiprtc_check(hiprtcSetDiskCache(nullptr, 0));
+  std::filesystem::remove_all(cache_dir);
+}
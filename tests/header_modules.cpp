@@ -0,0 +1,77 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <string>
+
+const char *header = "inline float root(float x) { return sqrtf(x); }";
+const char *header_name = "root.h";
+
+hiprtcResult compile(const std::string &source, const char *option,
+                     size_t *cache_hits = nullptr, std::string *log = nullptr,
+                     bool with_header = false) {
+  hiprtcProgram prog;
+  hiprtc_check(hiprtcCreateProgram(&prog, source.c_str(), nullptr,
+                                   with_header ? 1 : 0, &header,
+                                   &header_name));
+  auto res = hiprtcCompileProgram(prog, option != nullptr ? 1 : 0,
+                                  option != nullptr ? &option : nullptr);
+  if (cache_hits != nullptr) {
+    hiprtcProgramStats stats{};
+    stats.struct_size = sizeof(stats);
+    hiprtc_check(hiprtcGetProgramStats(prog, &stats));
+    *cache_hits = stats.cache_hits;
+  }
+  if (log != nullptr) {
+    size_t log_size = 0;
+    hiprtc_check(hiprtcGetProgramLogSize(prog, &log_size));
+    log->resize(log_size);
+    hiprtc_check(hiprtcGetProgramLog(prog, log->data()));
+  }
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  return res;
+}
+
+int main() {
+  hiprtc_check(hiprtcSetDiskCache(nullptr, 0));
+  hiprtc_check(hiprtcFlushMemoryCache());
+
+  // Picked from the source, or named
+  std::string source =
+      "extern \"C\" __global__ void kernel(float *a) { *a = sqrtf(*a); }";
+  check(compile(source, nullptr) == HIPRTC_SUCCESS);
+  check(compile(source, "--hiprtc-modules=math") == HIPRTC_SUCCESS);
+  check(compile(source, "--hiprtc-modules=math,atomics,warp") ==
+        HIPRTC_SUCCESS);
+  check(compile(source, "--hiprtc-modules=all") == HIPRTC_SUCCESS);
+
+  // Modules are part of what is cached
+  size_t cache_hits = 0;
+  check(compile(source, "--hiprtc-modules=core", &cache_hits) ==
+        HIPRTC_SUCCESS);
+  check(cache_hits == 0);
+  check(compile(source, "--hiprtc-modules=core", &cache_hits) ==
+        HIPRTC_SUCCESS);
+  check(cache_hits == 1);
+
+  // Headers count when the source includes them
+  std::string including =
+      "#include \"root.h\"\n"
+      "extern \"C\" __global__ void kernel(float *a) { *a = root(*a); }";
+  check(compile(including, nullptr, nullptr, nullptr, true) == HIPRTC_SUCCESS);
+  check(compile(including, "--hiprtc-modules=math", &cache_hits, nullptr,
+                true) == HIPRTC_SUCCESS);
+  check(cache_hits == 1);
+  std::string other =
+      "extern \"C\" __global__ void kernel(float *a) { *a = 1; }";
+  check(compile(other, nullptr, nullptr, nullptr, true) == HIPRTC_SUCCESS);
+  check(compile(other, "--hiprtc-modules=core", &cache_hits, nullptr, true) ==
+        HIPRTC_SUCCESS);
+  check(cache_hits == 1);
+
+  std::string log;
+  check(compile(source, "--hiprtc-modules=math,graphics", nullptr, &log) ==
+        HIPRTC_ERROR_INVALID_OPTION);
+  check(log.find("graphics") != std::string::npos);
+
+  hiprtc_check(hiprtcFlushMemoryCache());
+}
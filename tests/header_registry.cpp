@@ -0,0 +1,74 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <string>
+
+hiprtcResult compile(const std::string &source, int num_headers,
+                     const hiprtcHeader *headers, const char *plain_header,
+                     const char *plain_name) {
+  hiprtcProgram prog;
+  hiprtc_check(hiprtcCreateProgram(&prog, source.c_str(), nullptr,
+                                   plain_header != nullptr ? 1 : 0,
+                                   &plain_header, &plain_name));
+  hiprtc_check(hiprtcAddProgramHeaders(prog, num_headers, headers));
+  auto res = hiprtcCompileProgram(prog, 0, nullptr);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  return res;
+}
+
+int main() {
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+  hiprtc_check(hiprtcSetDiskCache(nullptr, 0));
+
+  // Same name and text are stored once
+  hiprtcHeader value, again, params, broken;
+  hiprtc_check(hiprtcRegisterHeader(&value, "value.h", "#define VALUE 10\n"));
+  hiprtc_check(hiprtcRegisterHeader(&again, "value.h", "#define VALUE 10\n"));
+  check(value == again);
+  hiprtc_check(hiprtcReleaseHeader(again));
+  hiprtc_check(hiprtcRegisterHeader(&params, "include/params.h",
+                                    "#include \"value.h\"\n"));
+  hiprtc_check(hiprtcRegisterHeader(&broken, "broken.h",
+                                    "#error not to be included\n"));
+  check(params != value);
+
+  check(hiprtcRegisterHeader(nullptr, "a.h", "") ==
+        HIPRTC_ERROR_INVALID_INPUT);
+  check(hiprtcReleaseHeader(nullptr) == HIPRTC_ERROR_INVALID_INPUT);
+
+  // value.h is reached through params.h, broken.h is never reached
+  std::string source = "#include \"params.h\"\n"
+                       "extern \"C\" __global__ void kernel(int *a) {\n"
+                       "  *a = VALUE;\n"
+                       "}\n";
+  hiprtcHeader headers[] = {params, value, broken};
+  check(compile(source, 3, headers, nullptr, nullptr) == HIPRTC_SUCCESS);
+  check(compile(source, 3, headers, "#error not to be included\n",
+                "unused.h") == HIPRTC_SUCCESS);
+  check(compile("#include \"broken.h\"\n" + source, 3, headers, nullptr,
+                nullptr) == HIPRTC_ERROR_COMPILATION);
+  check(compile("#include \"unused.h\"\n" + source, 3, headers,
+                "#error not to be included\n",
+                "unused.h") == HIPRTC_ERROR_COMPILATION);
+
+  // A program keeps its headers past their release
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcAddProgramHeaders(prog, 2, headers));
+  hiprtc_check(hiprtcReleaseHeader(params));
+  hiprtc_check(hiprtcReleaseHeader(value));
+  check(hiprtcReleaseHeader(value) == HIPRTC_ERROR_INVALID_INPUT);
+  check(hiprtcAddProgramHeaders(prog, 1, &value) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+
+  hiprtcProgramStats stats{};
+  stats.struct_size = sizeof(stats);
+  hiprtc_check(hiprtcGetProgramStats(prog, &stats));
+  check(stats.header_bytes == std::string("#include \"value.h\"\n").size() +
+                                  std::string("#define VALUE 10\n").size());
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  hiprtc_check(hiprtcReleaseHeader(broken));
+}
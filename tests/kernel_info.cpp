@@ -0,0 +1,65 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <cstddef>
+#include <string>
+
+int main() {
+  const char *source = "extern \"C\" __global__ void scale(float *out, int n, "
+                       "double factor) { *out *= factor * n; }";
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+
+  hiprtcKernelInfo info{};
+  info.struct_size = sizeof(info);
+  check(hiprtcGetKernelInfo(prog, nullptr, "scale", &info) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+
+  const char *options[] = {"--offload-arch=gfx90a,gfx1100"};
+  hiprtc_check(hiprtcCompileProgram(prog, 1, options));
+
+  // Several targets, one has to be named
+  check(hiprtcGetKernelInfo(prog, nullptr, "scale", &info) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+  check(hiprtcGetKernelInfo(prog, "gfx942", "scale", &info) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+  check(hiprtcGetKernelInfo(prog, "gfx90a", "missing", &info) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+
+  hiprtc_check(hiprtcGetKernelInfo(prog, "gfx90a", "scale", &info));
+  check(info.struct_size == sizeof(info));
+  check(std::string(info.name) == "scale");
+  check(std::string(info.symbol) == "scale.kd");
+  check(info.vgpr_count != 0 && info.sgpr_count != 0);
+  check(info.max_flat_workgroup_size != 0);
+  check(info.wavefront_size == 64);
+  check(info.kernarg_size >= 24 && info.kernarg_align != 0);
+
+  // Arguments in kernarg order, then hidden ones
+  check(info.num_args >= 3 && info.args != nullptr);
+  check(std::string(info.args[0].name) == "out");
+  check(std::string(info.args[0].value_kind) == "global_buffer");
+  check(info.args[0].offset == 0 && info.args[0].size == 8);
+  check(std::string(info.args[1].value_kind) == "by_value");
+  check(info.args[1].offset == 8 && info.args[1].size == 4);
+  check(info.args[2].offset == 16 && info.args[2].size == 8);
+  for (size_t i = 1; i < info.num_args; i++) {
+    check(info.args[i].offset >= info.args[i - 1].offset);
+  }
+
+  // Descriptor symbol works as well, per target values
+  hiprtcKernelInfo other{};
+  other.struct_size = sizeof(other);
+  hiprtc_check(hiprtcGetKernelInfo(prog, "gfx1100", "scale.kd", &other));
+  check(other.wavefront_size == 32 || other.wavefront_size == 64);
+
+  // Caller built against an older header only gets the prefix it knows
+  hiprtcKernelInfo prefix{};
+  prefix.struct_size = offsetof(hiprtcKernelInfo, vgpr_count);
+  prefix.vgpr_count = 12345;
+  hiprtc_check(hiprtcGetKernelInfo(prog, "gfx90a", "scale", &prefix));
+  check(prefix.name != nullptr && prefix.vgpr_count == 12345);
+
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+}
@@ -0,0 +1,82 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Compile source and return its code or bitcode
+std::vector<char> compile(const char *source, int num_options,
+                          const char **options, bool bitcode) {
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(prog, num_options, options));
+
+  size_t size = 0;
+  std::vector<char> out;
+  if (bitcode) {
+    hiprtc_check(hiprtcGetBitcodeSize(prog, &size));
+    out.resize(size);
+    hiprtc_check(hiprtcGetBitcode(prog, out.data()));
+  } else {
+    hiprtc_check(hiprtcGetCodeSize(prog, &size));
+    out.resize(size);
+    hiprtc_check(hiprtcGetCode(prog, out.data()));
+  }
+
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  return out;
+}
+
+int main() {
+  const char *library = "__device__ int square(int x) { return x * x; }\n"
+                        "extern \"C\" __global__ void lib_kernel(int *a) {}";
+  const char *kernel = "__device__ int square(int x);\n"
+                       "extern \"C\" __global__ void kernel(int *a) { "
+                       "*a = square(*a); }";
+  const char *options[] = {"--offload-arch=gfx90a", "-fgpu-rdc"};
+
+  // Library precompiled once to a relocatable, kernel linked as bitcode
+  auto library_code = compile(library, 2, options, false);
+  auto kernel_bitcode = compile(kernel, 2, options, true);
+  check(!library_code.empty() && !kernel_bitcode.empty());
+
+  auto library_path =
+      std::filesystem::temp_directory_path() / "hiprtc_link_test.o";
+  {
+    std::ofstream file(library_path, std::ios::binary);
+    file.write(library_code.data(), library_code.size());
+  }
+
+  hiprtcLinkState state;
+  hiprtc_check(hiprtcLinkCreate(&state, 1, options));
+  hiprtc_check(hiprtcLinkAddFile(state, HIPRTC_LINK_INPUT_RELOCATABLE,
+                                 library_path.c_str()));
+  hiprtc_check(hiprtcLinkAddData(state, HIPRTC_LINK_INPUT_BITCODE,
+                                 kernel_bitcode.data(), kernel_bitcode.size(),
+                                 "kernel.bc"));
+  check(hiprtcLinkAddFile(state, HIPRTC_LINK_INPUT_RELOCATABLE,
+                          "/nonexistent/file.o") == HIPRTC_ERROR_INVALID_INPUT);
+
+  void *code = nullptr;
+  size_t code_size = 0;
+  hiprtc_check(hiprtcLinkComplete(state, &code, &code_size));
+  check(code != nullptr && code_size != 0);
+
+  // Linked state takes no more inputs
+  check(hiprtcLinkAddData(state, HIPRTC_LINK_INPUT_BITCODE,
+                          kernel_bitcode.data(), kernel_bitcode.size(),
+                          nullptr) == HIPRTC_ERROR_INVALID_INPUT);
+  hiprtc_check(hiprtcLinkDestroy(&state));
+  std::filesystem::remove(library_path);
+
+  // Nothing to link
+  hiprtc_check(hiprtcLinkCreate(&state, 1, options));
+  check(hiprtcLinkComplete(state, &code, &code_size) == HIPRTC_ERROR_LINKING);
+  size_t log_size = 0;
+  hiprtc_check(hiprtcGetLinkLogSize(state, &log_size));
+  check(log_size != 0);
+  hiprtc_check(hiprtcLinkDestroy(&state));
+}
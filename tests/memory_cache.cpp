@@ -0,0 +1,40 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <string>
+
+void compile(const std::string &source) {
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+}
+
+int main() {
+  std::string source =
+      "extern \"C\" __global__ void kernel(int *a) { *a = 10; }";
+  hiprtcMemoryCacheStats stats;
+
+  // Shared between program handles, bitcode and code object are separate
+  // entries
+  hiprtc_check(hiprtcFlushMemoryCache());
+  compile(source);
+  compile(source);
+  hiprtc_check(hiprtcGetMemoryCacheStats(&stats));
+  check(stats.misses == 2);
+  check(stats.hits == 1);
+  check(stats.entries == 2);
+  check(stats.size != 0 && stats.size <= stats.limit);
+
+  hiprtc_check(hiprtcFlushMemoryCache());
+  hiprtc_check(hiprtcGetMemoryCacheStats(&stats));
+  check(stats.entries == 0);
+  check(stats.size == 0);
+
+  // Budget too small to hold anything
+  hiprtc_check(hiprtcSetMemoryCacheLimit(1));
+  compile(source);
+  hiprtc_check(hiprtcGetMemoryCacheStats(&stats));
+  check(stats.entries == 0);
+}
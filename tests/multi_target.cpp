@@ -0,0 +1,57 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+int main() {
+  const char *source = "extern \"C\" __global__ void kernel(int *a) { *a = 1; }";
+
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+
+  const char *options[] = {"--offload-arch=gfx90a",
+                           "--offload-arch=gfx1100,gfx90a"};
+  hiprtc_check(hiprtcCompileProgram(prog, 2, options));
+
+  // Several targets end up in an offload bundle
+  size_t code_size = 0;
+  hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+  std::vector<char> code(code_size);
+  hiprtc_check(hiprtcGetCode(prog, code.data()));
+  const char magic[] = "__CLANG_OFFLOAD_BUNDLE__";
+  check(code_size > sizeof(magic) - 1);
+  check(std::memcmp(code.data(), magic, sizeof(magic) - 1) == 0);
+
+  for (const char *target : {"gfx90a", "gfx1100"}) {
+    size_t target_size = 0;
+    hiprtc_check(hiprtcGetTargetCodeSize(prog, target, &target_size));
+    check(target_size != 0);
+    std::vector<char> target_code(target_size);
+    hiprtc_check(hiprtcGetTargetCode(prog, target, target_code.data()));
+  }
+
+  size_t unused = 0;
+  check(hiprtcGetTargetCodeSize(prog, "gfx942", &unused) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // A single target gets a plain code object
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(prog, 1, options));
+  hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+  size_t target_size = 0;
+  hiprtc_check(hiprtcGetTargetCodeSize(prog, "gfx90a", &target_size));
+  check(code_size == target_size);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  const char *invalid[] = {"--offload-arch=gfx90a,sm_80"};
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+  check(hiprtcCompileProgram(prog, 1, invalid) == HIPRTC_ERROR_INVALID_OPTION);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+}
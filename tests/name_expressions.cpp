@@ -0,0 +1,67 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main() {
+#ifdef HIPRTC_TEST_MOCK
+  // Names are lowered from the symbol and relocation tables of the mock code
+  // objects only, comgr can not map them
+  setenv("HIPRTC_MOCK_NO_NAME_MAP", "1", 1);
+#endif
+
+  const char *source = "template <int N> __global__ void kernel(int *a) { "
+                       "*a = N; }";
+  constexpr int num_names = 100;
+
+  std::vector<std::string> names;
+  for (int i = 0; i < num_names; i++) {
+    names.push_back("kernel<" + std::to_string(i) + ">");
+  }
+  std::vector<const char *> name_ptrs;
+  for (auto &name : names) {
+    name_ptrs.push_back(name.c_str());
+  }
+
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcAddNameExpressions(prog, num_names, name_ptrs.data()));
+  // Duplicates are tracked once, single and bulk registration mix
+  hiprtc_check(hiprtcAddNameExpression(prog, name_ptrs[0]));
+  hiprtc_check(hiprtcAddNameExpressions(prog, 2, name_ptrs.data()));
+  check(hiprtcAddNameExpressions(prog, 1, nullptr) ==
+        HIPRTC_ERROR_NAME_EXPRESSION_NOT_VALID);
+
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  check(hiprtcAddNameExpression(prog, "kernel<1000>") ==
+        HIPRTC_ERROR_INVALID_INPUT);
+
+  auto check_lowered = [&] {
+    for (auto &name : names) {
+      const char *lowered = nullptr;
+      hiprtc_check(hiprtcGetLoweredName(prog, name.c_str(), &lowered));
+      check(lowered != nullptr && lowered[0] != '\0');
+#ifdef HIPRTC_TEST_MOCK
+      check(lowered == "_Z" + std::to_string(name.size()) + name + "v");
+#endif
+    }
+  };
+  check_lowered();
+
+  const char *lowered = nullptr;
+  check(hiprtcGetLoweredName(prog, "kernel<1000>", &lowered) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // Relocatable, functions in sections of their own all sit at offset 0
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcAddNameExpressions(prog, num_names, name_ptrs.data()));
+  const char *rdc = "-fgpu-rdc";
+  hiprtc_check(hiprtcCompileProgram(prog, 1, &rdc));
+  check_lowered();
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+}
@@ -0,0 +1,119 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <cstddef>
+
+int main() {
+  const char *source =
+      "extern \"C\" __global__ void scale(float *out, int n) { *out *= n; }\n"
+      "extern \"C\" __global__ void tile(float *out) {\n"
+      "  __shared__ float data[256];\n"
+      "  data[threadIdx.x] = *out;\n"
+      "  *out = data[0];\n"
+      "}";
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+
+  hiprtcOccupancy occupancy{};
+  occupancy.struct_size = sizeof(occupancy);
+  check(hiprtcEstimateOccupancy(prog, "scale", 256, 0, nullptr,
+                                &occupancy) == HIPRTC_ERROR_INVALID_INPUT);
+
+  const char *options[] = {
+      "--offload-arch=gfx906,gfx1010,gfx1100,gfx90a,gfx803"};
+  hiprtc_check(hiprtcCompileProgram(prog, 1, options));
+
+  // gfx906 fits 256 VGPRs per lane, 32 per wave leave room for 8 waves
+  hiprtc_check(
+      hiprtcEstimateOccupancy(prog, "scale", 256, 0, "gfx906", &occupancy));
+  check(occupancy.struct_size == sizeof(occupancy));
+  check(occupancy.max_waves_per_simd == 10);
+  check(occupancy.waves_per_simd == 8);
+  check(occupancy.workgroups_per_cu == 8);
+  check(occupancy.limit == HIPRTC_OCCUPANCY_LIMIT_VGPRS);
+  check(occupancy.suggested_block_size == 1024);
+  check(occupancy.suggested_waves_per_simd == 8);
+
+  // Static and dynamic LDS, 17 KiB per block leave room for 3 of them
+  hiprtc_check(hiprtcEstimateOccupancy(prog, "tile", 256, 16384, "gfx906",
+                                       &occupancy));
+  check(occupancy.workgroups_per_cu == 3);
+  check(occupancy.waves_per_simd == 3);
+  check(occupancy.limit == HIPRTC_OCCUPANCY_LIMIT_LDS);
+  check(occupancy.suggested_block_size == 1024);
+  check(occupancy.suggested_waves_per_simd == 8);
+
+  // Wave32 with the larger register file of gfx1100 is bound by wave slots
+  hiprtc_check(
+      hiprtcEstimateOccupancy(prog, "scale", 256, 0, "gfx1100", &occupancy));
+  check(occupancy.max_waves_per_simd == 16);
+  check(occupancy.waves_per_simd == 16);
+  check(occupancy.workgroups_per_cu == 4);
+  check(occupancy.limit == HIPRTC_OCCUPANCY_LIMIT_WAVES);
+
+  // Many small blocks run out of barriers, single wave ones need none
+  hiprtc_check(
+      hiprtcEstimateOccupancy(prog, "scale", 64, 0, "gfx1010", &occupancy));
+  check(occupancy.workgroups_per_cu == 16);
+  check(occupancy.waves_per_simd == 16);
+  check(occupancy.limit == HIPRTC_OCCUPANCY_LIMIT_WORKGROUPS);
+  hiprtc_check(
+      hiprtcEstimateOccupancy(prog, "scale", 32, 0, "gfx1010", &occupancy));
+  check(occupancy.workgroups_per_cu == 40);
+  check(occupancy.waves_per_simd == 20);
+
+  // Without a target, the one of the device, the mock reports a gfx90a
+  hiprtc_check(
+      hiprtcEstimateOccupancy(prog, "scale", 256, 0, nullptr, &occupancy));
+  check(occupancy.max_waves_per_simd == 8);
+
+  // Blocks that can not launch, unknown kernel, target or processor
+  check(hiprtcEstimateOccupancy(prog, "scale", 0, 0, "gfx906", &occupancy) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+  check(hiprtcEstimateOccupancy(prog, "scale", 2048, 0, "gfx906",
+                                &occupancy) == HIPRTC_ERROR_INVALID_INPUT);
+  check(hiprtcEstimateOccupancy(prog, "tile", 256, 65536, "gfx906",
+                                &occupancy) == HIPRTC_ERROR_INVALID_INPUT);
+  check(hiprtcEstimateOccupancy(prog, "missing", 256, 0, "gfx906",
+                                &occupancy) == HIPRTC_ERROR_INVALID_INPUT);
+  check(hiprtcEstimateOccupancy(prog, "scale", 256, 0, "gfx942",
+                                &occupancy) == HIPRTC_ERROR_INVALID_INPUT);
+  check(hiprtcEstimateOccupancy(prog, "scale", 256, 0, "gfx803",
+                                &occupancy) == HIPRTC_ERROR_INVALID_INPUT);
+
+  // Caller built against an older header only gets the prefix it knows
+  hiprtcOccupancy prefix{};
+  prefix.struct_size = offsetof(hiprtcOccupancy, workgroups_per_cu);
+  prefix.workgroups_per_cu = 12345;
+  hiprtc_check(
+      hiprtcEstimateOccupancy(prog, "scale", 256, 0, "gfx906", &prefix));
+  check(prefix.waves_per_simd == 8 && prefix.workgroups_per_cu == 12345);
+
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+#ifdef HIPRTC_TEST_MOCK
+  // Mock mfma kernels take 64 AGPRs, gfx90a reports them in the 96 VGPRs
+  const char *mfma_source =
+      "typedef float float32 __attribute__((ext_vector_type(32)));\n"
+      "extern \"C\" __global__ void mma(float *out) {\n"
+      "  float32 acc = {};\n"
+      "  acc = __builtin_amdgcn_mfma_f32_32x32x1f32(1.0f, 1.0f, acc, 0, 0, "
+      "0);\n"
+      "  *out = acc[0];\n"
+      "}";
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, mfma_source, nullptr, 0, nullptr, nullptr));
+  const char *gfx90a[] = {"--offload-arch=gfx90a"};
+  hiprtc_check(hiprtcCompileProgram(prog, 1, gfx90a));
+  hiprtcKernelInfo info{};
+  info.struct_size = sizeof(info);
+  hiprtc_check(hiprtcGetKernelInfo(prog, "gfx90a", "mma", &info));
+  check(info.vgpr_count == 96 && info.agpr_count == 64);
+  hiprtc_check(
+      hiprtcEstimateOccupancy(prog, "mma", 256, 0, "gfx90a", &occupancy));
+  check(occupancy.waves_per_simd == 5);
+  check(occupancy.limit == HIPRTC_OCCUPANCY_LIMIT_VGPRS);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+#endif
+}
@@ -0,0 +1,82 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+std::vector<char> get_code(hiprtcProgram prog) {
+  size_t code_size = 0;
+  hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+  std::vector<char> code(code_size);
+  hiprtc_check(hiprtcGetCode(prog, code.data()));
+  return code;
+}
+
+int main() {
+  // Memory cache off, every program is compiled from its own source
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+
+  const std::string source =
+      "#include \"value.h\"\n"
+      "extern \"C\" __global__ void kernel(int *a) { *a = VALUE; }";
+  const char *header = "#define VALUE 4\n";
+  const char *include_name = "value.h";
+
+  hiprtcProgram prog;
+  hiprtc_check(hiprtcCreateProgram(&prog, source.c_str(), "kernel.cu", 1,
+                                   &header, &include_name));
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  auto expected = get_code(prog);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // Borrowed buffer, not null terminated
+  std::string padded = source + "garbage";
+  hiprtc_check(hiprtcCreateProgramBorrowed(&prog, padded.data(), source.size(),
+                                           "kernel.cu", 1, &header,
+                                           &include_name));
+  check(hiprtcAppendProgramSource(prog, "\n", 1) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  check(get_code(prog) == expected);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // Mapped file
+  auto path = std::filesystem::temp_directory_path() / "kernel.cu";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << source;
+  }
+  hiprtc_check(hiprtcCreateProgramFromFile(&prog, path.c_str(), nullptr, 1,
+                                           &header, &include_name));
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  check(get_code(prog) == expected);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // A small file is copied, truncating it does not affect the program
+  hiprtc_check(hiprtcCreateProgramFromFile(&prog, path.c_str(), nullptr, 1,
+                                           &header, &include_name));
+  std::filesystem::resize_file(path, 0);
+  check(hiprtcAppendProgramSource(prog, "\n", 1) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  check(get_code(prog) == expected);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  std::filesystem::remove(path);
+  check(hiprtcCreateProgramFromFile(&prog, path.c_str(), nullptr, 0, nullptr,
+                                    nullptr) == HIPRTC_ERROR_INVALID_INPUT);
+
+  // Streamed in chunks
+  hiprtc_check(hiprtcCreateProgram(&prog, "", "kernel.cu", 1, &header,
+                                   &include_name));
+  for (size_t pos = 0; pos < source.size(); pos += 7) {
+    auto chunk = source.substr(pos, 7);
+    hiprtc_check(hiprtcAppendProgramSource(prog, chunk.data(), chunk.size()));
+  }
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  check(get_code(prog) == expected);
+  check(hiprtcAppendProgramSource(prog, "\n", 1) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+}
@@ -0,0 +1,62 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <cstddef>
+#include <string>
+
+hiprtcProgram compile(const std::string &source, int num_options,
+                      const char **options) {
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  hiprtc_check(hiprtcCompileProgram(prog, num_options, options));
+  return prog;
+}
+
+int main() {
+  std::string source =
+      "extern \"C\" __global__ void kernel(int *a) { *a = 10; }";
+  hiprtc_check(hiprtcFlushMemoryCache());
+
+  hiprtcProgramStats stats{};
+  auto prog = compile(source, 0, nullptr);
+  check(hiprtcGetProgramStats(prog, &stats) == HIPRTC_ERROR_INVALID_INPUT);
+
+  stats.struct_size = sizeof(stats);
+  hiprtc_check(hiprtcGetProgramStats(prog, &stats));
+  check(stats.struct_size == sizeof(stats));
+  check(stats.total_ms > 0);
+  check(stats.frontend_ms > 0 && stats.frontend_ms <= stats.total_ms);
+  check(stats.codegen_ms > 0 && stats.link_ms > 0);
+  check(stats.source_bytes == source.size());
+  check(stats.bitcode_bytes != 0);
+  check(stats.cache_hits == 0);
+
+  size_t code_size = 0;
+  hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+  check(stats.object_bytes == code_size);
+
+  // Caller built against an older header only gets the prefix it knows
+  hiprtcProgramStats prefix{};
+  prefix.struct_size = offsetof(hiprtcProgramStats, target_ms);
+  prefix.target_ms = -1;
+  hiprtc_check(hiprtcGetProgramStats(prog, &prefix));
+  check(prefix.total_ms > 0 && prefix.target_ms == -1);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // Same source again is served by the code object cache
+  prog = compile(source, 0, nullptr);
+  hiprtc_check(hiprtcGetProgramStats(prog, &stats));
+  check(stats.cache_hits == 1);
+  check(stats.frontend_ms == 0 && stats.codegen_ms == 0);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // Time report bypasses the caches
+  const char *options[] = {"-ftime-trace"};
+  prog = compile(source, 1, options);
+  hiprtc_check(hiprtcGetProgramStats(prog, &stats));
+  check(stats.cache_hits == 0 && stats.frontend_ms > 0);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  hiprtc_check(hiprtcFlushMemoryCache());
+}
@@ -0,0 +1,85 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+std::vector<char> get_code(hiprtcProgram prog) {
+  size_t code_size = 0;
+  hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+  std::vector<char> code(code_size);
+  hiprtc_check(hiprtcGetCode(prog, code.data()));
+  return code;
+}
+
+hiprtcProgramStats compile(hiprtcProgram prog,
+                           std::vector<const char *> options) {
+  hiprtc_check(hiprtcCompileProgram(
+      prog, options.size(), options.empty() ? nullptr : options.data()));
+  hiprtcProgramStats stats{};
+  stats.struct_size = sizeof(stats);
+  hiprtc_check(hiprtcGetProgramStats(prog, &stats));
+  return stats;
+}
+
+int main() {
+  // Reuse comes from the program itself, not the caches
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+
+  std::string source =
+      "extern \"C\" __global__ void kernel(int *a) { *a = VALUE; }";
+  hiprtcProgram prog;
+  hiprtc_check(hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr,
+                                   nullptr));
+
+  auto stats = compile(prog, {"-DVALUE=1"});
+  check(stats.cache_hits == 0 && stats.bitcode_cache_hits == 0);
+  const void *first_code = nullptr;
+  size_t first_size = 0;
+  hiprtc_check(hiprtcGetCodePtr(prog, &first_code, &first_size));
+
+  // Only code generation changes, the front end output is reused
+  stats = compile(prog, {"-DVALUE=1", "-O1"});
+  check(stats.cache_hits == 0 && stats.bitcode_cache_hits == 1);
+  check(stats.frontend_ms == 0 && stats.codegen_ms > 0);
+
+  // Macros change, the program is compiled again. The header never mentions
+  // VALUE, its precompiled form is shared and the code is the same as without
+  stats = compile(prog, {"-DVALUE=2"});
+  check(stats.cache_hits == 0 && stats.bitcode_cache_hits == 0);
+  check(stats.pch_hits == 1);
+  auto code_with_pch = get_code(prog);
+  setenv("HIPRTC_DISABLE_PCH", "1", 1);
+  hiprtcProgram plain;
+  hiprtc_check(hiprtcCreateProgram(&plain, source.c_str(), nullptr, 0,
+                                   nullptr, nullptr));
+  stats = compile(plain, {"-DVALUE=2"});
+  check(stats.pch_hits == 0 && get_code(plain) == code_with_pch);
+  hiprtc_check(hiprtcDestroyProgram(&plain));
+  unsetenv("HIPRTC_DISABLE_PCH");
+
+  // A macro the header uses goes in a precompiled header of its own
+  stats = compile(prog, {"-DVALUE=2", "-U__launch_bounds__"});
+  check(stats.pch_hits == 0);
+  stats = compile(prog, {"-DVALUE=3", "-U__launch_bounds__"});
+  check(stats.pch_hits == 1);
+
+  // Every variant is kept, going back to one is free
+  stats = compile(prog, {"-DVALUE=1"});
+  check(stats.cache_hits == 1 && stats.frontend_ms == 0);
+  const void *code = nullptr;
+  size_t code_size = 0;
+  hiprtc_check(hiprtcGetCodePtr(prog, &code, &code_size));
+  check(code == first_code && code_size == first_size);
+
+  // A failed recompile leaves a program that compiles again
+  std::vector<const char *> bad = {"--bogus"};
+  check(hiprtcCompileProgram(prog, 1, bad.data()) ==
+        HIPRTC_ERROR_INVALID_OPTION);
+  stats = compile(prog, {"-DVALUE=2"});
+  check(stats.cache_hits == 1);
+
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  hiprtc_check(hiprtcSetMemoryCacheLimit(128 << 20));
+}
@@ -0,0 +1,85 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <string>
+
+int main() {
+  const char *source = "template <int TILE, typename T> __global__ void "
+                       "scale(T *a) { *a *= TILE; }";
+  hiprtc_check(hiprtcFlushMemoryCache());
+
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source, nullptr, 0, nullptr, nullptr));
+
+  const char *lowered = nullptr;
+  const void *code = nullptr;
+  size_t code_size = 0;
+  const char *values[] = {"64", "float"};
+  check(hiprtcSpecializeKernel(prog, "scale", 2, values, 0, nullptr, &lowered,
+                               &code, &code_size) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+
+  const char *params[] = {"TILE", "T"};
+  hiprtc_check(hiprtcAddSpecializationParameters(prog, "scale", 2, params));
+  check(hiprtcSpecializeKernel(prog, "scale", 1, values, 0, nullptr, &lowered,
+                               &code, &code_size) ==
+        HIPRTC_ERROR_INVALID_INPUT);
+
+  hiprtc_check(hiprtcSpecializeKernel(prog, "scale", 2, values, 0, nullptr,
+                                      &lowered, &code, &code_size));
+  check(lowered != nullptr && lowered[0] != '\0');
+  check(code != nullptr && code_size != 0);
+
+  // Repeats are served from the program, same name and code
+  hiprtcMemoryCacheStats before{}, after{};
+  hiprtc_check(hiprtcGetMemoryCacheStats(&before));
+  const char *lowered_again = nullptr;
+  const void *code_again = nullptr;
+  size_t code_size_again = 0;
+  hiprtc_check(hiprtcSpecializeKernel(prog, "scale", 2, values, 0, nullptr,
+                                      &lowered_again, &code_again,
+                                      &code_size_again));
+  hiprtc_check(hiprtcGetMemoryCacheStats(&after));
+  check(lowered_again == lowered && code_again == code);
+  check(after.hits == before.hits && after.misses == before.misses);
+
+  // So are the same options spelled differently
+  const char *options[] = {"-DA=1", "-ffast-math"};
+  const char *respelled[] = {"-ffast-math", "-D", "A=1", "-DA=1"};
+  hiprtc_check(hiprtcSpecializeKernel(prog, "scale", 2, values, 2, options,
+                                      &lowered, &code, &code_size));
+  hiprtc_check(hiprtcGetMemoryCacheStats(&before));
+  hiprtc_check(hiprtcSpecializeKernel(prog, "scale", 2, values, 4, respelled,
+                                      &lowered_again, &code_again,
+                                      &code_size_again));
+  hiprtc_check(hiprtcGetMemoryCacheStats(&after));
+  check(lowered_again == lowered && code_again == code);
+  check(after.hits == before.hits && after.misses == before.misses);
+
+  // Other values are another instantiation
+  const char *other[] = {"32", "float"};
+  const char *lowered_other = nullptr;
+  hiprtc_check(hiprtcSpecializeKernel(prog, "scale", 2, other, 0, nullptr,
+                                      &lowered_other, &code_again,
+                                      &code_size_again));
+  check(std::string(lowered_other) != lowered);
+
+  // Program itself is untouched and still compiles
+  hiprtc_check(hiprtcCompileProgram(prog, 0, nullptr));
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  // A failed instantiation fails with the log of its compilation
+  hiprtc_check(hiprtcCreateProgram(&prog, "#error broken", nullptr, 0, nullptr,
+                                   nullptr));
+  hiprtc_check(hiprtcAddSpecializationParameters(prog, "scale", 2, params));
+  check(hiprtcSpecializeKernel(prog, "scale", 2, values, 0, nullptr, &lowered,
+                               &code, &code_size) ==
+        HIPRTC_ERROR_COMPILATION);
+  size_t log_size = 0;
+  hiprtc_check(hiprtcGetProgramLogSize(prog, &log_size));
+  check(log_size > 1);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+
+  hiprtc_check(hiprtcFlushMemoryCache());
+}
@@ -0,0 +1,36 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <cstdlib>
+#include <string>
+
+hiprtcResult compile(const char *target_option) {
+  std::string source =
+      "extern \"C\" __global__ void kernel(int *a) { *a = 10; }";
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  auto res = (target_option != nullptr)
+                 ? hiprtcCompileProgram(prog, 1, &target_option)
+                 : hiprtcCompileProgram(prog, 0, nullptr);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  return res;
+}
+
+int main() {
+  // Explicit targets, no device needed
+  check(compile("--offload-arch=gfx90a") == HIPRTC_SUCCESS);
+  check(compile("--offload-arch=gfx90a:sramecc+:xnack-") == HIPRTC_SUCCESS);
+  check(compile("--gpu-architecture=gfx1100") == HIPRTC_SUCCESS);
+
+  check(compile("--offload-arch=sm_80") == HIPRTC_ERROR_INVALID_OPTION);
+  check(compile("--offload-arch=gfx90a:xnack+:xnack-") ==
+        HIPRTC_ERROR_INVALID_OPTION);
+  check(compile("--offload-arch=gfx90a:foo+") == HIPRTC_ERROR_INVALID_OPTION);
+
+  setenv("HIPRTC_TARGET", "gfx942", 1);
+  check(compile(nullptr) == HIPRTC_SUCCESS);
+  setenv("HIPRTC_TARGET", "not-a-target", 1);
+  check(compile(nullptr) == HIPRTC_ERROR_INVALID_OPTION);
+  unsetenv("HIPRTC_TARGET");
+}
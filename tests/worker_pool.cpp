@@ -0,0 +1,77 @@
+#include "common.hpp"
+#include "hip/hiprtc.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+std::vector<char> compile(const std::string &source, hiprtcResult expected) {
+  hiprtcProgram prog;
+  hiprtc_check(
+      hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0, nullptr, nullptr));
+  check(hiprtcCompileProgram(prog, 0, nullptr) == expected);
+
+  std::vector<char> code;
+  if (expected == HIPRTC_SUCCESS) {
+    size_t code_size = 0;
+    hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+    code.resize(code_size);
+    hiprtc_check(hiprtcGetCode(prog, code.data()));
+  }
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  return code;
+}
+
+int main() {
+  // Read on first compile
+  setenv("HIPRTC_WORKERS", "2", 1);
+  setenv("HIPRTC_WORKER_TIMEOUT_MS", "1000", 1);
+  hiprtc_check(hiprtcSetMemoryCacheLimit(0));
+  hiprtc_check(hiprtcSetDiskCache(nullptr, 0));
+
+  std::string source =
+      "extern \"C\" __global__ void kernel(int *a) { *a = 10; }";
+  auto code = compile(source, HIPRTC_SUCCESS);
+  check(!code.empty());
+  check(compile(source, HIPRTC_SUCCESS) == code);
+
+  // More programs than workers, they queue for one
+  const int count = 8;
+  std::vector<hiprtcProgram> progs(count);
+  for (auto &prog : progs) {
+    hiprtc_check(hiprtcCreateProgram(&prog, source.c_str(), nullptr, 0,
+                                     nullptr, nullptr));
+  }
+  hiprtc_check(hiprtcCompileProgramsBatch(progs.data(), count, 0, nullptr,
+                                          nullptr));
+  for (auto &prog : progs) {
+    size_t code_size = 0;
+    hiprtc_check(hiprtcGetCodeSize(prog, &code_size));
+    check(code_size == code.size());
+    hiprtc_check(hiprtcDestroyProgram(&prog));
+  }
+
+  // Errors are reported as from an in process compile
+  compile("#error invalid\nextern \"C\" __global__ void kernel() {}",
+          HIPRTC_ERROR_COMPILATION);
+
+  // A compiler crash only takes down its worker, which is replaced
+  compile("extern \"C\" __global__ void kernel() { __hiprtc_mock_crash__(); }",
+          HIPRTC_ERROR_COMPILATION);
+  check(compile(source, HIPRTC_SUCCESS) == code);
+
+  // So does one that hangs, once it is past the timeout
+  hiprtcProgram prog;
+  hiprtc_check(hiprtcCreateProgram(
+      &prog,
+      "extern \"C\" __global__ void kernel() { __hiprtc_mock_hang__(); }",
+      nullptr, 0, nullptr, nullptr));
+  check(hiprtcCompileProgram(prog, 0, nullptr) == HIPRTC_ERROR_COMPILATION);
+  size_t log_size = 0;
+  hiprtc_check(hiprtcGetProgramLogSize(prog, &log_size));
+  std::string log(log_size, '\0');
+  hiprtc_check(hiprtcGetProgramLog(prog, log.data()));
+  check(log.find("did not answer within 1000 ms") != std::string::npos);
+  hiprtc_check(hiprtcDestroyProgram(&prog));
+  check(compile(source, HIPRTC_SUCCESS) == code);
+}